@@ -0,0 +1,82 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_COMPILATIONSESSION_H_
+#define ZILLIANS_LANGUAGE_COMPILATIONSESSION_H_
+
+#include "core/Prerequisite.h"
+#include "language/GlobalContext.h"
+#include "language/tree/ASTNode.h"
+#include "language/stage/parser/SourceLineTable.h"
+#include <boost/noncopyable.hpp>
+
+namespace zillians { namespace language {
+
+/**
+ * CompilationSession owns the state of one compilation: the arena all AST nodes are allocated
+ * in, the table numbering the source files (SourceTable), and the contexts behind
+ * getParserContext(), getGeneratorContext() and getConfigurationContext()
+ *
+ * Give one to StageConductor::setSession() and the stages run within it, so several compilations
+ * (in-process ts-make jobs, a build server, a parallel test runner) can run in one process, one
+ * per thread. Everything the compilation created is destroyed along with the session.
+ *
+ * Identifier names (SymbolTable) stay process-wide and are shared by all sessions, the table is
+ * thread-safe. So is the compiler logger, which holds no state of a compilation and is set up
+ * before the first session starts.
+ */
+class CompilationSession : boost::noncopyable
+{
+public:
+	/**
+	 * Make the session the current one on the calling thread
+	 */
+	struct Scope : boost::noncopyable
+	{
+		explicit Scope(CompilationSession& session);
+		~Scope();
+
+	private:
+		CompilationSession* previous;
+		GlobalContext::Scope contexts_scope;
+		stage::SourceTable::Scope sources_scope;
+		tree::ASTNodeGC::Scope arena_scope;
+	};
+
+public:
+	CompilationSession();
+	~CompilationSession();
+
+public:
+	GlobalContext::Contexts& contexts()  { return hub; }
+	tree::ASTNodeGC& arena()             { return gc; }
+	stage::SourceTable& sources()        { return source_table; }
+
+	/// the session entered on the calling thread, NULL if there's none
+	static CompilationSession* current();
+
+private:
+	GlobalContext::Contexts hub;
+	stage::SourceTable source_table; // outlives the nodes locating themselves in it
+	tree::ASTNodeGC gc;
+};
+
+} }
+
+#endif /* ZILLIANS_LANGUAGE_COMPILATIONSESSION_H_ */
@@ -23,11 +23,49 @@
 #include "core/Prerequisite.h"
 #include "core/ContextHub.h"
 #include "core/Singleton.h"
+#include <boost/noncopyable.hpp>
 
 namespace zillians { namespace language {
 
 struct GlobalContext : ContextHub<ContextOwnership::transfer>, Singleton<GlobalContext, SingletonInitialization::automatic>
-{ };
+{
+	typedef ContextHub<ContextOwnership::transfer> Contexts;
+
+	/**
+	 * Redirects current() to the given hub on the calling thread, so that
+	 * several compilations may run side by side in one process, each with
+	 * its own parser/generator/configuration contexts (see CompilationSession).
+	 */
+	struct Scope : boost::noncopyable
+	{
+		explicit Scope(Contexts& contexts) : previous(active())
+		{
+			active() = &contexts;
+		}
+
+		~Scope()
+		{
+			active() = previous;
+		}
+
+	private:
+		Contexts* previous;
+	};
+
+	static Contexts& current()
+	{
+		if(active())
+			return *active();
+		return *instance();
+	}
+
+private:
+	static Contexts*& active()
+	{
+		static __thread Contexts* scoped = NULL;
+		return scoped;
+	}
+};
 
 } }
 
@@ -97,6 +97,7 @@ private:
     bool dumpGraphviz;
     std::string dumpGraphvizDir;
     std::string prepandPackage;
+    std::string preludePath;
 };
 
 } }
@@ -42,8 +42,7 @@ struct location
 #ifdef DEBUG
 		printf("location param(0) type = %s\n", typeid(_param_t(0)).name());
 #endif
-		getParserContext().debug.line   = _param(0).get_position().line;
-		getParserContext().debug.column = _param(0).get_position().column;
+		getParserContext().debug.position = _param(0).base();
 	}
 	END_ACTION
 };
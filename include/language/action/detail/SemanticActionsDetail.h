@@ -50,9 +50,7 @@
 			{ \
 				UNUSED_ARGUMENT(parser_attribute); \
 				UNUSED_ARGUMENT(context); \
-				UNUSED_ARGUMENT(passed); \
-				if(!getParserContext().enable_semantic_action) \
-					return;
+				UNUSED_ARGUMENT(passed);
 
 #define BEGIN_TEMPLATED_ACTION(name, ...) \
 		template<__VA_ARGS__> \
@@ -63,9 +61,7 @@
 			{ \
 				UNUSED_ARGUMENT(parser_attribute); \
 				UNUSED_ARGUMENT(context); \
-				UNUSED_ARGUMENT(passed); \
-				if(!getParserContext().enable_semantic_action) \
-					return;
+				UNUSED_ARGUMENT(passed);
 
 #define END_ACTION \
 			} \
@@ -91,19 +87,21 @@
 				getParserContext().debug.column))
 #endif
 
-#define LOCATION_TYPE shared_ptr<stage::SourceInfoContext> // _local(0)
+#define LOCATION_TYPE const char* // _local(0), the raw source position; bound as an offset, see SourceInfoContext::at()
 #define CACHE_LOCATION \
 		{ \
 			BOOST_MPL_ASSERT(( boost::is_same<_local_t(0), LOCATION_TYPE&> )); \
-			_local(0).reset(new stage::SourceInfoContext( \
-					getParserContext().debug.line, \
-					getParserContext().debug.column)); \
+			_local(0) = getParserContext().debug.position; \
 		}
 #define BIND_CACHED_LOCATION(x) \
 		{ \
 			BOOST_MPL_ASSERT(( boost::is_same<_local_t(0), LOCATION_TYPE&> )); \
 			if(_local(0)) \
-				stage::SourceInfoContext::set((x), new stage::SourceInfoContext(*(_local(0).get()))); \
+			{ \
+				stage::SourceInfoContext::set((x), stage::SourceInfoContext::at( \
+						getParserContext().debug.source_index, \
+						_local(0) - getParserContext().debug.source->data())); \
+			} \
 		}
 
 using namespace zillians::language::tree;
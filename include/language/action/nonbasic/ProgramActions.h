@@ -21,6 +21,7 @@
 #define ZILLIANS_LANGUAGE_ACTION_MODULE_PROGRAMACTIONS_H_
 
 #include "language/action/detail/SemanticActionsDetail.h"
+#include "language/stage/parser/context/SourceSpanContext.h"
 
 namespace zillians { namespace language { namespace action {
 
@@ -61,9 +62,21 @@ struct program
 	{
 #ifdef DEBUG
 		printf("program::append_global_decl param(0) type = %s\n", typeid(_param_t(0)).name());
+		printf("program::append_global_decl param(1) type = %s\n", typeid(_param_t(1)).name());
+		printf("program::append_global_decl param(2) type = %s\n", typeid(_param_t(2)).name());
 #endif
 		if(getParserContext().active_package)
-			getParserContext().active_package->addObject(_param(0));
+		{
+			getParserContext().active_package->addObject(_param(1));
+
+			// remember where the declaration lives so that it can be reparsed alone later on
+			const stage::SourceBuffer* source = getParserContext().debug.source;
+			if(source)
+			{
+				stage::SourceSpanContext::set(_param(1), stage::SourceSpanContext(
+						_param(0).base() - source->data(), _param(2).base() - source->data(), getParserContext().debug.source_index));
+			}
+		}
 	}
 	END_ACTION
 };
@@ -29,9 +29,12 @@ namespace zillians { namespace language {
 
 struct GeneratorContext
 {
-	GeneratorContext()
+	GeneratorContext() : context(NULL)
 	{ }
 
+	/// the generated modules go along with the context, which is deleted last
+	~GeneratorContext();
+
 	llvm::LLVMContext* context;
 	std::vector<llvm::Module*> modules;
 };
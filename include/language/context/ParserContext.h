@@ -23,16 +23,38 @@
 #include "core/Prerequisite.h"
 #include "language/tree/ASTNodeFactory.h"
 #include "language/GlobalContext.h"
+#include "language/stage/parser/SourceBuffer.h"
+#include <boost/noncopyable.hpp>
 
 namespace zillians { namespace language {
 
 struct ParserContext
 {
-	ParserContext() : enable_semantic_action(true), dump_rule_debug(false), tangle(new tree::Tangle), active_source(NULL), active_package(NULL)
-	{ }
+	/**
+	 * Make a context the one returned by getParserContext() on the calling thread, so that
+	 * several files can be parsed concurrently, each one into its own context
+	 */
+	struct Scope : boost::noncopyable
+	{
+		explicit Scope(ParserContext& context);
+		~Scope();
+
+		ParserContext* previous;
+	};
 
-	bool enable_semantic_action;
-	bool dump_rule_debug;
+	ParserContext() : tangle(new tree::Tangle), active_source(NULL), active_package(NULL)
+	{
+		debug.source = NULL;
+		debug.source_index = 0;
+		debug.position = NULL;
+	}
+
+	explicit ParserContext(tree::Tangle* tangle) : tangle(tangle), active_source(NULL), active_package(NULL)
+	{
+		debug.source = NULL;
+		debug.source_index = 0;
+		debug.position = NULL;
+	}
 
 	tree::Tangle* tangle;
 	tree::Source* active_source;
@@ -40,8 +62,9 @@ struct ParserContext
 
 	struct
 	{
-		uint32 line;
-		uint32 column;
+		const stage::SourceBuffer* source;
+		uint32 source_index;  // number of the source in SourceTable
+		const char* position; // stored as an offset into the source when a location is bound to a node
 	} debug;
 };
 
@@ -21,6 +21,7 @@
 #define ZILLIANS_LANGUAGE_RESOLVERCONTEXT_H_
 
 #include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
 
 namespace zillians { namespace language {
 
@@ -55,7 +56,7 @@ struct ResolvedType
 
 	static tree::ASTNode* get(tree::ASTNode* node)
 	{
-		ResolvedType* resolved = node->get<ResolvedType>();
+		ResolvedType* resolved = tree::NodeContextTable<ResolvedType>::get(node);
 		if(resolved)
 			return resolved->ref;
 		else
@@ -69,7 +70,7 @@ struct ResolvedType
 			BOOST_ASSERT(isValidResolvedType(ref) && "invalid resolved type");
 		}
 
-		return node->set<ResolvedType>(new ResolvedType(ref));
+		tree::NodeContextTable<ResolvedType>::assign(node, ResolvedType(ref));
 	}
 
     template<typename Archive>
@@ -113,7 +114,7 @@ struct InstantiatedFrom
 
 	static tree::ASTNode* get(tree::ASTNode* node)
 	{
-		InstantiatedFrom* resolved = node->get<InstantiatedFrom>();
+		InstantiatedFrom* resolved = tree::NodeContextTable<InstantiatedFrom>::get(node);
 		if(resolved)
 			return resolved->ref;
 		else
@@ -127,7 +128,7 @@ struct InstantiatedFrom
 			BOOST_ASSERT(isValid(ref) && "invalid resolved type");
 		}
 
-		return node->set<InstantiatedFrom>(new InstantiatedFrom(ref));
+		tree::NodeContextTable<InstantiatedFrom>::assign(node, InstantiatedFrom(ref));
 	}
 
     template<typename Archive>
@@ -171,7 +172,7 @@ struct SpecializationOf
 
 	static tree::ASTNode* get(tree::ASTNode* node)
 	{
-		SpecializationOf* resolved = node->get<SpecializationOf>();
+		SpecializationOf* resolved = tree::NodeContextTable<SpecializationOf>::get(node);
 		if(resolved)
 			return resolved->ref;
 		else
@@ -185,7 +186,7 @@ struct SpecializationOf
 			BOOST_ASSERT(isValid(ref) && "invalid resolved type");
 		}
 
-		return node->set<SpecializationOf>(new SpecializationOf(ref));
+		tree::NodeContextTable<SpecializationOf>::assign(node, SpecializationOf(ref));
 	}
 
     template<typename Archive>
@@ -254,7 +255,7 @@ struct ResolvedSymbol
 
 	static tree::ASTNode* get(tree::ASTNode* node)
 	{
-		ResolvedSymbol* resolved = node->get<ResolvedSymbol>();
+		ResolvedSymbol* resolved = tree::NodeContextTable<ResolvedSymbol>::get(node);
 		if(resolved)
 			return resolved->ref;
 		else
@@ -268,7 +269,7 @@ struct ResolvedSymbol
 			BOOST_ASSERT(isValidResolvedSymbol(ref) && "invalid resolved symbol");
 		}
 
-		return node->set<ResolvedSymbol>(new ResolvedSymbol(ref));
+		tree::NodeContextTable<ResolvedSymbol>::assign(node, ResolvedSymbol(ref));
 	}
 
     template<typename Archive>
@@ -319,7 +320,7 @@ struct ResolvedPackage
 
 	static tree::ASTNode* get(tree::ASTNode* node)
 	{
-		ResolvedPackage* resolved = node->get<ResolvedPackage>();
+		ResolvedPackage* resolved = tree::NodeContextTable<ResolvedPackage>::get(node);
 		if(resolved)
 			return resolved->ref;
 		else
@@ -328,7 +329,7 @@ struct ResolvedPackage
 
 	static void set(tree::ASTNode* node, tree::ASTNode* ref)
 	{
-		return node->set<ResolvedPackage>(new ResolvedPackage(ref));
+		tree::NodeContextTable<ResolvedPackage>::assign(node, ResolvedPackage(ref));
 	}
 
     template<typename Archive>
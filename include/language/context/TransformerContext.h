@@ -21,6 +21,7 @@
 #define ZILLIANS_LANGUAGE_TRANSFORMERCONTEXT_H_
 
 #include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
 
 namespace zillians { namespace language {
 
@@ -37,7 +38,7 @@ struct SplitReferenceContext
 
 	static tree::ASTNode* get(tree::ASTNode* node)
 	{
-		SplitReferenceContext* from = node->get<SplitReferenceContext>();
+		SplitReferenceContext* from = tree::NodeContextTable<SplitReferenceContext>::get(node);
 		if(from)
 			return from->ref;
 		else
@@ -46,7 +47,7 @@ struct SplitReferenceContext
 
 	static void set(tree::ASTNode* node, tree::ASTNode* ref)
 	{
-		return node->set<SplitReferenceContext>(new SplitReferenceContext(ref));
+		tree::NodeContextTable<SplitReferenceContext>::assign(node, SplitReferenceContext(ref));
 	}
 
     template<typename Archive>
@@ -38,7 +38,9 @@
 #include <boost/spirit/repository/include/qi_distinct.hpp>
 #include <boost/spirit/repository/include/qi_iter_pos.hpp>
 #include <boost/spirit/include/qi_omit.hpp>
+#include <boost/spirit/include/qi_no_skip.hpp>
 #include <boost/regex/pending/unicode_iterator.hpp>
+#include <unordered_set>
 #include "utility/UnicodeUtil.h"
 #include "language/tree/ASTNodeFactory.h"
 #include "language/context/ParserContext.h"
@@ -53,8 +55,7 @@
 #define INIT_RULE(x) \
 		{ \
 			x.name(#x); \
-			if(getParserContext().dump_rule_debug) \
-				debug(x); \
+			detail::RuleDebug<DebugRule>::enable(x); \
 		}
 
 namespace qi = boost::spirit::qi;
@@ -74,7 +75,31 @@ namespace zillians { namespace language { namespace grammar {
 
 namespace detail {
 
-template <typename Iterator, typename SA>
+/**
+ * Rule debugging is only wired up in the grammar instantiated for --debug-parser, the release
+ * grammar doesn't even instantiate the debug handlers
+ */
+template<bool Enabled>
+struct RuleDebug
+{
+	template<typename Rule>
+	static void enable(Rule& rule)
+	{
+		UNUSED_ARGUMENT(rule);
+	}
+};
+
+template<>
+struct RuleDebug<true>
+{
+	template<typename Rule>
+	static void enable(Rule& rule)
+	{
+		debug(rule);
+	}
+};
+
+template <typename Iterator, typename SA, bool DebugRule>
 struct Identifier : qi::grammar<Iterator, typename SA::identifier::attribute_type, typename SA::identifier::local_type>
 {
 	Identifier() : Identifier::base_type(identifier)
@@ -83,11 +108,27 @@ struct Identifier : qi::grammar<Iterator, typename SA::identifier::attribute_typ
 			= omit[ iter_pos[ typename SA::location::init() ] ]
 			;
 
-		keyword_sym =
+		// scan the whole word once and then look it up, instead of matching it against every
+		// keyword (plus a distinct check) before scanning it as an identifier again
+		word %= qi::lexeme[ (unicode::alpha | L'_') > *(unicode::alnum | L'_') ];
+
+		start %= word [ qi::_pass = !boost::phoenix::bind(&Identifier::isKeyword, qi::_1) ];
+
+		identifier
+			= location [ typename SA::location::cache_loc() ]
+				>> start [ typename SA::identifier::init() ]
+			;
+
+		INIT_RULE(identifier);
+	}
+
+	static bool isKeyword(const std::wstring& word)
+	{
+		static const std::unordered_set<std::wstring> keywords = {
 			L"void",
 			L"int8", L"int16", L"int32", L"int64",
 			L"float32", L"float64",
-			L"true", L"false", L"null", L"self", L"this", L"super", L"...",
+			L"true", L"false", L"null", L"self", L"this", L"super",
 			L"const", L"static",
 			L"typedef", L"class", L"interface", L"enum",
 			L"public", L"protected", L"private",
@@ -98,27 +139,18 @@ struct Identifier : qi::grammar<Iterator, typename SA::identifier::attribute_typ
 			L"break", L"continue", L"return",
 			L"new", L"as", L"instanceof",
 			L"module", L"import",
-			L"extends", L"implements";
-		keyword = DISTINCT_IDENTIFIER(keyword_sym);
-
-		start %= qi::lexeme[ ((unicode::alpha | L'_') > *(unicode::alnum | L'_')) - keyword ];
-
-		identifier
-			= location [ typename SA::location::cache_loc() ]
-				>> start [ typename SA::identifier::init() ]
-			;
-
-		INIT_RULE(identifier);
+			L"extends", L"implements"
+		};
+		return keywords.count(word) > 0;
 	}
 
 	DECL_RULE_LEXEME(location);
-	qi::symbols<wchar_t const> keyword_sym;
-	qi::rule<Iterator, std::wstring()> keyword;
+	qi::rule<Iterator, std::wstring()> word;
 	qi::rule<Iterator, std::wstring()> start;
 	DECL_RULE_LEXEME(identifier);
 };
 
-template <typename Iterator, typename SA>
+template <typename Iterator, typename SA, bool DebugRule>
 struct IntegerLiteral : qi::grammar<Iterator, typename SA::integer_literal::attribute_type, typename SA::integer_literal::local_type>
 {
 	IntegerLiteral() : IntegerLiteral::base_type(integer_literal)
@@ -145,7 +177,7 @@ struct IntegerLiteral : qi::grammar<Iterator, typename SA::integer_literal::attr
 	DECL_RULE_LEXEME(integer_literal);
 };
 
-template <typename Iterator, typename SA>
+template <typename Iterator, typename SA, bool DebugRule>
 struct FloatLiteral : qi::grammar<Iterator, typename SA::float_literal::attribute_type, typename SA::float_literal::local_type>
 {
 	FloatLiteral() : FloatLiteral::base_type(float_literal)
@@ -174,7 +206,7 @@ struct FloatLiteral : qi::grammar<Iterator, typename SA::float_literal::attribut
 	DECL_RULE_LEXEME(float_literal);
 };
 
-template <typename Iterator, typename SA>
+template <typename Iterator, typename SA, bool DebugRule>
 struct StringLiteral : qi::grammar<Iterator, typename SA::string_literal::attribute_type, typename SA::string_literal::local_type>
 {
 	StringLiteral() : StringLiteral::base_type(string_literal)
@@ -224,7 +256,7 @@ struct StringLiteral : qi::grammar<Iterator, typename SA::string_literal::attrib
 /// ThorScript
 /////////////////////////////////////////////////////////////////////
 
-template<typename Iterator, typename SA>
+template<typename Iterator, typename SA, bool DebugRule = false>
 struct ThorScript : qi::grammar<Iterator, typename SA::start::attribute_type, detail::WhiteSpace<Iterator>, typename SA::start::local_type >
 {
 	ThorScript() : ThorScript::base_type(start)
@@ -948,7 +980,13 @@ struct ThorScript : qi::grammar<Iterator, typename SA::start::attribute_type, de
 		program
 			=	*(	(IMPORT >> -((IDENTIFIER | EMIT_BOOL(DOT)) >> ASSIGN) > nested_identifier > SEMICOLON
 					) [ typename SA::program::append_import() ] )
-			>	*( global_decl [ typename SA::program::append_global_decl() ] )
+			>	global_decl_list
+			;
+
+		// also the entry rule to reparse a range of declarations, see ThorScriptParserStage::reparse()
+		// (the end position is taken without skipping, so it's right after the last token)
+		global_decl_list
+			=	*( (iter_pos >> global_decl >> qi::no_skip[ iter_pos ]) [ typename SA::program::append_global_decl() ] )
 			;
 
 		///
@@ -975,21 +1013,18 @@ struct ThorScript : qi::grammar<Iterator, typename SA::start::attribute_type, de
 		FLOAT_LITERAL.name("FLOAT_LITERAL.grammar");
 		STRING_LITERAL.name("STRING_LITERAL.grammar");
 
-		if(getParserContext().dump_rule_debug)
-		{
-			// keywords
-			debug(_TRUE);
-			debug(_FALSE);
-			debug(_NULL);
+		// keywords
+		detail::RuleDebug<DebugRule>::enable(_TRUE);
+		detail::RuleDebug<DebugRule>::enable(_FALSE);
+		detail::RuleDebug<DebugRule>::enable(_NULL);
 
-			// terminals
+		// terminals
 #if 0 // NOTE: grammars cannot have debug_handlers, only rules can
-			debug(IDENTIFIER);
-			debug(INTEGER_LITERAL);
-			debug(FLOAT_LITERAL);
-			debug(STRING_LITERAL);
+		detail::RuleDebug<DebugRule>::enable(IDENTIFIER);
+		detail::RuleDebug<DebugRule>::enable(INTEGER_LITERAL);
+		detail::RuleDebug<DebugRule>::enable(FLOAT_LITERAL);
+		detail::RuleDebug<DebugRule>::enable(STRING_LITERAL);
 #endif
-		}
 
 		// basic
 		INIT_RULE(location);
@@ -1054,6 +1089,7 @@ struct ThorScript : qi::grammar<Iterator, typename SA::start::attribute_type, de
 
 		// module
 		INIT_RULE(program);
+		INIT_RULE(global_decl_list);
 
 		// start
 		INIT_RULE(start);
@@ -1096,10 +1132,10 @@ struct ThorScript : qi::grammar<Iterator, typename SA::start::attribute_type, de
 		EXTENDS, IMPLEMENTS;
 
 	// terminals
-	detail::Identifier<Iterator, SA>     IDENTIFIER;
-	detail::IntegerLiteral<Iterator, SA> INTEGER_LITERAL;
-	detail::FloatLiteral<Iterator, SA>   FLOAT_LITERAL;
-	detail::StringLiteral<Iterator, SA>  STRING_LITERAL;
+	detail::Identifier<Iterator, SA, DebugRule>     IDENTIFIER;
+	detail::IntegerLiteral<Iterator, SA, DebugRule> INTEGER_LITERAL;
+	detail::FloatLiteral<Iterator, SA, DebugRule>   FLOAT_LITERAL;
+	detail::StringLiteral<Iterator, SA, DebugRule>  STRING_LITERAL;
 
 	// location
 	DECL_RULE_LEXEME(location);
@@ -1167,6 +1203,7 @@ struct ThorScript : qi::grammar<Iterator, typename SA::start::attribute_type, de
 
 	// module
 	DECL_RULE(program);
+	DECL_RULE_CUSTOM_SA(global_decl_list, program);
 
 	// start
 	DECL_RULE(start);
@@ -0,0 +1,65 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_FUSABLESTAGE_H_
+#define ZILLIANS_LANGUAGE_STAGE_FUSABLESTAGE_H_
+
+#include "language/stage/Stage.h"
+
+namespace zillians { namespace language { namespace tree { namespace visitor {
+struct GenericDoubleVisitor;
+} } } }
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * FusableStage is a stage whose work is a single walk of the tangle, so it can share that walk with others
+ *
+ * A fusable stage splits its execution in three: prepareTraversal() checks the parser context and hands
+ * out the visitor to run, the visitor is run over the tangle (alone, or fused with the visitors of other
+ * stages by FusedStage), and finishTraversal() applies whatever transforms or cleanups the visitor has
+ * deferred. The visitor must not restructure the tree while walking it.
+ *
+ * Every derived class has to define "static const bool pre_order_traversal", which is true if its visitor
+ * does all its work on a node before calling revisit() on it.
+ *
+ * @see FusedStage, GenericFusedVisitor
+ */
+class FusableStage : public Stage
+{
+public:
+	/**
+	 * Prepare the visitor to run over the tangle
+	 *
+	 * @param visitor receives the visitor, or NULL if there's nothing to do this time
+	 * @return false if the stage fails
+	 */
+	virtual bool prepareTraversal(tree::visitor::GenericDoubleVisitor*& visitor) = 0;
+
+	/**
+	 * Apply deferred transforms once the walk is over and release the visitor
+	 */
+	virtual bool finishTraversal(bool& continue_execution) = 0;
+
+	virtual bool execute(bool& continue_execution);
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_FUSABLESTAGE_H_ */
@@ -0,0 +1,182 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_FUSEDSTAGE_H_
+#define ZILLIANS_LANGUAGE_STAGE_FUSEDSTAGE_H_
+
+#include "core/Prerequisite.h"
+#include "language/stage/FusableStage.h"
+#include "language/tree/visitor/GenericFusedVisitor.h"
+#include "language/context/ParserContext.h"
+#include "utility/Foreach.h"
+#include <boost/mpl/for_each.hpp>
+#include <boost/mpl/count_if.hpp>
+#include <boost/mpl/size.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/not.hpp>
+#include <boost/mpl/placeholders.hpp>
+#include <boost/type_traits/add_pointer.hpp>
+#include <boost/static_assert.hpp>
+
+namespace zillians { namespace language { namespace stage {
+
+namespace detail {
+
+	template<typename T>
+	struct IsPreOrderStage : boost::mpl::bool_<T::pre_order_traversal>
+	{ };
+
+	struct FusedStageCreator
+	{
+		FusedStageCreator(std::vector<shared_ptr<FusableStage>>& stages, std::vector<bool>& pre_order) : stages(stages), pre_order(pre_order)
+		{ }
+
+		template<typename T>
+		void operator()(T*)
+		{
+			stages.push_back(shared_ptr<FusableStage>(new T()));
+			pre_order.push_back(T::pre_order_traversal);
+		}
+
+		std::vector<shared_ptr<FusableStage>>& stages;
+		std::vector<bool>& pre_order;
+	};
+
+}
+
+/**
+ * FusedStage runs a group of FusableStage's with a single walk of the tangle
+ *
+ * Put it into a StageBuilder mode in place of the stages it fuses, for example:
+ *
+ *   FusedStage<boost::mpl::vector<SemanticVerificationStage0, LiteralCompactionStage>>
+ *
+ * At every node the stage visitors are invoked in the given order (the one stage which is not pre-order,
+ * if any, goes last), and after the walk the deferred transforms of each stage are applied in the given
+ * order, so the next group sees the transformed tree. Only group stages which don't depend on each
+ * other's results on the same walk.
+ *
+ * @see FusableStage, GenericFusedVisitor
+ */
+template<typename StageTypes>
+class FusedStage : public Stage
+{
+	BOOST_STATIC_ASSERT((boost::mpl::size<StageTypes>::value - boost::mpl::count_if<StageTypes, detail::IsPreOrderStage<boost::mpl::_1>>::value <= 1));
+
+public:
+	typedef StageTypes stage_types;
+
+	FusedStage()
+	{
+		boost::mpl::for_each<StageTypes, boost::add_pointer<boost::mpl::_1>>(detail::FusedStageCreator(stages, pre_order));
+
+		stage_name = "Fused Stage (";
+		foreach(i, stages)
+		{
+			if(i != stages.begin()) stage_name += ", ";
+			stage_name += (*i)->name();
+		}
+		stage_name += ")";
+	}
+
+	virtual ~FusedStage()
+	{ }
+
+public:
+	virtual const char* name()
+	{
+		return stage_name.c_str();
+	}
+
+	virtual std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_description>> getOptions()
+	{
+		shared_ptr<po::options_description> option_desc_public(new po::options_description());
+		shared_ptr<po::options_description> option_desc_private(new po::options_description());
+
+		foreach(i, stages)
+		{
+			std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_description>> options = (*i)->getOptions();
+			if(options.first->options().size() > 0)
+				option_desc_public->add(*options.first);
+			if(options.second->options().size() > 0)
+				option_desc_private->add(*options.second);
+		}
+
+		return std::make_pair(option_desc_public, option_desc_private);
+	}
+
+	virtual bool parseOptions(po::variables_map& vm)
+	{
+		foreach(i, stages)
+		{
+			if(!(*i)->parseOptions(vm))
+				return false;
+		}
+
+		return true;
+	}
+
+	virtual bool execute(bool& continue_execution)
+	{
+		// the fused visitor has to go before finishTraversal() releases the stage visitors
+		{
+			tree::visitor::GenericFusedVisitor fused;
+			bool has_visitor = false;
+
+			for(std::size_t i = 0; i < stages.size(); ++i)
+			{
+				tree::visitor::GenericDoubleVisitor* visitor = NULL;
+				if(!stages[i]->prepareTraversal(visitor))
+					return false;
+
+				if(visitor)
+				{
+					if(pre_order[i])
+						fused.addFollower(*visitor);
+					else
+						fused.setLeader(*visitor);
+					has_visitor = true;
+				}
+			}
+
+			if(has_visitor)
+				fused.visit(*getParserContext().tangle);
+		}
+
+		foreach(i, stages)
+		{
+			bool c = true;
+			if(!(*i)->finishTraversal(c))
+				return false;
+			if(!c)
+				continue_execution = false;
+		}
+
+		return true;
+	}
+
+private:
+	std::vector<shared_ptr<FusableStage>> stages;
+	std::vector<bool> pre_order;
+	std::string stage_name;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_FUSEDSTAGE_H_ */
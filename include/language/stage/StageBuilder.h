@@ -23,6 +23,7 @@
 #include "core/Prerequisite.h"
 #include "language/stage/Stage.h"
 #include "language/stage/StageConductor.h"
+#include "language/stage/FusedStage.h"
 #include "utility/Foreach.h"
 #include <functional>
 #include <boost/mpl/size.hpp>
@@ -34,6 +35,35 @@ namespace zillians { namespace language { namespace stage {
 
 namespace detail {
 
+	template<typename Types>
+	struct AllStageAppender;
+
+	template<typename T>
+	struct AllStageRegistrar
+	{
+		static void append(std::map<std::string, std::function<void()>>& m, StageConductor* conductor)
+		{
+			std::string s(typeid(T).name());
+			if(m.find(s) == m.end())
+			{
+				std::function<void()> f = [=]{
+					conductor->appendStage(shared_ptr<Stage>(new T()));
+				};
+				m.insert(std::make_pair(s, f));
+			}
+		}
+	};
+
+	// fused stages are listed as their individual stages, so each stage's options show up only once
+	template<typename Types>
+	struct AllStageRegistrar<FusedStage<Types>>
+	{
+		static void append(std::map<std::string, std::function<void()>>& m, StageConductor* conductor)
+		{
+			AllStageAppender<Types>::append(m, conductor);
+		}
+	};
+
 	template<int N, typename Types>
 	struct BuilderAppenderImpl : public BuilderAppenderImpl<N-1, Types>
 	{
@@ -72,14 +102,7 @@ namespace detail {
 		{
 			AllStageAppenderImpl<N-1, Types>::append(m, conductor);
 			typedef typename boost::mpl::at<Types, boost::mpl::int_<N> >::type T;
-			std::string s(typeid(T).name());
-			if(m.find(s) == m.end())
-			{
-				std::function<void()> f = [=]{
-					conductor->appendStage(shared_ptr<Stage>(new T()));
-				};
-				m.insert(std::make_pair(s, f));
-			}
+			AllStageRegistrar<T>::append(m, conductor);
 		}
 	};
 
@@ -89,14 +112,7 @@ namespace detail {
 		static void append(std::map<std::string, std::function<void()>>& m, StageConductor* conductor)
 		{
 			typedef typename boost::mpl::at<Types, boost::mpl::int_<0> >::type T;
-			std::string s(typeid(T).name());
-			if(m.find(s) == m.end())
-			{
-				std::function<void()> f = [=]{
-					conductor->appendStage(shared_ptr<Stage>(new T()));
-				};
-				m.insert(std::make_pair(s, f));
-			}
+			AllStageRegistrar<T>::append(m, conductor);
 		}
 	};
 
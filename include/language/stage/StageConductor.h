@@ -23,10 +23,26 @@
 #include "core/Prerequisite.h"
 #include "language/stage/Stage.h"
 
-namespace zillians { namespace language { namespace stage {
+namespace zillians { namespace language {
+
+class CompilationSession;
+
+namespace stage {
 
 class StageConductor
 {
+public:
+	/**
+	 * Observer is notified around the execution of every stage, for profiling the pipeline
+	 */
+	struct Observer
+	{
+		virtual ~Observer() { }
+
+		virtual void beforeExecute(Stage& stage) = 0;
+		virtual void afterExecute(Stage& stage, bool succeeded) = 0;
+	};
+
 public:
 	StageConductor(bool require_input);
 	virtual ~StageConductor();
@@ -34,14 +50,23 @@ public:
 public:
 	void appendStage(shared_ptr<Stage> s);
 	void appendOptionsFromAllStages(po::options_description& options_desc_public, po::options_description& options_desc_private);
+	void setObserver(Observer* observer);
+
+	/// run the stages within the given session instead of the process-wide contexts
+	void setSession(CompilationSession* session);
 
 public:
 	virtual int main(int argc, const char** argv);
 
+protected:
+	int run(int argc, const char** argv);
+
 protected:
 	po::options_description mOptionDescGlobal;
 	po::positional_options_description mPositionalOptionDesc;
 	std::vector<shared_ptr<Stage>> mStages;
+	Observer* mObserver;
+	CompilationSession* mSession;
 };
 
 } } }
@@ -0,0 +1,136 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_DEP_THORSCRIPTDEPDATABASE_H_
+#define ZILLIANS_LANGUAGE_STAGE_DEP_THORSCRIPTDEPDATABASE_H_
+
+#include "core/Prerequisite.h"
+#include "language/stage/dep/ThorScriptImportScanner.h"
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * ThorScriptDepDatabase remembers what ts-dep learned about the project in the previous run, so a
+ * rebuild only looks at what changed
+ *
+ * It keeps, in build/ts.depdb:
+ * - per source file: mtime, size, SHA1 of the content and the imported packages
+ * - per directory: mtime and the .t files and sub-directories in it
+ * - per bundle .ast: mtime, size and the packages it provides
+ * - the file graph the tangles were computed from
+ *
+ * A record is trusted as long as mtime and size still match. As in git's index, an mtime not older
+ * than the time the previous run started may hide a modification made within the same second, so
+ * such a record is verified once more: a file by its content hash, a directory by listing it.
+ */
+class ThorScriptDepDatabase
+{
+public:
+    struct FileRecord
+    {
+        FileRecord() : mtime(0), size(0) { }
+
+        std::time_t mtime;
+        uint64 size;
+        std::string hash;
+        std::vector<std::string> imports; // UTF-8 package names
+
+        template<typename Archive>
+        void serialize(Archive& ar, const unsigned int version);
+    };
+
+    struct DirectoryRecord
+    {
+        DirectoryRecord() : mtime(0) { }
+
+        std::time_t mtime;
+        std::vector<std::string> files;
+        std::vector<std::string> directories;
+
+        template<typename Archive>
+        void serialize(Archive& ar, const unsigned int version);
+    };
+
+    struct BundleRecord
+    {
+        BundleRecord() : mtime(0), size(0) { }
+
+        std::time_t mtime;
+        uint64 size;
+        std::vector<std::string> packages;
+
+        template<typename Archive>
+        void serialize(Archive& ar, const unsigned int version);
+    };
+
+    typedef std::map<std::string, std::set<std::string>> FileEdges;
+
+public:
+    explicit ThorScriptDepDatabase(const boost::filesystem::path& file);
+
+public:
+    /// a missing, broken or outdated database just leaves everything to be scanned
+    bool load();
+
+    /// records not used since load() are dropped
+    bool save();
+
+    /// all .t files under @p dir, recursively; only directories whose mtime changed are listed again
+    std::set<std::string> globTsFiles(const std::string& dir);
+
+    /// imports of many files, only files whose content changed are scanned, results[i] belongs to filenames[i]
+    void scanImports(const std::vector<std::string>& filenames, uint32 threads, std::vector<ThorScriptImportScanner::Result>& results);
+
+    /// content SHA1 of a source file, taken from the database as long as the file didn't change
+    std::string hashOf(const std::string& filename) const;
+
+    bool findBundle(const std::string& astPath, std::vector<std::wstring>& packages);
+    void storeBundle(const std::string& astPath, const std::vector<std::wstring>& packages);
+
+public:
+    /// file graph the current ts.dep was computed from
+    FileEdges edges;
+
+private:
+    bool isTrusted(std::time_t recordMtime, std::time_t mtime) const;
+    void listDirectory(const std::string& dir, std::set<std::string>& result);
+
+private:
+    boost::filesystem::path file;
+    std::time_t previousStart; // when the run which saved the loaded database started
+    std::time_t start;
+
+    std::map<std::string, FileRecord> files;
+    std::map<std::string, DirectoryRecord> directories;
+    std::map<std::string, BundleRecord> bundles;
+
+    std::set<std::string> usedFiles;
+    std::set<std::string> usedDirectories;
+    std::set<std::string> usedBundles;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_DEP_THORSCRIPTDEPDATABASE_H_ */
@@ -21,6 +21,8 @@
 #define ZILLIANS_LANGUAGE_STAGE_DEP_THORSCRIPTDEPSTAGE_H_
 
 #include "language/stage/Stage.h"
+#include "language/stage/dep/ThorScriptImportScanner.h"
+#include "language/stage/dep/ThorScriptDepDatabase.h"
 #include <utility>
 #include <boost/filesystem.hpp>
 #include <boost/graph/adjacency_list.hpp>
@@ -97,6 +99,11 @@ private:
     bool analyzeTangle(const boost::filesystem::path& buildPath, FileGraphType& g);
     bool scanAllBundlePackage(const boost::filesystem::path& buildPath, std::multimap<std::string, std::wstring>& allBundlePackage);
 
+private:
+    std::map<std::string, ThorScriptImportScanner::Result> scannedImports;
+    shared_ptr<ThorScriptDepDatabase> database;
+    uint32 scanThreads;
+
 public:
     std::vector<std::string> inputFiles;
     boost::filesystem::path rootDir;
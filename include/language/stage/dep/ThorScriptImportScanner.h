@@ -0,0 +1,60 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_DEP_THORSCRIPTIMPORTSCANNER_H_
+#define ZILLIANS_LANGUAGE_STAGE_DEP_THORSCRIPTIMPORTSCANNER_H_
+
+#include "core/Prerequisite.h"
+#include <string>
+#include <vector>
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * ThorScriptImportScanner collects the packages imported by ThorScript source files without parsing them.
+ *
+ * Imports can only appear at the head of a file, so the raw UTF-8 content is read in small chunks and
+ * scanning stops at the first token which doesn't start an import; the rest of the file is never read.
+ * Whitespace, comments and a leading BOM are skipped the same way the parser does.
+ */
+class ThorScriptImportScanner
+{
+public:
+    struct Result
+    {
+        Result() : succeeded(false) { }
+
+        std::vector<std::wstring> packages;
+        bool succeeded;
+    };
+
+public:
+    /// scan a single file, fails if the file can't be read or an import is malformed
+    static bool scanFile(const std::string& filename, std::vector<std::wstring>& packages);
+
+    /// scan UTF-8 content already in memory
+    static bool scanBuffer(const char* first, const char* last, std::vector<std::wstring>& packages);
+
+    /// scan many files on the given number of threads, results[i] belongs to filenames[i]
+    static void scanFiles(const std::vector<std::string>& filenames, uint32 threads, std::vector<Result>& results);
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_DEP_THORSCRIPTIMPORTSCANNER_H_ */
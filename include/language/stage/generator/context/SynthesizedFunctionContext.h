@@ -22,6 +22,7 @@
 
 #include "core/Prerequisite.h"
 #include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
 #include "language/GlobalContext.h"
 #include "language/stage/generator/detail/LLVMHeaders.h"
 
@@ -34,12 +35,12 @@ struct SynthesizedFunctionContext
 
 	static SynthesizedFunctionContext* get(tree::ASTNode* node)
 	{
-		return node->get<SynthesizedFunctionContext>();
+		return tree::NodeContextTable<SynthesizedFunctionContext>::get(node);
 	}
 
 	static void set(tree::ASTNode* node, SynthesizedFunctionContext* ctx)
 	{
-		node->set<SynthesizedFunctionContext>(ctx);
+		tree::NodeContextTable<SynthesizedFunctionContext>::set(node, ctx);
 	}
 
 	llvm::Function* f;
@@ -53,7 +54,7 @@ struct SynthesizedFunctionContext
 		if(SynthesizedFunctionContext::get(x)) \
 			SynthesizedFunctionContext::get((x))->f = func; \
 		else \
-			SynthesizedFunctionContext::set(x, new SynthesizedFunctionContext(func)); \
+			tree::NodeContextTable<SynthesizedFunctionContext>::assign(x, SynthesizedFunctionContext(func)); \
 	}
 
 } } }
@@ -23,6 +23,7 @@
 #include "core/Prerequisite.h"
 #include "core/Containers.h"
 #include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
 #include "language/GlobalContext.h"
 #include "language/stage/generator/detail/LLVMHeaders.h"
 
@@ -35,12 +36,12 @@ struct SynthesizedValueContext
 
 	static SynthesizedValueContext* get(tree::ASTNode* node)
 	{
-		return node->get<SynthesizedValueContext>();
+		return tree::NodeContextTable<SynthesizedValueContext>::get(node);
 	}
 
 	static void set(tree::ASTNode* node, SynthesizedValueContext* ctx)
 	{
-		node->set<SynthesizedValueContext>(ctx);
+		tree::NodeContextTable<SynthesizedValueContext>::set(node, ctx);
 	}
 
 	llvm::Value* v;
@@ -53,12 +54,12 @@ struct SynthesizedBlockContext
 
 	static SynthesizedBlockContext* get(tree::ASTNode* node)
 	{
-		return node->get<SynthesizedBlockContext>();
+		return tree::NodeContextTable<SynthesizedBlockContext>::get(node);
 	}
 
 	static void set(tree::ASTNode* node, SynthesizedBlockContext* ctx)
 	{
-		node->set<SynthesizedBlockContext>(ctx);
+		tree::NodeContextTable<SynthesizedBlockContext>::set(node, ctx);
 	}
 
 	llvm::BasicBlock* bb;
@@ -71,12 +72,9 @@ struct IntermediateValueContext
 
 	static IntermediateValueContext* get(tree::ASTNode* node)
 	{
-		IntermediateValueContext* ctx = node->get<IntermediateValueContext>();
+		IntermediateValueContext* ctx = tree::NodeContextTable<IntermediateValueContext>::get(node);
 		if(!ctx)
-		{
-			ctx = new IntermediateValueContext();
-			node->set<IntermediateValueContext>(ctx);
-		}
+			ctx = tree::NodeContextTable<IntermediateValueContext>::assign(node, IntermediateValueContext());
 		return ctx;
 	}
 
@@ -111,7 +109,7 @@ struct IntermediateValueContext
 		if(SynthesizedValueContext::get(x)) \
 			SynthesizedValueContext::get((x))->v = val; \
 		else \
-			SynthesizedValueContext::set(x, new SynthesizedValueContext(val)); \
+			tree::NodeContextTable<SynthesizedValueContext>::assign(x, SynthesizedValueContext(val)); \
 	}
 
 #define GET_SYNTHESIZED_LLVM_BLOCK(x) \
@@ -122,7 +120,7 @@ struct IntermediateValueContext
 		if(SynthesizedBlockContext::get(x)) \
 			SynthesizedBlockContext::get((x))->bb = val; \
 		else \
-			SynthesizedBlockContext::set(x, new SynthesizedBlockContext(val)); \
+			tree::NodeContextTable<SynthesizedBlockContext>::assign(x, SynthesizedBlockContext(val)); \
 	}
 
 } } }
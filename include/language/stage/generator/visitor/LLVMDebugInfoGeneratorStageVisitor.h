@@ -157,7 +157,7 @@ struct LLVMDebugInfoGeneratorStageVisitor: public GenericDoubleVisitor
 				llvm::StringRef(ws_to_s(node.name->toString()).c_str()),
 				llvm::StringRef(mangling->managled_name.c_str()),
 				file_context->file,
-				SourceInfoContext::get(&node)->line,
+				SourceInfoContext::get(&node)->line(),
 				subroutine_type,
 				false, //bool isLocalToUnit,
 				true, //bool isDefinition,
@@ -222,9 +222,12 @@ private:
 			return;
 		}
 
+		uint32 line = 0, column = 0;
+		source_info->locate(line, column);
+
 		// TODO: Need to decide the type
-		BOOST_ASSERT( (source_info->line >> 24) == 0 && "To much lines!! Only allowed 16777215 lines");
-		uint32 offset = (argument_position << 24) + source_info->line;
+		BOOST_ASSERT( (line >> 24) == 0 && "To much lines!! Only allowed 16777215 lines");
+		uint32 offset = (argument_position << 24) + line;
 		llvm::DIVariable variable = factory.createLocalVariable(
 				variable_type,
 				parent_debug_info->context, llvm::StringRef(ws_to_s(node.name->toString()).c_str()),
@@ -246,7 +249,7 @@ private:
 		// TODO: decide to insert at end of block or before an specific instruction
 		llvm::Instruction* variable_inst = factory.insertDeclare(value, variable, block);
 		llvm::MDNode* scope = parent_debug_info->context;
-		variable_inst->setDebugLoc(llvm::DebugLoc::get(source_info->line, source_info->column, scope));
+		variable_inst->setDebugLoc(llvm::DebugLoc::get(line, column, scope));
 
 		// Check if the variable has initialization
 		insertDebugLocationForIntermediateValues(node);
@@ -316,11 +319,12 @@ private:
 		{
 			// Retrieve parent node debug information, since we need its context
 			DebugInfoContext* parent_debug_info = DebugInfoContext::get(node.parent);
-			SourceInfoContext* source_info = SourceInfoContext::get(&node);
+			uint32 line = 0, column = 0;
+			SourceInfoContext::get(&node)->locate(line, column);
 
-			LOG4CXX_DEBUG(LoggerWrapper::DebugInfoGeneratorStage, "<Block> line: " << source_info->line << " column: " << source_info->column);
+			LOG4CXX_DEBUG(LoggerWrapper::DebugInfoGeneratorStage, "<Block> line: " << line << " column: " << column);
 			llvm::DILexicalBlock function_block = factory.createLexicalBlock(
-					parent_debug_info->context, parent_debug_info->file, source_info->line, source_info->column);
+					parent_debug_info->context, parent_debug_info->file, line, column);
 
 			DebugInfoContext::set(&node, new DebugInfoContext(
 					parent_debug_info->compile_unit, parent_debug_info->file,	// inherit from parent node
@@ -328,7 +332,7 @@ private:
 
 			// Insert the position for the last command
 			llvm::TerminatorInst* terminate_inst = block->getTerminator();
-			terminate_inst->setDebugLoc(llvm::DebugLoc::get(source_info->line, source_info->column, parent_debug_info->context));
+			terminate_inst->setDebugLoc(llvm::DebugLoc::get(line, column, parent_debug_info->context));
 		}
 	}
 
@@ -364,8 +368,11 @@ private:
 				llvm::Instruction* llvm_inst = llvm::dyn_cast<llvm::Instruction>(llvm_value);
 				if (llvm_inst)
 				{
-					LOG4CXX_DEBUG(LoggerWrapper::DebugInfoGeneratorStage, __FUNCTION__ << ": " << node.instanceName() << " @" << llvm_inst << "(" << source_info->line << ", " << source_info->column << ") with scope: " << (llvm::MDNode*)debug_info->context);
-					llvm_inst->setDebugLoc(llvm::DebugLoc::get(source_info->line, source_info->column, debug_info->context));
+					uint32 line = 0, column = 0;
+					source_info->locate(line, column);
+
+					LOG4CXX_DEBUG(LoggerWrapper::DebugInfoGeneratorStage, __FUNCTION__ << ": " << node.instanceName() << " @" << llvm_inst << "(" << line << ", " << column << ") with scope: " << (llvm::MDNode*)debug_info->context);
+					llvm_inst->setDebugLoc(llvm::DebugLoc::get(line, column, debug_info->context));
 				}
 			}
 		}
@@ -376,12 +383,13 @@ private:
 		auto debug_info = getOrInheritDebugInfo(node);
 
 		unordered_set<llvm::Value*> values = GET_INTERMEDIATE_LLVM_VALUES(&node);
-		SourceInfoContext* source_info = SourceInfoContext::get(&node);
+		uint32 line = 0, column = 0;
+		SourceInfoContext::get(&node)->locate(line, column);
 
 		foreach(i, values)
 		{
 			llvm::Instruction* inst = llvm::dyn_cast<llvm::Instruction>(*i);
-			inst->setDebugLoc(llvm::DebugLoc::get(source_info->line, source_info->column, debug_info->context));
+			inst->setDebugLoc(llvm::DebugLoc::get(line, column, debug_info->context));
 		}
 	}
 
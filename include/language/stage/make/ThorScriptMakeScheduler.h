@@ -0,0 +1,71 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_MAKE_THORSCRIPTMAKESCHEDULER_H_
+#define ZILLIANS_LANGUAGE_STAGE_MAKE_THORSCRIPTMAKESCHEDULER_H_
+
+#include "language/stage/dep/ThorScriptSourceTangleGraph.h"
+#include <functional>
+#include <vector>
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * ThorScriptMakeScheduler runs one job per tangle on a fixed number of threads
+ *
+ * A tangle is ready once every tangle it depends on succeeded. Of the ready tangles, the one
+ * heading the longest chain of remaining work starts first: its own cost plus the longest chain
+ * of tangles depending on it. So the critical path never waits behind short jobs which could run
+ * alongside it. After the first failure no job is started any more; running jobs are waited for
+ * and the others are left cancelled.
+ */
+class ThorScriptMakeScheduler
+{
+public:
+    typedef boost::graph_traits<TangleGraphType>::vertex_descriptor Vertex;
+
+    enum class JobState
+    {
+        WAITING,
+        RUNNING,
+        SUCCEEDED,
+        FAILED,
+        CANCELLED
+    };
+
+public:
+    /// costs[v] is the estimated time to build tangle v, in any unit
+    ThorScriptMakeScheduler(const TangleGraphType& graph, const std::vector<double>& costs);
+
+public:
+    /// run job(v) for every tangle, returns true if all of them returned 0
+    bool run(std::size_t threads, const std::function<int(Vertex)>& job);
+
+    double priority(Vertex v) const { return priorities[v]; }
+    JobState state(Vertex v) const  { return states[v]; }
+
+private:
+    const TangleGraphType& graph;
+    std::vector<double> priorities;
+    std::vector<JobState> states;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_MAKE_THORSCRIPTMAKESCHEDULER_H_ */
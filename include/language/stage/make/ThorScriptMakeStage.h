@@ -22,12 +22,30 @@
 
 #include "language/stage/Stage.h"
 #include "language/stage/dep/ThorScriptSourceTangleGraph.h"
+#include "language/stage/dep/ThorScriptDepDatabase.h"
 #include <boost/filesystem.hpp>
+#include <map>
+#include <mutex>
 
 namespace zillians { namespace language { namespace stage {
 
 /**
  * The ThorScriptMakeStage invoke compile commands with ts-compile.
+ *
+ * A tangle is compiled only if its fingerprint changed since it was last compiled successfully.
+ * The fingerprint covers the compile command (and so all flags), the ts-compile binary, the
+ * prelude image, the content of the sources, and the interface fingerprint of every tangle it
+ * depends on (see ASTSerializationHelper::interfaceFingerprint), so changing a function body
+ * recompiles only the tangle it is in.
+ *
+ * Up to -j tangles are compiled at once, longest chain of remaining work first (estimated from
+ * the compile times of the previous build, see ThorScriptMakeScheduler); the build stops at the
+ * first failure.
+ *
+ * With --in-process the compiler stages linked into ts-make run each tangle as a job on the
+ * scheduler's threads instead of spawning ts-compile. Each job runs in its own CompilationSession
+ * and decodes dependency ASTs from a shared ASTImageCache, so a dependency is parsed once per
+ * build rather than once per dependent.
  */
 class ThorScriptMakeStage : public Stage
 {
@@ -49,10 +67,15 @@ private:
     };
 
 private:
-    std::string genCompileCmd(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g);
+    std::vector<std::string> genCompileArgs(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g);
+    std::string genFingerprint(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g, const std::string& cmd);
+    int compile(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g, const std::vector<std::string>& args);
+    int compileInProcess(const std::vector<std::string>& args);
 
 public:
     bool dumpCompileCommand;
+    bool inProcess;
+    unsigned jobs;
     boost::filesystem::path executablePath;
     boost::filesystem::path projectPath;
     boost::filesystem::path buildPath;
@@ -63,6 +86,10 @@ private:
 	bool dumpGraphviz;
     std::string dumpGraphvizDir;
     std::string prepandPackage;
+    boost::filesystem::path preludePath; // empty unless --prelude is given
+    shared_ptr<ThorScriptDepDatabase> sources;
+    std::map<std::string, double> buildTimes; // seconds of the last successful compile, by tangle file name
+    std::mutex buildTimesMutex;
 };
 
 } } }
@@ -0,0 +1,81 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_PARSER_PARSECACHE_H_
+#define ZILLIANS_LANGUAGE_STAGE_PARSER_PARSECACHE_H_
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/stage/parser/SourceBuffer.h"
+#include <boost/filesystem.hpp>
+#include <deque>
+#include <string>
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * ParseCache keeps the parsed tree of every source file on disk, so unchanged files don't go
+ * through the parser again
+ *
+ * An entry is keyed by the SHA1 of the file content, the file name, the package the source is
+ * placed in (root-dir relative path plus --prepand-package) and ParseCache::format_version.
+ * It stores the containing package identifier and the Source subtree together with all the
+ * contexts in FullSerializer (SourceInfoContext in particular), and the SourceSpanContext of the
+ * top-level declarations so a source loaded from the cache can be reparsed incrementally.
+ *
+ * Entries are written to a temporary file which is then renamed, so concurrent ts-compile jobs
+ * sharing the directory never see a partially written entry.
+ */
+class ParseCache
+{
+public:
+	/**
+	 * Bump whenever a change of the grammar, the semantic actions, the tree or the serialized
+	 * contexts changes what an unchanged source is loaded as, so existing entries are no longer hit
+	 *
+	 * That is any change in what these files produce or serialize:
+	 * - include/language/grammar/ (ThorScript.h and the skipper in WhiteSpace.h)
+	 * - include/language/action/ (all the semantic actions)
+	 * - include/language/tree/ (the serialize(), load() and save() members of the nodes)
+	 * - the contexts listed in FullSerializer (serialization/detail/ASTSerializationCommon.h),
+	 *   SourceSpanContext, SourceLineTable and this file
+	 */
+	static const uint32 format_version;
+
+public:
+	explicit ParseCache(const boost::filesystem::path& directory);
+
+public:
+	std::string key(const SourceBuffer& buffer, const std::string& filename, const std::deque<std::wstring>& package) const;
+
+	/**
+	 * Load a cached entry into the active arena
+	 *
+	 * On failure the active arena may be left with a partially loaded tree.
+	 */
+	bool load(const std::string& key, tree::Identifier*& package_id, tree::Source*& source) const;
+	bool store(const std::string& key, tree::Identifier* package_id, tree::Source* source) const;
+
+private:
+	boost::filesystem::path directory;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_PARSER_PARSECACHE_H_ */
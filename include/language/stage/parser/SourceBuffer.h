@@ -0,0 +1,94 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_PARSER_SOURCEBUFFER_H_
+#define ZILLIANS_LANGUAGE_STAGE_PARSER_SOURCEBUFFER_H_
+
+#include "core/Prerequisite.h"
+#include "language/stage/parser/SourceLineTable.h"
+#include <boost/noncopyable.hpp>
+#include <boost/regex/pending/unicode_iterator.hpp>
+#include <string>
+#include <vector>
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * SourceBuffer maps a UTF-8 source file into memory and lets the grammar run
+ * directly over the raw bytes.
+ *
+ * Line and column are not tracked while parsing; instead the byte position is
+ * remembered and translated on demand through a SourceLineTable, which is
+ * built the first time somebody asks for it.
+ */
+class SourceBuffer : boost::noncopyable
+{
+public:
+	typedef boost::u8_to_u32_iterator<const char*> iterator;
+
+public:
+	SourceBuffer();
+	~SourceBuffer();
+
+public:
+	/// map the given file (a leading UTF-8 BOM is skipped)
+	bool open(const std::string& filename);
+	void close();
+
+	bool isOpen() const  { return opened; }
+
+	const char* data() const    { return first; }
+	std::size_t size() const    { return last - first; }
+
+	iterator begin() const      { return iterator(first, first, last); }
+	iterator end() const        { return iterator(last, first, last); }
+
+	/// iterator at the given byte offset, which must start a UTF-8 sequence (throws std::out_of_range otherwise)
+	iterator at(std::size_t offset) const { return iterator(first + offset, first, last); }
+
+	/// the line table of the content, also registered in SourceTable by the parser
+	shared_ptr<SourceLineTable> lineTable() const;
+
+	/// translate a position inside the buffer into 1-based line and column
+	void locate(const char* position, uint32& line, uint32& column) const;
+
+	void locate(const iterator& position, uint32& line, uint32& column) const
+	{
+		locate(position.base(), line, column);
+	}
+
+	/// the content of the given 1-based line without its line terminator
+	std::wstring getLine(uint32 line) const;
+
+private:
+	bool opened;
+	std::string filename;
+	const char* first;
+	const char* last;
+
+	void* mapped_address;
+	std::size_t mapped_size;
+	std::string fallback;
+
+	mutable shared_ptr<SourceLineTable> line_table;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_PARSER_SOURCEBUFFER_H_ */
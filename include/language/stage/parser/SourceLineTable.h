@@ -0,0 +1,346 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_PARSER_SOURCELINETABLE_H_
+#define ZILLIANS_LANGUAGE_STAGE_PARSER_SOURCELINETABLE_H_
+
+#include "core/Prerequisite.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/assert.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * SourceLineTable translates byte offsets of a source file into 1-based line and column
+ *
+ * Columns follow the convention of spirit's position_iterator: they count characters and a tab
+ * advances to the next multiple of 4. Besides the offset each line starts at, the table keeps a
+ * mark at every character following a tab or a multi-byte UTF-8 character (where counting bytes
+ * stops matching counting columns), so the content itself is not needed to compute a column.
+ */
+struct SourceLineTable
+{
+	friend class boost::serialization::access;
+
+	static const uint32 tab_width = 4;
+
+	struct ColumnMark
+	{
+		uint32 offset;
+		uint32 column;
+
+		bool operator<(const ColumnMark& rhs) const { return offset < rhs.offset; }
+		bool operator==(const ColumnMark& rhs) const { return offset == rhs.offset && column == rhs.column; }
+
+		template<typename Archive>
+		void serialize(Archive& ar, const unsigned int version)
+		{
+			UNUSED_ARGUMENT(version);
+			ar & offset;
+			ar & column;
+		}
+	};
+
+	SourceLineTable(const std::string& filename, const char* first, const char* last) : filename(filename), size(last - first)
+	{
+		uint32 base_offset = 0;
+		uint32 base_column = 1;
+		uint32 column = 1;
+
+		// '\n', "\r\n" and a lone '\r' all terminate a line
+		line_offsets.push_back(0);
+		for(const char* c = first; c != last; ++c)
+		{
+			uint32 offset = c - first;
+			if((*c & 0xC0) == 0x80) // UTF-8 continuation byte
+				continue;
+
+			if(column != base_column + (offset - base_offset))
+			{
+				ColumnMark mark = { offset, column };
+				column_marks.push_back(mark);
+				base_offset = offset;
+				base_column = column;
+			}
+
+			if(*c == '\n' || (*c == '\r' && (c + 1 == last || c[1] != '\n')))
+			{
+				line_offsets.push_back(offset + 1);
+				base_offset = offset + 1;
+				base_column = column = 1;
+			}
+			else if(*c == '\t')
+				column += tab_width - (column - 1) % tab_width;
+			else
+				++column;
+		}
+
+		if(column != base_column + (size - base_offset))
+		{
+			ColumnMark mark = { size, column };
+			column_marks.push_back(mark);
+		}
+	}
+
+	void locate(uint32 offset, uint32& line, uint32& column) const
+	{
+		offset = std::min(offset, size);
+
+		std::vector<uint32>::const_iterator l = std::upper_bound(line_offsets.begin(), line_offsets.end(), offset);
+		uint32 line_offset = *(l - 1);
+		line = l - line_offsets.begin();
+
+		ColumnMark key = { offset, 0 };
+		std::vector<ColumnMark>::const_iterator m = std::upper_bound(column_marks.begin(), column_marks.end(), key);
+		if(m != column_marks.begin() && (m - 1)->offset >= line_offset)
+			column = (m - 1)->column + (offset - (m - 1)->offset);
+		else
+			column = 1 + (offset - line_offset);
+	}
+
+	bool isEqual(const SourceLineTable& rhs) const
+	{
+		return filename == rhs.filename && size == rhs.size && line_offsets == rhs.line_offsets && column_marks == rhs.column_marks;
+	}
+
+	template<typename Archive>
+	void serialize(Archive& ar, const unsigned int version)
+	{
+		UNUSED_ARGUMENT(version);
+		ar & filename;
+		ar & size;
+		ar & line_offsets;
+		ar & column_marks;
+	}
+
+	std::string filename;
+	uint32 size;
+	std::vector<uint32> line_offsets;      // byte offset every line starts at
+	std::vector<ColumnMark> column_marks; // sorted by offset
+
+private:
+	SourceLineTable() : size(0)
+	{ }
+};
+
+/**
+ * SourceTable numbers the line tables of the source files of a compilation, so a source location
+ * only has to store the number of its file (see SourceInfoContext)
+ *
+ * Every CompilationSession owns one and makes it the active table while it is entered, so the
+ * tables go away with the compilation; outside of a session a process-wide table is used. The
+ * table never shrinks while it lives, so locations stay valid across the arenas and the trees
+ * merged within the compilation. A file registered again with identical content gets its
+ * previous number back.
+ *
+ * Registering is thread-safe. Looking up doesn't lock: tables are stored in chunks which are
+ * never moved nor freed before the table, a number is published only once its slot is set, and
+ * a replaced table is kept until the end.
+ */
+struct SourceTable : boost::noncopyable
+{
+	/**
+	 * Make the given table the active one on the calling thread
+	 */
+	struct Scope : boost::noncopyable
+	{
+		explicit Scope(SourceTable& table) : previous(active())
+		{
+			active() = &table;
+		}
+
+		~Scope()
+		{
+			active() = previous;
+		}
+
+	private:
+		SourceTable* previous;
+	};
+
+	SourceTable() : count(0)
+	{ }
+
+	/// the table active on the calling thread, the process-wide one if there's none
+	static SourceTable& instance()
+	{
+		if(SourceTable* table = active())
+			return *table;
+
+		static SourceTable global;
+		return global;
+	}
+
+	/// @return the number of the given table
+	uint32 add(const shared_ptr<SourceLineTable>& table)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return insert(table);
+	}
+
+	/**
+	 * Register a table allocated while loading an archive
+	 *
+	 * The archive hands out the same pointer for every location of the same file, so the pointer
+	 * is remembered; the table is owned by SourceTable from now on.
+	 */
+	uint32 adopt(SourceLineTable* table)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::map<const SourceLineTable*, uint32>::const_iterator i = loaded.find(table);
+		if(i != loaded.end())
+			return i->second;
+
+		shared_ptr<SourceLineTable> owned(table);
+		uint32 index = insert(owned);
+		if(slot(index) != table)
+		{
+			// a duplicate: only its address must stay reserved
+			owned->line_offsets = std::vector<uint32>();
+			owned->column_marks = std::vector<SourceLineTable::ColumnMark>();
+			tables.push_back(owned);
+		}
+
+		loaded.insert(std::make_pair(table, index));
+		return index;
+	}
+
+	/**
+	 * Put the new content of a file in place of the table of the given number, so a file edited
+	 * again and again (see ThorScriptParserStage::reparse()) keeps its number
+	 *
+	 * Locations of the number are resolved against the new table from now on. The previous table
+	 * stays allocated, lookups made before may still hold it.
+	 */
+	void replace(uint32 index, const shared_ptr<SourceLineTable>& table)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		BOOST_ASSERT(index < count.load(std::memory_order_relaxed) && "replacing an unregistered source");
+
+		const SourceLineTable* previous = slot(index);
+		typedef std::multimap<std::string, uint32>::iterator iterator;
+		std::pair<iterator, iterator> entries = by_filename.equal_range(previous->filename);
+		for(iterator i = entries.first; i != entries.second; ++i)
+		{
+			if(i->second == index)
+			{
+				by_filename.erase(i);
+				break;
+			}
+		}
+
+		tables.push_back(table);
+		by_filename.insert(std::make_pair(table->filename, index));
+		setSlot(index, table.get());
+	}
+
+	/// @return the table of the given number, NULL if there's none; valid as long as SourceTable
+	const SourceLineTable* get(uint32 index) const
+	{
+		if(index >= count.load(std::memory_order_acquire))
+			return NULL;
+		return slot(index);
+	}
+
+	std::size_t size() const
+	{
+		return count.load(std::memory_order_acquire);
+	}
+
+private:
+	// chunk k holds the numbers [first_chunk_size * (2^k - 1), first_chunk_size * (2^(k+1) - 1))
+	static const uint32 first_chunk_bits = 6;
+	static const uint32 max_chunks = 32 - first_chunk_bits;
+
+	static SourceTable*& active()
+	{
+		static __thread SourceTable* table = NULL;
+		return table;
+	}
+
+	static void position(uint32 index, uint32& chunk, uint32& offset)
+	{
+		uint32 n = (index >> first_chunk_bits) + 1;
+		chunk = 31 - __builtin_clz(n);
+		offset = index - (((1u << chunk) - 1) << first_chunk_bits);
+	}
+
+	const SourceLineTable* slot(uint32 index) const
+	{
+		uint32 chunk = 0, offset = 0;
+		position(index, chunk, offset);
+		return chunks[chunk][offset].load(std::memory_order_acquire);
+	}
+
+	void setSlot(uint32 index, const SourceLineTable* table)
+	{
+		uint32 chunk = 0, offset = 0;
+		position(index, chunk, offset);
+		chunks[chunk][offset].store(table, std::memory_order_release);
+	}
+
+	uint32 insert(const shared_ptr<SourceLineTable>& table)
+	{
+		typedef std::multimap<std::string, uint32>::const_iterator iterator;
+		std::pair<iterator, iterator> candidates = by_filename.equal_range(table->filename);
+		for(iterator i = candidates.first; i != candidates.second; ++i)
+		{
+			if(slot(i->second)->isEqual(*table))
+				return i->second;
+		}
+
+		uint32 index = count.load(std::memory_order_relaxed);
+		uint32 chunk = 0, offset = 0;
+		position(index, chunk, offset);
+		BOOST_ASSERT(chunk < max_chunks && "too many source files");
+		if(!chunks[chunk])
+			chunks[chunk].reset(new std::atomic<const SourceLineTable*>[1u << (first_chunk_bits + chunk)]);
+
+		chunks[chunk][offset].store(table.get(), std::memory_order_relaxed);
+		tables.push_back(table);
+		by_filename.insert(std::make_pair(table->filename, index));
+
+		// publish the slot to the lookups
+		count.store(index + 1, std::memory_order_release);
+		return index;
+	}
+
+	std::unique_ptr<std::atomic<const SourceLineTable*>[]> chunks[max_chunks];
+	std::atomic<uint32> count;
+
+	// the rest is only touched by registering, under the lock
+	std::mutex mutex;
+	std::vector<shared_ptr<SourceLineTable>> tables; // owned, replaced ones and duplicates adopted from archives included
+	std::multimap<std::string, uint32> by_filename;
+	std::map<const SourceLineTable*, uint32> loaded;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_PARSER_SOURCELINETABLE_H_ */
@@ -22,7 +22,10 @@
 
 #include "language/stage/Stage.h"
 #include "language/stage/parser/context/SourceInfoContext.h"
+#include "language/stage/parser/ParseCache.h"
 #include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
 
 namespace zillians { namespace language { namespace stage {
 
@@ -38,10 +41,68 @@ public:
 	virtual bool parseOptions(po::variables_map& vm);
 	virtual bool execute(bool& continue_execution);
 
+public:
+	/**
+	 * One contiguous change to a source file: the bytes [offset, offset + length) of the previous
+	 * content are replaced by text (offsets don't count a leading UTF-8 BOM)
+	 */
+	struct TextEdit
+	{
+		TextEdit(std::size_t offset, std::size_t length, const std::string& text) : offset(offset), length(length), text(text)
+		{ }
+
+		std::size_t offset;
+		std::size_t length;
+		std::string text;
+	};
+
+	struct ReparseResult
+	{
+		std::vector<tree::ASTNode*> changed; // the new declarations, in source order
+		std::vector<tree::ASTNode*> removed; // the declarations no longer in the tree, replaced ones included
+	};
+
+	/**
+	 * Reparse only the top-level declarations of a previously parsed source which are touched by
+	 * the given edits, for resident compilers recompiling a file again and again
+	 *
+	 * The file must already hold the edited content, and the edits must be sorted and must not
+	 * overlap. Reparsed declarations are put in place of the old ones with replaceUseWith(), new
+	 * ones (typed in between two declarations for example) are inserted, and the locations of the
+	 * untouched ones are moved to match the new content. The new nodes end up in the arena of the
+	 * source. The file keeps its number in SourceTable, the new content takes its place only once
+	 * every edited declaration parsed, so locations held by the removed declarations (or by nodes
+	 * made up from the file by later stages) are not meaningful any more.
+	 *
+	 * @return false if the edits can't be applied incrementally (the imports are touched, the source
+	 *         was loaded from an AST file, or the edited declarations don't parse),
+	 *         in which case the tree is left untouched and the file needs a full parse
+	 */
+	bool reparse(tree::Source* source, const std::vector<TextEdit>& edits, ReparseResult& result);
+
 private:
-	bool parse(const boost::filesystem::path& p);
+	/**
+	 * One input file parsed into its own arena, waiting to be joined into the tangle
+	 */
+	struct ParsedSource
+	{
+		ParsedSource() : containing_package_id(NULL), source(NULL), active_package(NULL), succeeded(false)
+		{ }
+
+		boost::filesystem::path path;
+		shared_ptr<tree::ASTNodeGC> arena;
+		tree::Identifier* containing_package_id;
+		tree::Source* source;
+		tree::Package* active_package;
+		std::wstring diagnostics;
+		bool succeeded;
+	};
+
+	bool parse(ParsedSource& parsed);
 
 private:
+	uint32 parser_threads;
+	shared_ptr<ParseCache> parse_cache;
 	bool debug_parser;
 	bool debug_ast;
 	bool debug_ast_with_loc;
@@ -22,45 +22,171 @@
 
 #include "core/Prerequisite.h"
 #include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
+#include "language/stage/parser/SourceLineTable.h"
 #include "language/GlobalContext.h"
+#include <boost/serialization/split_member.hpp>
 
 namespace zillians { namespace language { namespace stage {
 
 /// SourceInfoContext will be stored in every AST Identifier, Statement, Expression, and Declaration
+/// (kept in the NodeContextTable side table rather than in ContextHub)
+///
+/// It's a single 32-bit word. Nodes created by the parser keep the number of their file in the
+/// SourceTable of the compilation and their byte offset, and line and column are looked up only
+/// when somebody asks for them. Nodes made up by later stages (and files too many or too large to
+/// be numbered, which the parser warns about) keep line and column as they are.
 struct SourceInfoContext
 {
 	friend class boost::serialization::access;
 
-	SourceInfoContext(uint32 l, uint32 c) : line(l), column(c)
+	// packed:  1 | file (11 bits) | byte offset (20 bits)
+	// literal: 0 | line (19 bits) | column (12 bits), both saturated
+	static const uint32 offset_bits = 20;
+	static const uint32 file_bits = 11;
+	static const uint32 column_bits = 12;
+	static const uint32 packed_flag = 0x80000000u;
+
+	static const uint32 max_offset = (1u << offset_bits) - 1;
+	static const uint32 max_file = (1u << file_bits) - 1;
+	static const uint32 max_column = (1u << column_bits) - 1;
+	static const uint32 max_line = (1u << (31 - column_bits)) - 1;
+
+	SourceInfoContext(uint32 line, uint32 column) : location(((line < max_line ? line : max_line) << column_bits) | (column < max_column ? column : max_column))
 	{ }
 
-	SourceInfoContext(const SourceInfoContext& ref) : line(ref.line), column(ref.column)
+	SourceInfoContext(const SourceInfoContext& ref) : location(ref.location)
 	{ }
 
+	/// location of the given byte offset of a file registered in SourceTable
+	static SourceInfoContext at(uint32 file, uint32 offset)
+	{
+		if(file <= max_file && offset <= max_offset)
+			return SourceInfoContext(packed_flag | (file << offset_bits) | offset);
+
+		uint32 line = 0, column = 0;
+		if(const SourceLineTable* lines = SourceTable::instance().get(file))
+			lines->locate(offset, line, column);
+		return SourceInfoContext(line, column);
+	}
+
 	static SourceInfoContext* get(tree::ASTNode* node)
 	{
-		return node->get<SourceInfoContext>();
+		return tree::NodeContextTable<SourceInfoContext>::get(node);
 	}
 
 	static void set(tree::ASTNode* node, SourceInfoContext* ctx)
 	{
-		node->set<SourceInfoContext>(ctx);
+		tree::NodeContextTable<SourceInfoContext>::set(node, ctx);
 	}
 
-    template<typename Archive>
-    void serialize(Archive& ar, unsigned int version)
-    {
-    	UNUSED_ARGUMENT(version);
+	static SourceInfoContext* set(tree::ASTNode* node, const SourceInfoContext& ctx)
+	{
+		return tree::NodeContextTable<SourceInfoContext>::assign(node, ctx);
+	}
 
-    	ar & line;
-    	ar & column;
-    }
+	bool isPacked() const { return (location & packed_flag) != 0; }
+	uint32 file() const   { return (location & ~packed_flag) >> offset_bits; }
+	uint32 offset() const { return location & max_offset; }
 
-	uint32 line;
-	uint32 column;
+	void locate(uint32& line, uint32& column) const
+	{
+		if(!isPacked())
+		{
+			line = location >> column_bits;
+			column = location & max_column;
+		}
+		else if(const SourceLineTable* lines = SourceTable::instance().get(file()))
+		{
+			lines->locate(offset(), line, column);
+		}
+		else
+		{
+			line = column = 0;
+		}
+	}
+
+	uint32 line() const
+	{
+		uint32 line = 0, column = 0;
+		locate(line, column);
+		return line;
+	}
+
+	uint32 column() const
+	{
+		uint32 line = 0, column = 0;
+		locate(line, column);
+		return column;
+	}
+
+	/// order by position, locations in the same file are compared without being looked up
+	int compare(const SourceInfoContext& rhs) const
+	{
+		if(isPacked() && rhs.isPacked() && file() == rhs.file())
+			return (offset() < rhs.offset()) ? -1 : (offset() > rhs.offset()) ? 1 : 0;
+
+		uint32 lhs_line = 0, lhs_column = 0, rhs_line = 0, rhs_column = 0;
+		locate(lhs_line, lhs_column);
+		rhs.locate(rhs_line, rhs_column);
+		if(lhs_line != rhs_line)
+			return (lhs_line < rhs_line) ? -1 : 1;
+		return (lhs_column < rhs_column) ? -1 : (lhs_column > rhs_column) ? 1 : 0;
+	}
+
+	// file numbers are only meaningful within the compilation, so the line table of the file goes
+	// along (once per archive, the archive tracks the pointer) and is registered again on load
+	template<typename Archive>
+	void save(Archive& ar, const unsigned int version) const
+	{
+		UNUSED_ARGUMENT(version);
+
+		bool packed = isPacked();
+		ar & packed;
+		if(packed)
+		{
+			const SourceLineTable* lines = SourceTable::instance().get(file());
+			uint32 position = offset();
+			ar & lines;
+			ar & position;
+		}
+		else
+		{
+			ar & location;
+		}
+	}
+
+	template<typename Archive>
+	void load(Archive& ar, const unsigned int version)
+	{
+		UNUSED_ARGUMENT(version);
+
+		bool packed = false;
+		ar & packed;
+		if(packed)
+		{
+			SourceLineTable* lines = NULL;
+			uint32 position = 0;
+			ar & lines;
+			ar & position;
+			*this = lines ? at(SourceTable::instance().adopt(lines), position) : SourceInfoContext(0, 0);
+		}
+		else
+		{
+			ar & location;
+		}
+	}
+
+	BOOST_SERIALIZATION_SPLIT_MEMBER();
+
+	uint32 location;
 
 private:
-	SourceInfoContext() { }
+	SourceInfoContext() : location(0)
+	{ }
+
+	explicit SourceInfoContext(uint32 location) : location(location)
+	{ }
 };
 
 } } }
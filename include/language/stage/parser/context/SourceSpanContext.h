@@ -0,0 +1,55 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_SOURCESPANCONTEXT_H_
+#define ZILLIANS_LANGUAGE_SOURCESPANCONTEXT_H_
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
+
+namespace zillians { namespace language { namespace stage {
+
+/// SourceSpanContext is stored in every top-level declaration created by the parser, so that the
+/// declaration can be reparsed alone once its file is edited (see ThorScriptParserStage::reparse())
+/// (kept in parse cache entries, see ParseCache; not in AST files, declarations loaded from one
+/// have none and need a full parse)
+struct SourceSpanContext
+{
+	SourceSpanContext(std::size_t b, std::size_t e, uint32 f) : begin(b), end(e), file(f)
+	{ }
+
+	static SourceSpanContext* get(tree::ASTNode* node)
+	{
+		return tree::NodeContextTable<SourceSpanContext>::get(node);
+	}
+
+	static SourceSpanContext* set(tree::ASTNode* node, const SourceSpanContext& ctx)
+	{
+		return tree::NodeContextTable<SourceSpanContext>::assign(node, ctx);
+	}
+
+	std::size_t begin; // byte offset of the first token (annotations included)
+	std::size_t end;   // byte offset right after the last token, trailing white spaces and comments excluded
+	uint32 file;       // number of the parsed content in SourceTable
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_SOURCESPANCONTEXT_H_ */
@@ -42,6 +42,8 @@ public:
 private:
 	bool enabled_load;
     std::vector<std::string> ast_files_to_load;
+	std::string prelude_file;
+	bool use_shared_cache;
 	std::vector<std::string> inputs;
 	bool dump_graphviz;
     std::string dump_graphviz_dir;
@@ -42,6 +42,8 @@ public:
 private:
 	bool enabled;
 	std::string ast_file;
+	std::string prelude_file;
+	std::vector<std::string> dependency_ast_files;
 };
 
 } } }
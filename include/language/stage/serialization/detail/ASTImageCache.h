@@ -0,0 +1,69 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_ASTIMAGECACHE_H_
+#define ZILLIANS_LANGUAGE_STAGE_ASTIMAGECACHE_H_
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNodeFactory.h"
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <boost/noncopyable.hpp>
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * ASTImageCache keeps dependency ASTs of in-process compile jobs (ts-make --in-process)
+ *
+ * Each .ast file is parsed once per process and kept as a binary image in memory (the same
+ * encoding as PreludeImage). Every job still decodes its own copy into its active arena, as
+ * merging tangles modifies the nodes, but that is far cheaper than reading the text archive
+ * again. Entries are keyed by path and file stamp, so a rewritten file is picked up again.
+ */
+class ASTImageCache : boost::noncopyable
+{
+public:
+	static ASTImageCache& instance();
+
+	/// decode the given .ast file into the active arena, NULL if it can't be read
+	tree::Tangle* load(const std::string& filename);
+
+	void clear();
+
+private:
+	ASTImageCache() { }
+
+	shared_ptr<const std::string> image(const std::string& filename);
+
+private:
+	struct Entry
+	{
+		std::time_t mtime;
+		uintmax_t size;
+		shared_ptr<const std::string> image;
+	};
+
+	std::map<std::string, Entry> entries;
+	std::mutex mutex;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_ASTIMAGECACHE_H_ */
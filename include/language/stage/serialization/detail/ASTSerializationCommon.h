@@ -25,7 +25,7 @@
 #include "language/context/TransformerContext.h"
 #include "language/stage/parser/context/SourceInfoContext.h"
 #include "language/stage/transformer/context/ManglingStageContext.h"
-#include "core/ContextHubSerialization.h"
+#include "language/tree/NodeContextTable.h"
 #include "language/tree/ASTNodeSerialization.h"
 
 #include <boost/archive/text_oarchive.hpp>
@@ -33,8 +33,8 @@
 
 namespace zillians { namespace language { namespace stage { namespace visitor {
 
-// this defines all context object types needed to be de-serialized
-typedef ContextHubSerialization<
+// this defines all context object types needed to be de-serialized (all of them are stored in NodeContextTable)
+typedef tree::NodeContextTableSerialization<
 			boost::mpl::vector<
 				ResolvedType,
 				ResolvedSymbol,
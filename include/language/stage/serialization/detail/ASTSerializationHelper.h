@@ -32,6 +32,32 @@ public:
 	static bool serialize(const std::string& filename, tree::ASTNode* node);
 	static tree::ASTNode* deserialize(const std::string& filename);
 
+	/**
+	 * SHA1 of what other tangles can see from the given tree
+	 *
+	 * Bodies of non-template functions are compiled into the tangle's own bitcode and never looked
+	 * at by dependents, so they are left out; everything else is hashed in serialized form (source
+	 * locations are contexts and not part of it). ts-make rebuilds dependents only when this changes.
+	 */
+	static std::string interfaceFingerprint(tree::ASTNode* node);
+
+	/**
+	 * interfaceFingerprint() of the tree folded with the interface fingerprints of the ASTs it was
+	 * compiled against
+	 *
+	 * Resolved types and symbols of the tree refer into the imported tangles, which are not
+	 * serialized along with it, so a changed typedef or class layout of a dependency changes what
+	 * the tree means but not the tree itself. Folding the dependencies in makes the fingerprint
+	 * change transitively.
+	 */
+	static std::string interfaceFingerprint(tree::ASTNode* node, const std::vector<std::string>& dependency_fingerprints);
+
+	/**
+	 * The interface fingerprint stored next to the given AST file (<ast>.interface), or the SHA1
+	 * of the AST file itself if there is none, e.g. for ASTs from bundles; empty if neither can be read
+	 */
+	static std::string readInterfaceFingerprint(const std::string& ast_file);
+
 private:
 	ASTSerializationHelper() { }
 };
@@ -0,0 +1,57 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_STAGE_PRELUDEIMAGE_H_
+#define ZILLIANS_LANGUAGE_STAGE_PRELUDEIMAGE_H_
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/stage/serialization/detail/ASTSerializationCommon.h"
+
+namespace zillians { namespace language { namespace stage {
+
+/**
+ * PreludeImage stores a resolved and mangled tangle (the system API, built along with the
+ * compiler) in a binary form which every ts-compile loads instead of parsing and resolving
+ * the system API sources again
+ *
+ * The image is a small header followed by a boost binary archive of the tangle and all the
+ * contexts in FullSerializer. Nodes refer to each other by object id in the archive, so the
+ * image doesn't depend on where it's mapped; it's mapped read-only and shared, so concurrent
+ * ts-compile processes read the very same pages.
+ */
+class PreludeImage
+{
+public:
+	static bool write(const std::string& filename, tree::Tangle* tangle);
+
+	/// load the image into the active arena, NULL if the file is missing, truncated or built by another version
+	static tree::Tangle* load(const std::string& filename);
+
+	/// the archived tree alone, without the image header, for images kept in memory (see ASTImageCache)
+	static bool encode(std::ostream& out, tree::Tangle* tangle);
+	static tree::Tangle* decode(const char* data, std::size_t size);
+
+private:
+	PreludeImage() { }
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_STAGE_PRELUDEIMAGE_H_ */
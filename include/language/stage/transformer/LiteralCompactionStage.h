@@ -20,12 +20,19 @@
 #ifndef ZILLIANS_LANGUAGE_STAGE_TRANSFORMER_LITERALCOMPACTIONSTAGE_H_
 #define ZILLIANS_LANGUAGE_STAGE_TRANSFORMER_LITERALCOMPACTIONSTAGE_H_
 
-#include "language/stage/Stage.h"
+#include "language/stage/FusableStage.h"
 
 namespace zillians { namespace language { namespace stage {
 
-class LiteralCompactionStage : public Stage
+namespace visitor {
+struct LiteralCompactionStageVisitor;
+}
+
+class LiteralCompactionStage : public FusableStage
 {
+public:
+	static const bool pre_order_traversal = true;
+
 public:
 	LiteralCompactionStage();
 	virtual ~LiteralCompactionStage();
@@ -34,12 +41,14 @@ public:
 	virtual const char* name();
 	virtual std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_description>> getOptions();
 	virtual bool parseOptions(po::variables_map& vm);
-	virtual bool execute(bool& continue_execution);
+	virtual bool prepareTraversal(tree::visitor::GenericDoubleVisitor*& walker);
+	virtual bool finishTraversal(bool& continue_execution);
 
 private:
 	bool debug;
 	bool dump_graphviz;
     std::string dump_graphviz_dir;
+	shared_ptr<visitor::LiteralCompactionStageVisitor> compactor;
 };
 
 } } }
@@ -20,12 +20,19 @@
 #ifndef ZILLIANS_LANGUAGE_STAGE_TRANSFORMER_MANGLINGSTAGE_H_
 #define ZILLIANS_LANGUAGE_STAGE_TRANSFORMER_MANGLINGSTAGE_H_
 
-#include "language/stage/Stage.h"
+#include "language/stage/FusableStage.h"
 
 namespace zillians { namespace language { namespace stage {
 
-class ManglingStage : public Stage
+namespace visitor {
+struct ManglingStageVisitor;
+}
+
+class ManglingStage : public FusableStage
 {
+public:
+	static const bool pre_order_traversal = true;
+
 public:
 	ManglingStage();
 	virtual ~ManglingStage();
@@ -34,10 +41,12 @@ public:
 	virtual const char* name();
 	virtual std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_description>> getOptions();
 	virtual bool parseOptions(po::variables_map& vm);
-	virtual bool execute(bool& continue_execution);
+	virtual bool prepareTraversal(tree::visitor::GenericDoubleVisitor*& walker);
+	virtual bool finishTraversal(bool& continue_execution);
 
 private:
 	bool disable_mangling;
+	shared_ptr<visitor::ManglingStageVisitor> mangler;
 };
 
 } } }
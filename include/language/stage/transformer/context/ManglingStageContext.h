@@ -21,6 +21,7 @@
 #define ZILLIANS_LANGUAGE_STAGE_CONTEXT_MANGLINGSTAGECONTEXT_H_
 
 #include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
 
 namespace zillians { namespace language { namespace stage {
 
@@ -34,12 +35,12 @@ struct NameManglingContext
 
 	static NameManglingContext* get(tree::ASTNode* node)
 	{
-		return node->get<NameManglingContext>();
+		return tree::NodeContextTable<NameManglingContext>::get(node);
 	}
 
 	static void set(tree::ASTNode* node, NameManglingContext* ctx)
 	{
-		node->set<NameManglingContext>(ctx);
+		tree::NodeContextTable<NameManglingContext>::set(node, ctx);
 	}
 
     template<typename Archive>
@@ -65,12 +66,12 @@ struct TypeIdManglingContext
 
 	static TypeIdManglingContext* get(tree::ASTNode* node)
 	{
-		return node->get<TypeIdManglingContext>();
+		return tree::NodeContextTable<TypeIdManglingContext>::get(node);
 	}
 
 	static void set(tree::ASTNode* node, TypeIdManglingContext* ctx)
 	{
-		node->set<TypeIdManglingContext>(ctx);
+		tree::NodeContextTable<TypeIdManglingContext>::set(node, ctx);
 	}
 
     template<typename Archive>
@@ -96,12 +97,12 @@ struct SymbolIdManglingContext
 
 	static SymbolIdManglingContext* get(tree::ASTNode* node)
 	{
-		return node->get<SymbolIdManglingContext>();
+		return tree::NodeContextTable<SymbolIdManglingContext>::get(node);
 	}
 
 	static void set(tree::ASTNode* node, SymbolIdManglingContext* ctx)
 	{
-		node->set<SymbolIdManglingContext>(ctx);
+		tree::NodeContextTable<SymbolIdManglingContext>::set(node, ctx);
 	}
 
     template<typename Archive>
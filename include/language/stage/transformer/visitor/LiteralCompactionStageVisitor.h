@@ -43,7 +43,7 @@ struct LiteralCompactionStageVisitor : public GenericDoubleVisitor
 {
     CREATE_INVOKER(compactInvoker, apply)
 
-	LiteralCompactionStageVisitor() : program(NULL)
+	LiteralCompactionStageVisitor(Source* target = NULL) : program(NULL), target(target)
 	{
 		REGISTER_ALL_VISITABLE_ASTNODE(compactInvoker)
 	}
@@ -55,6 +55,9 @@ struct LiteralCompactionStageVisitor : public GenericDoubleVisitor
 
 	void apply(Source& node)
 	{
+		if(target && &node != target)
+			return;
+
 		program = &node;
 		revisit(node);
 	}
@@ -105,6 +108,7 @@ struct LiteralCompactionStageVisitor : public GenericDoubleVisitor
 	}
 
 	Source* program;
+	Source* target;
 };
 
 } } } }
@@ -42,11 +42,18 @@ struct ManglingStageVisitor : public GenericDoubleVisitor
 {
     CREATE_INVOKER(mangleInvoker, apply)
 
-	ManglingStageVisitor() : next_type_id(1024), next_symbol_id(0)
+	/**
+	 * Declarations of imported tangles keep the ids they were compiled (and their stubs were
+	 * generated) with, so numbering starts past them (see Tangle::next_type_id)
+	 */
+	ManglingStageVisitor(uint64 first_type_id = 1024, uint64 first_symbol_id = 0) : next_type_id(std::max<uint64>(first_type_id, 1024)), next_symbol_id(first_symbol_id)
 	{
 		REGISTER_ALL_VISITABLE_ASTNODE(mangleInvoker)
 	}
 
+	uint64 nextTypeId() const   { return next_type_id; }
+	uint64 nextSymbolId() const { return next_symbol_id; }
+
 	void apply(ASTNode& node)
 	{
 		revisit(node);
@@ -20,18 +20,25 @@
 #ifndef ZILLIANS_LANGUAGE_STAGE_VERIFIER_SEMANTICVERIFICATIONSTAGE0_H_
 #define ZILLIANS_LANGUAGE_STAGE_VERIFIER_SEMANTICVERIFICATIONSTAGE0_H_
 
-#include "language/stage/Stage.h"
+#include "language/stage/FusableStage.h"
 #include "language/resolver/Resolver.h"
 
 namespace zillians { namespace language { namespace stage {
 
+namespace visitor {
+struct SemanticVerificationStageVisitor0;
+}
+
 /**
  * The SemanticVerificationStage0 is run right after the parsing, so there's zero type information available.
  *
  * For all type-related semantic checks, we need to put it into SemanticVerificationStage1
  */
-class SemanticVerificationStage0 : public Stage
+class SemanticVerificationStage0 : public FusableStage
 {
+public:
+	static const bool pre_order_traversal = false;
+
 public:
 	SemanticVerificationStage0();
 	virtual ~SemanticVerificationStage0();
@@ -40,7 +47,11 @@ public:
 	virtual const char* name();
 	virtual std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_description>> getOptions();
 	virtual bool parseOptions(po::variables_map& vm);
-	virtual bool execute(bool& continue_execution);
+	virtual bool prepareTraversal(tree::visitor::GenericDoubleVisitor*& walker);
+	virtual bool finishTraversal(bool& continue_execution);
+
+private:
+	shared_ptr<visitor::SemanticVerificationStageVisitor0> verifier;
 };
 
 } } }
@@ -20,16 +20,23 @@
 #ifndef ZILLIANS_LANGUAGE_STAGE_VERIFIER_SEMANTICVERIFICATIONSTAGE1_H_
 #define ZILLIANS_LANGUAGE_STAGE_VERIFIER_SEMANTICVERIFICATIONSTAGE1_H_
 
-#include "language/stage/Stage.h"
+#include "language/stage/FusableStage.h"
 #include "language/resolver/Resolver.h"
 
 namespace zillians { namespace language { namespace stage {
 
+namespace visitor {
+struct SemanticVerificationStageVisitor1;
+}
+
 /**
  * The SemanticVerificationStage1 is run right after type/symbol resolution, so we have to check if all resolved information is correct
  */
-class SemanticVerificationStage1 : public Stage
+class SemanticVerificationStage1 : public FusableStage
 {
+public:
+	static const bool pre_order_traversal = false;
+
 public:
 	SemanticVerificationStage1();
 	virtual ~SemanticVerificationStage1();
@@ -38,7 +45,11 @@ public:
 	virtual const char* name();
 	virtual std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_description>> getOptions();
 	virtual bool parseOptions(po::variables_map& vm);
-	virtual bool execute(bool& continue_execution);
+	virtual bool prepareTraversal(tree::visitor::GenericDoubleVisitor*& walker);
+	virtual bool finishTraversal(bool& continue_execution);
+
+private:
+	shared_ptr<visitor::SemanticVerificationStageVisitor1> verifier;
 };
 
 } } }
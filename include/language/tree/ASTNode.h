@@ -28,8 +28,10 @@
 #include "core/Visitor.h"
 #include "utility/Foreach.h"
 #include "language/tree/GarbageCollector.h"
+#include "language/tree/DenseNodeSet.h"
 #include <boost/noncopyable.hpp>
 #include <boost/preprocessor.hpp>
+#include <boost/static_assert.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/serialization/base_object.hpp>
@@ -42,22 +44,86 @@
 #include <boost/mpl/not.hpp>
 #include <boost/type_traits.hpp>
 
+/**
+ * The ASTNode type hierarchy as (type, parent type) pairs, the root being its own parent
+ *
+ * ASTNodeType values are generated from this table and numbered in pre-order, so every type
+ * derived from T (T included) falls into [T::type_range_first, T::type_range_last] and isa<T>()
+ * is a range check. Adding a node type only takes a new line here plus DEFINE_HIERARCHY().
+ */
+#define ASTNODE_TYPE_HIERARCHY \
+	((ASTNode,             ASTNode)) \
+	((Annotation,          ASTNode)) \
+	((Annotations,         ASTNode)) \
+	((Internal,            ASTNode)) \
+	((Tangle,              ASTNode)) \
+	((Source,              ASTNode)) \
+	((Package,             ASTNode)) \
+	((Import,              ASTNode)) \
+	((Block,               ASTNode)) \
+	((Identifier,          ASTNode)) \
+	((SimpleIdentifier,    Identifier)) \
+	((NestedIdentifier,    Identifier)) \
+	((TemplatedIdentifier, Identifier)) \
+	((Literal,             ASTNode)) \
+	((NumericLiteral,      Literal)) \
+	((StringLiteral,       Literal)) \
+	((ObjectLiteral,       Literal)) \
+	((TypeSpecifier,       ASTNode)) \
+	((FunctionType,        ASTNode)) \
+	((Declaration,         ASTNode)) \
+	((ClassDecl,           Declaration)) \
+	((EnumDecl,            Declaration)) \
+	((InterfaceDecl,       Declaration)) \
+	((TypedefDecl,         Declaration)) \
+	((FunctionDecl,        Declaration)) \
+	((VariableDecl,        Declaration)) \
+	((TypenameDecl,        Declaration)) \
+	((Statement,           ASTNode)) \
+	((DeclarativeStmt,     Statement)) \
+	((ExpressionStmt,      Statement)) \
+	((IterativeStmt,       Statement)) \
+	((ForStmt,             IterativeStmt)) \
+	((ForeachStmt,         IterativeStmt)) \
+	((WhileStmt,           IterativeStmt)) \
+	((SelectionStmt,       Statement)) \
+	((IfElseStmt,          SelectionStmt)) \
+	((SwitchStmt,          SelectionStmt)) \
+	((BranchStmt,          Statement)) \
+	((Expression,          ASTNode)) \
+	((PrimaryExpr,         Expression)) \
+	((UnaryExpr,           Expression)) \
+	((BinaryExpr,          Expression)) \
+	((TernaryExpr,         Expression)) \
+	((MemberExpr,          Expression)) \
+	((CallExpr,            Expression)) \
+	((CastExpr,            Expression))
+
+#define ASTNODE_TYPE_NAME(elem)   BOOST_PP_TUPLE_ELEM(2, 0, elem)
+#define ASTNODE_TYPE_PARENT(elem) BOOST_PP_TUPLE_ELEM(2, 1, elem)
+
+#define DEFINE_HIERARCHY_TYPE_RANGE(self) \
+	enum \
+	{ \
+		type_range_first = detail::ASTNodeTypeOrder<detail::ASTNodeTypeId::self>::first, \
+		type_range_last  = detail::ASTNodeTypeOrder<detail::ASTNodeTypeId::self>::last \
+	};
+
 #define DEFINE_HIERARCHY_BASE() \
+	DEFINE_HIERARCHY_TYPE_RANGE(ASTNode) \
 	static int stype() \
 	{ \
 		return (int)ASTNodeType::ASTNode; \
-	} \
-	virtual bool checkType(int type) const = 0;
-
-#define DEFINE_HIERARCHY_STATIC_IMPL(r, data, i, elem)	\
-	BOOST_PP_IIF(BOOST_PP_EQUAL(i, 0), BOOST_PP_EMPTY(), ||)			  \
-	(boost::is_same<Base,elem>::value)
+	}
 
-#define DEFINE_HIERARCHY_DYNAMIC_IMPL(r, data, i, elem)	\
-	BOOST_PP_IIF(BOOST_PP_EQUAL(i, 0), BOOST_PP_EMPTY(), ||)			  \
-	(type == (int)ASTNodeType::elem)
+#define DEFINE_HIERARCHY_CHECK_IMPL(r, self, i, elem)	\
+	BOOST_PP_IIF(BOOST_PP_EQUAL(i, 0), BOOST_PP_EMPTY(), &&)			  \
+	((int)ASTNodeType::elem <= (int)ASTNodeType::self && (int)ASTNodeType::self <= (int)detail::ASTNodeTypeOrder<detail::ASTNodeTypeId::elem>::last)
 
+// the hierarchy given here is only checked against ASTNODE_TYPE_HIERARCHY at compile time
 #define DEFINE_HIERARCHY(self, hierarchy)	\
+	DEFINE_HIERARCHY_TYPE_RANGE(self) \
+	BOOST_STATIC_ASSERT((BOOST_PP_SEQ_FOR_EACH_I(DEFINE_HIERARCHY_CHECK_IMPL, self, hierarchy))); \
 	virtual const char* instanceName() const \
 	{ \
 		return #self; \
@@ -65,10 +131,6 @@
 	static int stype() \
 	{ \
 		return (int)ASTNodeType::self; \
-	} \
-	virtual bool checkType(int type) const\
-	{ \
-		return ((BOOST_PP_SEQ_FOR_EACH_I(DEFINE_HIERARCHY_DYNAMIC_IMPL, _, hierarchy))) ? true : false; \
 	}
 
 namespace zillians { namespace language { namespace tree {
@@ -80,18 +142,121 @@ struct ASTNode;
 
 namespace zillians { namespace language { namespace tree {
 
-typedef unordered_set<const ASTNode*> ASTNodeSet;
+typedef DenseNodeSet ASTNodeSet;
+
+namespace detail {
+
+#define ASTNODE_TYPE_ID_IMPL(r, data, elem) ASTNODE_TYPE_NAME(elem),
+
+// ids in the order of ASTNODE_TYPE_HIERARCHY, only used to compute the pre-order numbering
+struct ASTNodeTypeId
+{
+	enum type
+	{
+		BOOST_PP_SEQ_FOR_EACH(ASTNODE_TYPE_ID_IMPL, _, ASTNODE_TYPE_HIERARCHY)
+		count
+	};
+};
+
+#undef ASTNODE_TYPE_ID_IMPL
+
+template<int Id>
+struct ASTNodeTypeParent;
+
+#define ASTNODE_TYPE_PARENT_IMPL(r, data, elem) \
+	template<> \
+	struct ASTNodeTypeParent<ASTNodeTypeId::ASTNODE_TYPE_NAME(elem)> \
+	{ \
+		static const int value = ASTNodeTypeId::ASTNODE_TYPE_PARENT(elem); \
+	};
+
+BOOST_PP_SEQ_FOR_EACH(ASTNODE_TYPE_PARENT_IMPL, _, ASTNODE_TYPE_HIERARCHY)
+
+#undef ASTNODE_TYPE_PARENT_IMPL
+
+// whether Id is Ancestor or derives from it
+template<int Id, int Ancestor, bool Done = (Id == Ancestor || ASTNodeTypeParent<Id>::value == Id)>
+struct ASTNodeTypeIsA
+{
+	static const int value = ASTNodeTypeIsA<ASTNodeTypeParent<Id>::value, Ancestor>::value;
+};
+
+template<int Id, int Ancestor>
+struct ASTNodeTypeIsA<Id, Ancestor, true>
+{
+	static const int value = (Id == Ancestor) ? 1 : 0;
+};
+
+// number of types derived from Id (Id included) among the ids [From, count)
+template<int Id, int From = 0>
+struct ASTNodeTypeSubtreeSize
+{
+	static const int value = ASTNodeTypeIsA<From, Id>::value + ASTNodeTypeSubtreeSize<Id, From + 1>::value;
+};
+
+template<int Id>
+struct ASTNodeTypeSubtreeSize<Id, ASTNodeTypeId::count>
+{
+	static const int value = 0;
+};
+
+// total subtree size of the siblings of Id listed before it, starting from From
+template<int Id, int From = 0>
+struct ASTNodeTypePrecedingSiblingSize
+{
+	static const bool is_preceding_sibling = (From < Id && From != ASTNodeTypeParent<From>::value && ASTNodeTypeParent<From>::value == ASTNodeTypeParent<Id>::value);
+	static const int value = (is_preceding_sibling ? ASTNodeTypeSubtreeSize<From>::value : 0) + ASTNodeTypePrecedingSiblingSize<Id, From + 1>::value;
+};
+
+template<int Id>
+struct ASTNodeTypePrecedingSiblingSize<Id, ASTNodeTypeId::count>
+{
+	static const int value = 0;
+};
+
+// pre-order number of Id and of the last type derived from it
+template<int Id, bool IsRoot = (ASTNodeTypeParent<Id>::value == Id)>
+struct ASTNodeTypeOrder
+{
+	static const int first = ASTNodeTypeOrder<ASTNodeTypeParent<Id>::value>::first + 1 + ASTNodeTypePrecedingSiblingSize<Id>::value;
+	static const int last  = first + ASTNodeTypeSubtreeSize<Id>::value - 1;
+};
+
+template<int Id>
+struct ASTNodeTypeOrder<Id, true>
+{
+	static const int first = 0;
+	static const int last  = ASTNodeTypeSubtreeSize<Id>::value - 1;
+};
+
+}
+
+#define ASTNODE_TYPE_ENUM_IMPL(r, data, elem) \
+	ASTNODE_TYPE_NAME(elem) = detail::ASTNodeTypeOrder<detail::ASTNodeTypeId::ASTNODE_TYPE_NAME(elem)>::first,
+
+struct ASTNodeType
+{
+	enum type
+	{
+		BOOST_PP_SEQ_FOR_EACH(ASTNODE_TYPE_ENUM_IMPL, _, ASTNODE_TYPE_HIERARCHY)
+	};
+};
+
+#undef ASTNODE_TYPE_ENUM_IMPL
 
 /**
  * Helper template function to implement static type checking system
  *
+ * This is a range check on the pre-order numbered ASTNodeType of the node (see ASTNODE_TYPE_HIERARCHY).
+ *
  * @param ptr the pointer to check with
  * @return true if the given ptr is an instance of Derived type; false otherwise
  */
 template<typename Derived, typename Base>
 inline bool isa(Base* ptr)
 {
-	return ptr->checkType(Derived::stype());
+	const int type = (int)ptr->nodeType();
+	return (int)Derived::type_range_first <= type && type <= (int)Derived::type_range_last;
 }
 
 template<typename Derived, typename Base>
@@ -112,7 +277,7 @@ inline Derived* cast(Base* ptr)
 template<typename Derived, typename Base>
 inline bool isa(shared_ptr<Base>& ptr)
 {
-	return ptr->checkType(Derived::template stype<Base>());
+	return isa<Derived>(ptr.get());
 }
 
 template<typename Derived, typename Base>
@@ -124,63 +289,6 @@ inline shared_ptr<Derived> cast(shared_ptr<Base>& ptr)
 		return shared_ptr<Derived>();
 }
 
-struct ASTNodeType
-{
-	enum type 
-	{
-		ASTNode,
-
-		Annotation,
-		Annotations,
-		Internal,
-		Tangle,
-		Source,
-		Package,
-		Import,
-		Block,
-		Identifier,
-			SimpleIdentifier,
-			NestedIdentifier,
-			TemplatedIdentifier,
-		Literal,
-			NumericLiteral,
-			StringLiteral,
-			ObjectLiteral,
-		TypeSpecifier,
-		FunctionType,
-
-		Declaration,
-			ClassDecl,
-			EnumDecl,
-			InterfaceDecl,
-			TypedefDecl,
-			FunctionDecl,
-			VariableDecl,
-			TypenameDecl,
-
-		Statement,
-			DeclarativeStmt,
-			ExpressionStmt,
-			IterativeStmt,
-				ForStmt,
-				ForeachStmt,
-				WhileStmt,
-			SelectionStmt,
-				IfElseStmt,
-				SwitchStmt,
-			BranchStmt,
-
-		Expression,
-			PrimaryExpr,
-			UnaryExpr,
-			BinaryExpr,
-			TernaryExpr,
-			MemberExpr,
-			CallExpr,
-			CastExpr,
-	};
-};
-
 // forward declarations of all ASTNode implementations
 struct ASTNode;
 struct Annotation;
@@ -270,19 +378,76 @@ public:
 	virtual bool replaceUseWith(const ASTNode& from, const ASTNode& to, bool update_parent = true) = 0;
 
 public:
+	/**
+	 * Called with every node of a subtree being cloned and its copy, in post-order
+	 *
+	 * @see CloneHookScope
+	 */
+	typedef void (*CloneHook)(const ASTNode* from, ASTNode* to);
+
+	/**
+	 * Install a clone hook for the current thread, e.g. to copy the contexts of each node as it
+	 * gets cloned (see ASTNodeHelper::clone())
+	 */
+	struct CloneHookScope : boost::noncopyable
+	{
+		explicit CloneHookScope(CloneHook hook) : previous(activeCloneHook())
+		{
+			activeCloneHook() = hook;
+		}
+
+		~CloneHookScope()
+		{
+			activeCloneHook() = previous;
+		}
+
+		CloneHook previous;
+	};
+
 	/**
 	 * Clone the ASTNode and all of its descendants
 	 *
 	 * @return the cloned ASTNode
 	 */
-	virtual ASTNode* clone() const = 0;
+	ASTNode* clone() const
+	{
+		ASTNode* cloned = cloneImpl();
+		if(CloneHook hook = activeCloneHook())
+			hook(this, cloned);
+		return cloned;
+	}
 
+protected:
+	/**
+	 * Clone the node itself, calling clone() on its children
+	 */
+	virtual ASTNode* cloneImpl() const = 0;
+
+private:
+	static CloneHook& activeCloneHook()
+	{
+		static __thread CloneHook current = NULL;
+		return current;
+	}
+
+public:
 	/**
 	 * Print the actual instance name, primary used for debugging
 	 * @return the actual instance name
 	 */
 	virtual const char* instanceName() const = 0;
 
+	/**
+	 * Get the actual type of the node without a virtual call
+	 *
+	 * The type is set by the constructor of the concrete node type (see setNodeType()), so it's
+	 * ASTNodeType::ASTNode while the base class constructors run.
+	 */
+	ASTNodeType::type nodeType() const
+	{
+		return node_type;
+	}
+
 public:
     template<typename Archive>
     void serialize(Archive& ar, const unsigned int version)
@@ -292,14 +457,60 @@ public:
     	ar & parent;
     }
 
+public:
+	/**
+	 * All ASTNodes are placement-allocated into the active compilation arena
+	 *
+	 * @see GarbageCollector
+	 */
+	static void* operator new(std::size_t size)
+	{
+		return GarbageCollector<const ASTNode>::instance()->allocate(size);
+	}
+
+	static void operator delete(void* p)
+	{
+		GarbageCollector<const ASTNode>::deallocate(p);
+	}
+
 protected:
-	ASTNode() : parent(NULL)
+	ASTNode() : parent(NULL), node_id(GarbageCollector<const ASTNode>::instance()->acquireId()), node_type(ASTNodeType::ASTNode)
+	{ }
+
+	/**
+	 * Every constructor of a concrete node type starts with setNodeType(this)
+	 *
+	 * The type is taken from the class whose constructor is running, and only concrete (leaf)
+	 * types of ASTNODE_TYPE_HIERARCHY are accepted.
+	 */
+	template<typename Self>
+	void setNodeType(const Self*)
 	{
-		GarbageCollector<const ASTNode>::instance()->add(this);
+		BOOST_STATIC_ASSERT((int)Self::type_range_first == (int)Self::type_range_last);
+		node_type = (ASTNodeType::type)Self::stype();
+	}
+
+public:
+	/**
+	 * Contexts kept for the node in the side tables of its arena (see NodeContextTable) go along
+	 * with it, which requires every node to be allocated through operator new
+	 */
+	virtual ~ASTNode()
+	{
+		GarbageCollector<const ASTNode>::ownerOf(this)->forget(this);
 	}
 
 public:
 	ASTNode* parent;
+
+	/**
+	 * Dense id within the arena that allocated the node (not serialized), used by DenseNodeSet and DenseNodeMap
+	 */
+	uint32 node_id;
+
+private:
+	// ASTNodeType::ASTNode (abstract, so never a real node type) until the concrete constructor runs
+	ASTNodeType::type node_type;
 };
 
 // some internal helper function/templates
@@ -22,6 +22,7 @@
 
 #include <boost/filesystem.hpp>
 #include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
 #include "language/context/ParserContext.h"
 #include "language/context/ResolverContext.h"
 #include "language/context/TransformerContext.h"
@@ -57,7 +58,10 @@ struct ForeachVisitor : public visitor::GenericDoubleVisitor
 	void apply(ASTNode& node)
 	{
 		if(IncludeSelf || depth)
-			functor(node);
+		{
+			if(T* matched = cast<T>(&node))
+				functor(*matched);
+		}
 
 		if(RecursiveVisit || (!RecursiveVisit && !depth))
 		{
@@ -75,25 +79,34 @@ template<int N, typename ContextTypeList>
 struct ContextCloneImpl
 {
 	typedef typename boost::mpl::at<ContextTypeList, boost::mpl::int_<N-1> >::type ContextT;
-	static void clone(ASTNode* from, ASTNode* to)
+	static void clone(const ASTNode* from, ASTNode* to)
 	{
-		if(from->get<ContextT>())
-		{
-			ContextT* ctx = new ContextT(*from->get<ContextT>());
-			to->set<ContextT, ContextOwnership::transfer>(ctx);
-		}
+		if(ContextT* ctx = NodeContextTable<ContextT>::get(from))
+			NodeContextTable<ContextT>::assign(to, *ctx);
 		ContextCloneImpl<N-1, ContextTypeList>::clone(from, to);
 	}
+
+	// whether the arena of the given node has no context of any of the types at all
+	static bool empty(const ASTNode* node)
+	{
+		return NodeContextTable<ContextT>::of(node).size() == 0 && ContextCloneImpl<N-1, ContextTypeList>::empty(node);
+	}
 };
 
 template<typename ContextTypeList>
 struct ContextCloneImpl<0, ContextTypeList>
 {
-	static void clone(ASTNode* from, ASTNode* to)
+	static void clone(const ASTNode* from, ASTNode* to)
 	{
 		UNUSED_ARGUMENT(from);
 		UNUSED_ARGUMENT(to);
 	}
+
+	static bool empty(const ASTNode* node)
+	{
+		UNUSED_ARGUMENT(node);
+		return true;
+	}
 };
 
 }
@@ -107,48 +120,36 @@ struct ASTNodeHelper
 		visitor.visit(node);
 	}
 
+	/**
+	 * Clone the subtree along with the contexts of the given types
+	 *
+	 * The contexts are copied by a clone hook as each node gets cloned, or only for the root node
+	 * if RecursiveClone is false.
+	 */
 	template<typename ContextTypeList = detail::ContextToCloneTypeList, bool RecursiveClone = true>
 	static ASTNode* clone(ASTNode* from)
 	{
-		ASTNode* to = from->clone();
-		clone<ContextTypeList, RecursiveClone>(from, to);
-		return to;
-	}
+		typedef detail::ContextCloneImpl<boost::mpl::size<ContextTypeList>::value, ContextTypeList> CloneImpl;
 
-	template<typename ContextTypeList = detail::ContextToCloneTypeList, bool RecursiveClone = true>
-	static void clone(ASTNode* from, ASTNode* to)
-	{
-		if(RecursiveClone)
-		{
-            // collect from nodes
-            std::vector<ASTNode*> fromNodes;
-            foreachApply<ASTNode>(*from, [&fromNodes](ASTNode& node){
-                fromNodes.push_back(&node);
-            });
-            // collect to nodes
-            std::vector<ASTNode*> toNodes;
-            foreachApply<ASTNode>(*to, [&toNodes](ASTNode& node){
-                toNodes.push_back(&node);
-            });
-            BOOST_ASSERT(fromNodes.size() == toNodes.size());
-            // copy
-            for(size_t i=0; i != fromNodes.size(); ++i)
-            {
-                ASTNode* fromNode = fromNodes[i];
-                ASTNode* toNode   = toNodes[i];
-                detail::ContextCloneImpl<boost::mpl::size<ContextTypeList>::value, ContextTypeList>::clone(fromNode, toNode);
-            }
-		}
-		else
+		// nothing to copy, e.g. names are not mangled yet while templates get instantiated
+		if(CloneImpl::empty(from))
+			return from->clone();
+
+		if(!RecursiveClone)
 		{
-			detail::ContextCloneImpl<boost::mpl::size<ContextTypeList>::value, ContextTypeList>::clone(from, to);
+			ASTNode* to = from->clone();
+			CloneImpl::clone(from, to);
+			return to;
 		}
+
+		ASTNode::CloneHookScope scope(&CloneImpl::clone);
+		return from->clone();
 	}
 
 	static void propogateSourceInfo(ASTNode& to, ASTNode& from)
 	{
-		stage::SourceInfoContext* from_src_info = from.get<stage::SourceInfoContext>();
-		to.set<stage::SourceInfoContext>(new stage::SourceInfoContext(*from_src_info));
+		stage::SourceInfoContext* from_src_info = stage::SourceInfoContext::get(&from);
+		stage::SourceInfoContext::set(&to, *from_src_info);
 	}
 
 	static ASTNode* findUniqueTypeResolution(ASTNode* node)
@@ -496,8 +497,7 @@ struct ASTNodeHelper
 	{
 		BOOST_ASSERT(node && "null pointer exception");
 		const int32 max_depth = 20;
-		static tree::visitor::NodeInfoVisitor v(FQN ? max_depth : 1);
-		v.reset();
+		tree::visitor::NodeInfoVisitor v(FQN ? max_depth : 1);
 		v.visit(*node);
 		return v.stream.str();
 	}
@@ -0,0 +1,262 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_TREE_DENSENODESET_H_
+#define ZILLIANS_LANGUAGE_TREE_DENSENODESET_H_
+
+#include "core/Prerequisite.h"
+#include "utility/Foreach.h"
+#include "language/tree/GarbageCollector.h"
+#include <unordered_set>
+
+namespace zillians { namespace language { namespace tree {
+
+struct ASTNode;
+
+/**
+ * DenseNodeSet is a bitset indexed by ASTNode::node_id
+ *
+ * Node ids are handed out sequentially by the arena which allocates the node (see
+ * GarbageCollector), so a set of nodes from the same arena costs one bit per node and
+ * insert/count/erase are a shift and a mask instead of a hash operation.
+ *
+ * The interface mimics the subset of std::unordered_set used by the tree algorithms.
+ * Nodes from different arenas may share the same id, so only the nodes of one arena, the one
+ * given on construction or else the one of the first node inserted, are kept in the bitset;
+ * nodes of any other arena (trees of several arenas mixed, e.g. in tools comparing a loaded
+ * tree with a built one) fall back to a hash set. The raw id interface (insertId(), countId(),
+ * eraseId(), foreachId()) only sees the bitset.
+ */
+struct DenseNodeSet
+{
+	typedef GarbageCollector<const ASTNode> Arena;
+
+	DenseNodeSet() : arena(NULL), population(0)
+	{ }
+
+	DenseNodeSet(const Arena* arena, std::size_t id_count) : arena(arena), bits((id_count + bits_per_word - 1) / bits_per_word, 0), population(0)
+	{ }
+
+	template<typename T>
+	bool insert(const T* node)
+	{
+		const Arena* owner = Arena::ownerOf(node);
+		if(!arena)
+			arena = owner;
+
+		if(owner == arena)
+			return insertId(node->node_id);
+
+		if(!foreign.insert(node).second)
+			return false;
+		++population;
+		return true;
+	}
+
+	template<typename T>
+	std::size_t count(const T* node) const
+	{
+		if(Arena::ownerOf(node) == arena)
+			return countId(node->node_id);
+		return foreign.count(node);
+	}
+
+	template<typename T>
+	std::size_t erase(const T* node)
+	{
+		if(Arena::ownerOf(node) == arena)
+			return eraseId(node->node_id);
+
+		if(!foreign.erase(node))
+			return 0;
+		--population;
+		return 1;
+	}
+
+	bool insertId(uint32 id)
+	{
+		std::size_t word = id / bits_per_word;
+		uint64 mask = uint64(1) << (id % bits_per_word);
+
+		if(word >= bits.size())
+			bits.resize(std::max(word + 1, bits.size() * 2), 0);
+
+		if(bits[word] & mask)
+			return false;
+
+		bits[word] |= mask;
+		++population;
+		return true;
+	}
+
+	std::size_t countId(uint32 id) const
+	{
+		std::size_t word = id / bits_per_word;
+		if(word >= bits.size())
+			return 0;
+
+		return (bits[word] >> (id % bits_per_word)) & 1;
+	}
+
+	std::size_t eraseId(uint32 id)
+	{
+		std::size_t word = id / bits_per_word;
+		uint64 mask = uint64(1) << (id % bits_per_word);
+
+		if(word >= bits.size() || !(bits[word] & mask))
+			return 0;
+
+		bits[word] &= ~mask;
+		--population;
+		return 1;
+	}
+
+	/**
+	 * Invoke the given functor with every id in the set in ascending order
+	 */
+	template<typename F>
+	void foreachId(F f) const
+	{
+		for(std::size_t word = 0; word < bits.size(); ++word)
+		{
+			for(uint64 w = bits[word]; w != 0; w &= w - 1)
+				f(uint32(word * bits_per_word + __builtin_ctzll(w)));
+		}
+	}
+
+	std::size_t size() const
+	{
+		return population;
+	}
+
+	bool empty() const
+	{
+		return population == 0;
+	}
+
+	void clear()
+	{
+		std::fill(bits.begin(), bits.end(), 0);
+		foreign.clear();
+		population = 0;
+	}
+
+private:
+	static const std::size_t bits_per_word = 64;
+
+	const Arena* arena;
+	std::vector<uint64> bits;
+	std::unordered_set<const void*> foreign;
+	std::size_t population;
+};
+
+/**
+ * DenseNodeMap is a flat vector indexed by ASTNode::node_id, with a DenseNodeSet telling
+ * which slots are occupied
+ *
+ * Unlike DenseNodeSet there's no fallback, all keys must come from the same arena; the map is
+ * meant to live in that arena (see GarbageCollector::attachment() and NodeContextTable).
+ */
+template<typename Value>
+struct DenseNodeMap
+{
+	DenseNodeMap()
+	{ }
+
+	explicit DenseNodeMap(std::size_t id_count) : values(id_count), present(id_count)
+	{ }
+
+	template<typename T>
+	Value& operator[](const T* node)
+	{
+		uint32 id = node->node_id;
+		if(id >= values.size())
+			values.resize(std::max<std::size_t>(id + 1, values.size() * 2));
+
+		present.insertId(id);
+		return values[id];
+	}
+
+	template<typename T>
+	Value* find(const T* node)
+	{
+		uint32 id = node->node_id;
+		return present.countId(id) ? &values[id] : NULL;
+	}
+
+	template<typename T>
+	const Value* find(const T* node) const
+	{
+		uint32 id = node->node_id;
+		return present.countId(id) ? &values[id] : NULL;
+	}
+
+	template<typename T>
+	std::size_t count(const T* node) const
+	{
+		return present.countId(node->node_id);
+	}
+
+	template<typename T>
+	std::size_t erase(const T* node)
+	{
+		uint32 id = node->node_id;
+		if(!present.eraseId(id))
+			return 0;
+
+		values[id] = Value();
+		return 1;
+	}
+
+	std::size_t size() const
+	{
+		return present.size();
+	}
+
+	void clear()
+	{
+		values.clear();
+		present.clear();
+	}
+
+	/**
+	 * Move every entry of another map into this one, shifting its id by the given offset
+	 *
+	 * Used when the arena of the other map's keys is adopted (see GarbageCollector::adopt).
+	 */
+	void adopt(DenseNodeMap& other, uint32 id_offset)
+	{
+		if(other.values.size() + id_offset > values.size())
+			values.resize(other.values.size() + id_offset);
+
+		other.present.foreachId([&](uint32 id) {
+			present.insertId(id + id_offset);
+			values[id + id_offset] = std::move(other.values[id]);
+		});
+		other.clear();
+	}
+
+private:
+	std::vector<Value> values;
+	DenseNodeSet present;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_TREE_DENSENODESET_H_ */
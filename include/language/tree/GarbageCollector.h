@@ -25,29 +25,43 @@
 
 #include "core/Prerequisite.h"
 #include "core/Visitor.h"
-#include "core/Singleton.h"
 #include "utility/Foreach.h"
+#include <boost/noncopyable.hpp>
+#include <cstdlib>
 
 namespace zillians { namespace language { namespace tree {
 
+/**
+ * GarbageCollector is a per-compilation arena which owns every object of the Base hierarchy
+ *
+ * Objects are bump-allocated into large chunks (through the class-specific operator new of
+ * Base) instead of being registered into a global hash set one by one. Every slot carries a
+ * small header so that the live objects can still be enumerated for reachability checks (see
+ * GarbageCollectionVisitor) and a single object can still be deleted; its memory is reclaimed
+ * when the whole arena goes away.
+ *
+ * The arena used by new allocations is the one activated on the calling thread through
+ * GarbageCollector::Scope, or the process-wide default one if none is active.
+ */
 template<typename Base>
-struct GarbageCollectorWrapper
+struct GarbageCollector : boost::noncopyable
 {
-	GarbageCollectorWrapper(std::unordered_set<Base*>& reachable_set) : reachable_set(reachable_set)
-	{ }
-
-	inline void mark(Base* object)
+	struct Scope : boost::noncopyable
 	{
-		reachable_set.erase(object);
-	}
+		explicit Scope(GarbageCollector& gc) : previous(active())
+		{
+			active() = &gc;
+		}
 
-	std::unordered_set<Base*>& reachable_set;
-};
+		~Scope()
+		{
+			active() = previous;
+		}
 
-template<typename Base>
-struct GarbageCollector : Singleton<GarbageCollector<Base>, SingletonInitialization::automatic>
-{
-	GarbageCollector()
+		GarbageCollector* previous;
+	};
+
+	explicit GarbageCollector(std::size_t chunk_size = 1024*1024) : chunk_size(chunk_size), live_count(0), next_id(0)
 	{ }
 
 	~GarbageCollector()
@@ -55,71 +69,314 @@ struct GarbageCollector : Singleton<GarbageCollector<Base>, SingletonInitializat
 		cleanup();
 	}
 
-	bool find(Base* object)
+	static GarbageCollector* instance()
+	{
+		if(active())
+			return active();
+
+		static GarbageCollector default_instance;
+		return &default_instance;
+	}
+
+	void* allocate(std::size_t size)
 	{
-		auto it = objects.find(object);
-		return (it == objects.end());
+		std::size_t slot_size = align(header_size + size);
+
+		if(chunks.empty() || chunks.back().cursor + slot_size > chunks.back().end)
+			grow(slot_size);
+
+		Chunk& chunk = chunks.back();
+		Header* header = reinterpret_cast<Header*>(chunk.cursor);
+		header->owner = this;
+		header->size = slot_size;
+		header->alive = true;
+		chunk.cursor += slot_size;
+
+		++live_count;
+		return reinterpret_cast<char*>(header) + header_size;
 	}
 
-	void add(Base* object)
+	/**
+	 * The arena the given object was allocated in, which is not necessarily the active one
+	 */
+	static GarbageCollector* ownerOf(Base* object)
 	{
-		objects.insert(object);
+		const Header* header = reinterpret_cast<const Header*>(reinterpret_cast<const char*>(object) - header_size);
+		BOOST_ASSERT(header->alive && "object not allocated in an arena");
+		return header->owner;
 	}
 
-	void remove(Base* object)
+	/**
+	 * Let the attachments drop whatever they keep for the given object, which is being destroyed
+	 */
+	void forget(Base* object)
 	{
-		auto it = objects.find(object);
-		if(it != objects.end())
+		foreach(i, attachments)
 		{
-			objects.erase(it);
+			if(i->object)
+				i->forget(i->object.get(), object);
 		}
 	}
-//
-//  // for some reason the following code does not work due to buggy template support?
-//	template<typename MarkVisitor>
-//	void gc(Base* root)
-//	{
-//		std::unordered_set<Base*> temporary(objects);
-//
-//		MarkVisitor visitor_impl(GarbageCollectorWrapper<Base>(temporary));
-//		//visitor_impl;
-//		//visitor_impl.visit(*root);
-//		//visitor_impl.dummy();
-//
-//		printf("objects to remove = %ld\n", temporary.size());
-//		//foreach(i, temporary)
-//		for(auto i = temporary.begin(); i != temporary.end(); ++i)
-//		{
-//			remove(*i);
-//			delete *i;
-//		}
-//	}
-
-	void sweep(std::unordered_set<Base*>& nonreachable_set)
-	{
-		//printf("objects to remove = %ld\n", nonreachable_set.size());
-		//foreach(i, nonreachable_set)
-		for(auto i = nonreachable_set.begin(); i != nonreachable_set.end(); ++i)
+
+	static void deallocate(void* object)
+	{
+		if(!object) return;
+
+		Header* header = reinterpret_cast<Header*>(static_cast<char*>(object) - header_size);
+		BOOST_ASSERT(header->alive && "double deallocation of arena object");
+
+		header->alive = false;
+		--header->owner->live_count;
+	}
+
+	template<typename F>
+	void foreachObject(F f)
+	{
+		foreach(i, chunks)
 		{
-			remove(*i);
-			delete *i;
+			for(char* slot = i->begin; slot != i->cursor; slot += reinterpret_cast<Header*>(slot)->size)
+			{
+				if(reinterpret_cast<Header*>(slot)->alive)
+					f(reinterpret_cast<Base*>(slot + header_size));
+			}
 		}
 	}
 
-	std::size_t cleanup()
+	/**
+	 * Hand out the next dense id of this arena, which is used to index DenseNodeSet/DenseNodeMap
+	 */
+	uint32 acquireId()
+	{
+		return next_id++;
+	}
+
+	/**
+	 * @return the upper bound (exclusive) of all ids handed out so far
+	 */
+	std::size_t idCount() const
+	{
+		return next_id;
+	}
+
+	/**
+	 * Destroy every live object which is not in the given reachable set
+	 *
+	 * @param reachable_set the set of reachable objects, e.g. a DenseNodeSet filled by marking
+	 * @return the number of objects destroyed
+	 */
+	template<typename ReachableSet>
+	std::size_t sweep(const ReachableSet& reachable_set)
+	{
+		std::size_t object_count_to_remove = 0;
+		foreachObject([&](Base* object) {
+			if(!reachable_set.count(object))
+			{
+				delete object;
+				++object_count_to_remove;
+			}
+		});
+		return object_count_to_remove;
+	}
+
+	template<typename ReachableSet>
+	std::size_t countNonreachable(const ReachableSet& reachable_set)
+	{
+		std::size_t object_count = 0;
+		foreachObject([&](Base* object) {
+			if(!reachable_set.count(object))
+				++object_count;
+		});
+		return object_count;
+	}
+
+	/**
+	 * Get the instance of T which lives as long as the arena does (created on first use)
+	 *
+	 * This is used to keep per-compilation data indexed by node ids, e.g. NodeContextTable. T has
+	 * to provide adopt(T& other, uint32 id_offset), see adopt(), and forget(Base* object), see
+	 * forget().
+	 */
+	template<typename T>
+	T& attachment()
+	{
+		std::size_t index = attachmentIndex<T>();
+		if(index >= attachments.size())
+			attachments.resize(index + 1);
+
+		if(!attachments[index].object)
+		{
+			attachments[index].object = shared_ptr<void>(new T());
+			attachments[index].adopt = &adoptAttachment<T>;
+			attachments[index].forget = &forgetInAttachment<T>;
+		}
+
+		return *static_cast<T*>(attachments[index].object.get());
+	}
+
+	/**
+	 * Take over every object and attachment of another arena, e.g. one filled on a worker thread
+	 *
+	 * The adopted objects keep their addresses, but their ids are shifted past the ids of this
+	 * arena through renumber(object, offset), so adopting arenas in a fixed order hands out the
+	 * same ids as allocating their objects here in that order would. Attachments are merged
+	 * through T::adopt(T& other, uint32 id_offset). The other arena is left empty.
+	 */
+	template<typename Renumber>
+	void adopt(GarbageCollector& other, Renumber renumber)
 	{
-		std::size_t object_count_to_remove = objects.size();
-		// TODO somehow this is not supported by GCC 4.4, so we have to explicit specify the iterator types
-		//foreach(i, objects)
-		for(auto i = objects.begin(); i != objects.end(); ++i)
+		BOOST_ASSERT(&other != this);
+
+		uint32 offset = next_id;
+		foreach(i, other.chunks)
 		{
-			delete *i;
+			for(char* slot = i->begin; slot != i->cursor; slot += reinterpret_cast<Header*>(slot)->size)
+			{
+				Header* header = reinterpret_cast<Header*>(slot);
+				header->owner = this;
+				if(header->alive)
+					renumber(reinterpret_cast<Base*>(slot + header_size), offset);
+			}
 		}
-		objects.clear();
+
+		foreach(i, other.attachments)
+		{
+			if(i->object)
+				i->adopt(*this, i->object.get(), offset);
+		}
+
+		// keep allocating from our current chunk, whose tail is probably still free
+		chunks.insert(chunks.empty() ? chunks.end() : chunks.end() - 1, other.chunks.begin(), other.chunks.end());
+		live_count += other.live_count;
+		next_id += other.next_id;
+
+		other.chunks.clear();
+		other.attachments.clear();
+		other.live_count = 0;
+		other.next_id = 0;
+	}
+
+	/**
+	 * Destroy all live objects and release the memory of the arena
+	 *
+	 * @return the number of objects destroyed
+	 */
+	std::size_t cleanup()
+	{
+		// whatever the attachments keep for the objects goes along with them, not object by object
+		attachments.clear();
+
+		std::size_t object_count_to_remove = live_count;
+		foreachObject([](Base* object) { delete object; });
+		release();
 		return object_count_to_remove;
 	}
 
-	std::unordered_set<Base*> objects;
+	/**
+	 * Drop all chunks (and attachments such as context tables) at once without running any
+	 * node destructor, which takes O(#chunks)
+	 *
+	 * Only use this when nothing refers to the objects any more and whatever they own on the
+	 * heap (contexts, strings, containers) doesn't need to be freed, e.g. at the end of a
+	 * compilation right before the process exits.
+	 */
+	void release()
+	{
+		foreach(i, chunks)
+			std::free(i->begin);
+		chunks.clear();
+		attachments.clear();
+		live_count = 0;
+		next_id = 0;
+	}
+
+	std::size_t size() const
+	{
+		return live_count;
+	}
+
+private:
+	struct Header
+	{
+		GarbageCollector* owner;
+		uint32 size;
+		uint32 alive;
+	};
+
+	struct Attachment
+	{
+		Attachment() : adopt(NULL), forget(NULL)
+		{ }
+
+		shared_ptr<void> object;
+		void (*adopt)(GarbageCollector& self, void* other, uint32 id_offset);
+		void (*forget)(void* self, Base* object);
+	};
+
+	struct Chunk
+	{
+		char* begin;
+		char* cursor;
+		char* end;
+	};
+
+	static const std::size_t alignment = 16;
+	static const std::size_t header_size = (sizeof(Header) + alignment - 1) & ~(alignment - 1);
+
+	static std::size_t align(std::size_t size)
+	{
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+
+	static GarbageCollector*& active()
+	{
+		static __thread GarbageCollector* current = NULL;
+		return current;
+	}
+
+	static std::size_t nextAttachmentIndex()
+	{
+		static std::size_t counter = 0;
+		return __sync_fetch_and_add(&counter, 1);
+	}
+
+	template<typename T>
+	static void adoptAttachment(GarbageCollector& self, void* other, uint32 id_offset)
+	{
+		self.attachment<T>().adopt(*static_cast<T*>(other), id_offset);
+	}
+
+	template<typename T>
+	static void forgetInAttachment(void* self, Base* object)
+	{
+		static_cast<T*>(self)->forget(object);
+	}
+
+	template<typename T>
+	static std::size_t attachmentIndex()
+	{
+		static const std::size_t index = nextAttachmentIndex();
+		return index;
+	}
+
+	void grow(std::size_t minimum_size)
+	{
+		std::size_t size = std::max(chunk_size, minimum_size);
+
+		Chunk chunk;
+		chunk.begin = static_cast<char*>(std::malloc(size));
+		if(!chunk.begin)
+			throw std::bad_alloc();
+		chunk.cursor = chunk.begin;
+		chunk.end = chunk.begin + size;
+
+		chunks.push_back(chunk);
+	}
+
+	std::size_t chunk_size;
+	std::size_t live_count;
+	uint32 next_id;
+	std::vector<Chunk> chunks;
+	std::vector<Attachment> attachments;
 };
 
 } } }
@@ -0,0 +1,301 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_TREE_NODECONTEXTTABLE_H_
+#define ZILLIANS_LANGUAGE_TREE_NODECONTEXTTABLE_H_
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNode.h"
+#include "language/tree/DenseNodeSet.h"
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/mpl/for_each.hpp>
+#include <boost/type_traits/add_pointer.hpp>
+#include <boost/serialization/split_member.hpp>
+
+namespace zillians { namespace language { namespace tree {
+
+/**
+ * NodeContextTable is a typed side table which stores one context object of type T per ASTNode
+ *
+ * It replaces ContextHub::get/set for contexts on hot paths: contexts of the same type created
+ * through assign() are stored contiguously (in a deque, so pointers handed out stay valid), and
+ * all of them are looked up through a flat index by ASTNode::node_id instead of a ContextHub
+ * lookup per get.
+ *
+ * There's one table per context type per arena (see GarbageCollector::attachment()), and the
+ * contexts of a node live in the table of the arena which allocated the node, as node ids are
+ * only unique within it. So get/set/assign/reset work on nodes of any arena, whichever arena is
+ * active, and a compilation session sees only its own contexts. The contexts of a node are
+ * dropped when the node is destroyed.
+ *
+ * T must be copy-constructible and copy-assignable.
+ */
+template<typename T>
+struct NodeContextTable : boost::noncopyable
+{
+	NodeContextTable()
+	{ }
+
+	~NodeContextTable()
+	{
+		foreach(i, owned)
+			delete i->first;
+	}
+
+	/**
+	 * The table of the active arena, e.g. to tell how many contexts a compilation created
+	 */
+	static NodeContextTable& instance()
+	{
+		return ASTNodeGC::instance()->template attachment<NodeContextTable>();
+	}
+
+	/**
+	 * The table holding the contexts of the given node
+	 */
+	static NodeContextTable& of(const ASTNode* node)
+	{
+		return ASTNodeGC::ownerOf(node)->template attachment<NodeContextTable>();
+	}
+
+	static T* get(const ASTNode* node)
+	{
+		return of(node).find(node);
+	}
+
+	/**
+	 * Store a copy of the given context for the node, overwriting the existing one in place
+	 *
+	 * @return the stored context
+	 */
+	static T* assign(const ASTNode* node, const T& value)
+	{
+		return of(node).store(node, value);
+	}
+
+	/**
+	 * Take over a heap-allocated context (the ContextOwnership::transfer semantic of ContextHub)
+	 *
+	 * The pointer stays valid and is returned by get() as is, so callers may keep using it
+	 * after handing it over; it's deleted once no node of the table refers to it any more, so
+	 * the same context may be set more than once or on several nodes. Setting NULL removes the
+	 * context from the node.
+	 */
+	static void set(const ASTNode* node, T* ctx)
+	{
+		if(ctx)
+			of(node).take(node, ctx);
+		else
+			reset(node);
+	}
+
+	static void reset(const ASTNode* node)
+	{
+		of(node).remove(node);
+	}
+
+	std::size_t size() const
+	{
+		return index.size();
+	}
+
+	/**
+	 * Take over the contexts of the same table of another arena being adopted (see
+	 * GarbageCollector::adopt); contexts keep their addresses
+	 */
+	void adopt(NodeContextTable& other, uint32 id_offset)
+	{
+		index.adopt(other.index, id_offset);
+
+		if(!other.storage.empty())
+			joined_storage.push_back(boost::shared_ptr<std::deque<T>>(new std::deque<T>(std::move(other.storage))));
+		other.storage.clear();
+
+		free_slots.insert(free_slots.end(), other.free_slots.begin(), other.free_slots.end());
+		other.free_slots.clear();
+
+		owned.insert(other.owned.begin(), other.owned.end());
+		other.owned.clear();
+	}
+
+	/**
+	 * Drop the context of a node being destroyed (see GarbageCollector::forget)
+	 */
+	void forget(const ASTNode* node)
+	{
+		remove(node);
+	}
+
+private:
+	T* find(const ASTNode* node) const
+	{
+		T* const* slot = index.find(node);
+		return slot ? *slot : NULL;
+	}
+
+	T* store(const ASTNode* node, const T& value)
+	{
+		T*& slot = index[node];
+		if(slot && (owned.empty() || owned.count(slot) == 0))
+		{
+			*slot = value;
+			return slot;
+		}
+
+		T* previous = slot;
+		if(free_slots.empty())
+		{
+			storage.push_back(value);
+			slot = &storage.back();
+		}
+		else
+		{
+			slot = free_slots.back();
+			free_slots.pop_back();
+			*slot = value;
+		}
+		release(previous);
+		return slot;
+	}
+
+	void take(const ASTNode* node, T* ctx)
+	{
+		T*& slot = index[node];
+		if(slot == ctx)
+			return;
+
+		T* previous = slot;
+		slot = ctx;
+		++owned[ctx];
+		release(previous);
+	}
+
+	void remove(const ASTNode* node)
+	{
+		T* const* slot = index.find(node);
+		if(!slot)
+			return;
+
+		T* ctx = *slot;
+		index.erase(node);
+		release(ctx);
+	}
+
+	// one reference of a node to the context is gone
+	void release(T* ctx)
+	{
+		if(!ctx)
+			return;
+
+		typename std::unordered_map<T*, uint32>::iterator i = owned.find(ctx);
+		if(i == owned.end())
+		{
+			// a slot of the storage, reused by the next assign()
+			free_slots.push_back(ctx);
+		}
+		else if(--i->second == 0)
+		{
+			owned.erase(i);
+			delete ctx;
+		}
+	}
+
+	std::deque<T> storage;
+	std::vector<boost::shared_ptr<std::deque<T>>> joined_storage;
+	std::vector<T*> free_slots;
+	std::unordered_map<T*, uint32> owned; // contexts taken over through set(), with the number of nodes referring to each
+	DenseNodeMap<T*> index;
+};
+
+/**
+ * Serialize the side table contexts of a single node for every type in ContextTypes
+ *
+ * Works just like ContextHubSerialization but reads from/writes to NodeContextTable
+ */
+template<typename ContextTypes>
+struct NodeContextTableSerialization
+{
+	friend class boost::serialization::access;
+
+	explicit NodeContextTableSerialization(ASTNode& node) : node(node)
+	{ }
+
+private:
+	template<typename Archive>
+	struct Saver
+	{
+		Saver(Archive& ar, ASTNode& node) : ar(ar), node(node)
+		{ }
+
+		template<typename T>
+		void operator()(T*) const
+		{
+			T* ctx = NodeContextTable<T>::get(&node);
+			ar << ctx;
+		}
+
+		Archive& ar;
+		ASTNode& node;
+	};
+
+	template<typename Archive>
+	struct Loader
+	{
+		Loader(Archive& ar, ASTNode& node) : ar(ar), node(node)
+		{ }
+
+		template<typename T>
+		void operator()(T*) const
+		{
+			T* ctx = NULL;
+			ar >> ctx;
+			if(ctx)
+				NodeContextTable<T>::set(&node, ctx);
+		}
+
+		Archive& ar;
+		ASTNode& node;
+	};
+
+	template<typename Archive>
+	void save(Archive& ar, const unsigned int version) const
+	{
+		UNUSED_ARGUMENT(version);
+		boost::mpl::for_each<ContextTypes, boost::add_pointer<boost::mpl::_1>>(Saver<Archive>(ar, node));
+	}
+
+	template<typename Archive>
+	void load(Archive& ar, const unsigned int version)
+	{
+		UNUSED_ARGUMENT(version);
+		boost::mpl::for_each<ContextTypes, boost::add_pointer<boost::mpl::_1>>(Loader<Archive>(ar, node));
+	}
+
+	BOOST_SERIALIZATION_SPLIT_MEMBER();
+
+	ASTNode& node;
+};
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_TREE_NODECONTEXTTABLE_H_ */
@@ -0,0 +1,256 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_TREE_SYMBOLTABLE_H_
+#define ZILLIANS_LANGUAGE_TREE_SYMBOLTABLE_H_
+
+#include "core/Prerequisite.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/serialization/split_free.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/level.hpp>
+#include <boost/serialization/tracking.hpp>
+
+namespace zillians { namespace language { namespace tree {
+
+/**
+ * SymbolTable interns every identifier name used in the AST
+ *
+ * Each distinct name is stored exactly once together with its hash and a dense id, so names can
+ * be compared by pointer and hashed without touching the characters again.
+ *
+ * The table is process-wide and never shrinks: it's shared by all arenas, so symbols stay valid
+ * across AST serialization/deserialization and across trees merged from different AST files.
+ * Interning is thread-safe, and looking up a name already interned doesn't lock (every
+ * identifier the parser threads build is interned): entries are chained from a fixed array of
+ * buckets, are never moved nor modified once linked, and are linked with a release store. Only
+ * adding a name takes the lock.
+ */
+struct SymbolTable : boost::noncopyable
+{
+	struct Entry
+	{
+		const std::wstring* name;
+		std::size_t hash;
+		uint32 id;
+		const Entry* next; // in the same bucket
+	};
+
+	static SymbolTable& instance()
+	{
+		static SymbolTable table;
+		return table;
+	}
+
+	const Entry* intern(const std::wstring& name)
+	{
+		std::size_t hash = boost::hash_value(name);
+		std::atomic<const Entry*>& bucket = buckets[hash & (bucket_count - 1)];
+
+		const Entry* head = bucket.load(std::memory_order_acquire);
+		if(const Entry* found = find(head, name, hash))
+			return found;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// somebody may have added it in the meantime, only entries linked after head are new
+		const Entry* latest = bucket.load(std::memory_order_relaxed);
+		for(const Entry* e = latest; e != head; e = e->next)
+		{
+			if(e->hash == hash && *e->name == name)
+				return e;
+		}
+
+		names.push_back(name);
+
+		Entry entry;
+		entry.name = &names.back();
+		entry.hash = hash;
+		entry.id = entries.size();
+		entry.next = latest;
+		entries.push_back(entry);
+
+		count.store(entries.size(), std::memory_order_release);
+		bucket.store(&entries.back(), std::memory_order_release);
+		return &entries.back();
+	}
+
+	const Entry* empty() const
+	{
+		return empty_entry;
+	}
+
+	std::size_t size() const
+	{
+		return count.load(std::memory_order_acquire);
+	}
+
+private:
+	static const std::size_t bucket_count = 1 << 15;
+
+	SymbolTable() : buckets(new std::atomic<const Entry*>[bucket_count]), count(0)
+	{
+		for(std::size_t i = 0; i < bucket_count; ++i)
+			buckets[i].store(NULL, std::memory_order_relaxed);
+		empty_entry = intern(L"");
+	}
+
+	static const Entry* find(const Entry* e, const std::wstring& name, std::size_t hash)
+	{
+		for(; e; e = e->next)
+		{
+			if(e->hash == hash && *e->name == name)
+				return e;
+		}
+		return NULL;
+	}
+
+	std::unique_ptr<std::atomic<const Entry*>[]> buckets;
+	std::atomic<std::size_t> count;
+
+	// the rest is only touched by adding names, under the lock
+	std::mutex mutex;
+	std::deque<std::wstring> names;
+	std::deque<Entry> entries;
+	const Entry* empty_entry;
+};
+
+/**
+ * Symbol is an interned name, which is what SimpleIdentifier stores
+ *
+ * It's a single pointer into SymbolTable, so copying, equality test and hashing are O(1).
+ * It converts implicitly from and to std::wstring so it can be used where a name string used to be.
+ * Ordering (operator<) is still lexicographic to keep the ordering of name-keyed containers stable.
+ */
+struct Symbol
+{
+	Symbol() : entry(SymbolTable::instance().empty())
+	{ }
+
+	Symbol(const std::wstring& name) : entry(SymbolTable::instance().intern(name))
+	{ }
+
+	Symbol(const wchar_t* name) : entry(SymbolTable::instance().intern(name))
+	{ }
+
+	const std::wstring& str() const
+	{
+		return *entry->name;
+	}
+
+	operator const std::wstring& () const
+	{
+		return *entry->name;
+	}
+
+	uint32 id() const
+	{
+		return entry->id;
+	}
+
+	std::size_t hash() const
+	{
+		return entry->hash;
+	}
+
+	bool empty() const
+	{
+		return entry->name->empty();
+	}
+
+	std::size_t length() const
+	{
+		return entry->name->length();
+	}
+
+	int compare(const Symbol& rhs) const
+	{
+		return (entry == rhs.entry) ? 0 : entry->name->compare(*rhs.entry->name);
+	}
+
+	bool operator==(const Symbol& rhs) const { return entry == rhs.entry; }
+	bool operator!=(const Symbol& rhs) const { return entry != rhs.entry; }
+	bool operator< (const Symbol& rhs) const { return compare(rhs) < 0; }
+
+	bool operator==(const std::wstring& rhs) const { return *entry->name == rhs; }
+	bool operator!=(const std::wstring& rhs) const { return *entry->name != rhs; }
+	bool operator==(const wchar_t* rhs) const      { return *entry->name == rhs; }
+	bool operator!=(const wchar_t* rhs) const      { return *entry->name != rhs; }
+
+private:
+	const SymbolTable::Entry* entry;
+};
+
+inline std::size_t hash_value(const Symbol& symbol)
+{
+	return symbol.hash();
+}
+
+inline std::wostream& operator<<(std::wostream& stream, const Symbol& symbol)
+{
+	return stream << symbol.str();
+}
+
+} } }
+
+namespace std {
+
+template<>
+struct hash<zillians::language::tree::Symbol>
+{
+	std::size_t operator()(const zillians::language::tree::Symbol& symbol) const
+	{
+		return symbol.hash();
+	}
+};
+
+}
+
+// symbols are serialized as plain strings and re-interned on load
+namespace boost { namespace serialization {
+
+template<typename Archive>
+void save(Archive& ar, const zillians::language::tree::Symbol& symbol, const unsigned int version)
+{
+	UNUSED_ARGUMENT(version);
+	ar & symbol.str();
+}
+
+template<typename Archive>
+void load(Archive& ar, zillians::language::tree::Symbol& symbol, const unsigned int version)
+{
+	UNUSED_ARGUMENT(version);
+	std::wstring name;
+	ar & name;
+	symbol = zillians::language::tree::Symbol(name);
+}
+
+} }
+
+BOOST_SERIALIZATION_SPLIT_FREE(zillians::language::tree::Symbol)
+BOOST_CLASS_IMPLEMENTATION(zillians::language::tree::Symbol, boost::serialization::object_serializable)
+BOOST_CLASS_TRACKING(zillians::language::tree::Symbol, boost::serialization::track_never)
+
+#endif /* ZILLIANS_LANGUAGE_TREE_SYMBOLTABLE_H_ */
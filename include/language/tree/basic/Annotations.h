@@ -37,6 +37,7 @@ struct Annotation : public ASTNode
 
 	explicit Annotation(SimpleIdentifier* name) : name(name)
 	{
+		setNodeType(this);
 		if(name) name->parent = this;
 	}
 
@@ -63,7 +64,7 @@ struct Annotation : public ASTNode
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	Annotation* cloned = new Annotation(name);
     	foreach(i, attribute_list)
@@ -90,7 +91,7 @@ struct Annotation : public ASTNode
 	           > attribute_list;
 
 protected:
-	Annotation() { }
+	Annotation() { setNodeType(this); }
 };
 
 struct Annotations : public ASTNode
@@ -100,7 +101,7 @@ struct Annotations : public ASTNode
 	DEFINE_VISITABLE();
 	DEFINE_HIERARCHY(Annotations, (Annotations)(ASTNode));
 
-	Annotations() { }
+	Annotations() { setNodeType(this); }
 
 	void appendAnnotation(Annotation* annotation)
 	{
@@ -122,7 +123,7 @@ struct Annotations : public ASTNode
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	Annotations* cloned = new Annotations();
     	foreach(i, annotation_list)
@@ -24,9 +24,87 @@
 #define ZILLIANS_LANGUAGE_TREE_BLOCK_H_
 
 #include "language/tree/ASTNode.h"
+#include <unordered_map>
 
 namespace zillians { namespace language { namespace tree {
 
+namespace detail {
+
+/**
+ * BlockPositionIndex maps each statement of a Block to its position in Block::objects
+ *
+ * It's a cache which turns "insert before/after this statement" into an O(1) lookup: it's built
+ * on the first lookup, kept up to date by the Block methods, and simply dropped whenever objects
+ * is changed in some other way (replaceUseWith(), loading). It's never copied nor serialized.
+ *
+ * Statements appended to Block::objects directly are picked up on the next lookup, but removing
+ * statements from it directly (rather than through Block) leaves the index dangling.
+ */
+struct BlockPositionIndex
+{
+	typedef std::list<ASTNode*>::iterator iterator;
+
+	BlockPositionIndex() : valid(false)
+	{ }
+
+	BlockPositionIndex(const BlockPositionIndex&) : valid(false)
+	{ }
+
+	BlockPositionIndex& operator=(const BlockPositionIndex&)
+	{
+		invalidate();
+		return *this;
+	}
+
+	iterator find(std::list<ASTNode*>& objects, const ASTNode* object)
+	{
+		if(!valid)
+			rebuild(objects);
+
+		std::unordered_map<const ASTNode*, iterator>::iterator i = positions.find(object);
+		if(i != positions.end())
+			return i->second;
+
+		// the object may have been added to the list directly, so look again before giving up
+		rebuild(objects);
+		i = positions.find(object);
+		return (i != positions.end()) ? i->second : objects.end();
+	}
+
+	void inserted(iterator it)
+	{
+		if(valid)
+			positions.insert(std::make_pair(*it, it));
+	}
+
+	void erased(const ASTNode* object)
+	{
+		if(valid)
+			positions.erase(object);
+	}
+
+	void invalidate()
+	{
+		positions.clear();
+		valid = false;
+	}
+
+private:
+	void rebuild(std::list<ASTNode*>& objects)
+	{
+		positions.clear();
+		for(iterator it = objects.begin(); it != objects.end(); ++it)
+			positions.insert(std::make_pair(*it, it));
+		valid = true;
+	}
+
+private:
+	std::unordered_map<const ASTNode*, iterator> positions;
+	bool valid;
+};
+
+}
+
 struct Block : public ASTNode
 {
 	friend class boost::serialization::access;
@@ -35,18 +113,19 @@ struct Block : public ASTNode
 	DEFINE_HIERARCHY(Block, (Block)(ASTNode));
 
 	explicit Block(bool is_pipelined = false, bool is_async = false) : is_pipelined_block(is_pipelined), is_async_block(is_async)
-	{ }
+	{ setNodeType(this); }
 
 	void prependObject(ASTNode* object)
 	{
 		object->parent = this;
 		objects.push_front(object);
+		positions.inserted(objects.begin());
 	}
 
 	void appendObject(ASTNode* object)
 	{
 		object->parent = this;
-		objects.push_back(object);
+		positions.inserted(objects.insert(objects.end(), object));
 	}
 
 	bool insertObjectBefore(ASTNode* before, ASTNode* object, bool replace_before = false)
@@ -58,14 +137,14 @@ struct Block : public ASTNode
 		}
 		else
 		{
-			auto it = std::find(objects.begin(), objects.end(), before);
+			auto it = positions.find(objects, before);
 			if(it != objects.end())
 			{
 				object->parent = this;
-				objects.insert(it, object);
+				positions.inserted(objects.insert(it, object));
 
 				if(replace_before)
-					objects.erase(it);
+					eraseObject(it);
 
 				return true;
 			}
@@ -85,15 +164,15 @@ struct Block : public ASTNode
 		}
 		else
 		{
-			auto it = std::find(objects.begin(), objects.end(), after);
+			auto it = positions.find(objects, after);
 			if(it != objects.end())
 			{
 				++it;
 				object->parent = this;
-				objects.insert(it, object);
+				positions.inserted(objects.insert(it, object));
 
 				if(replace_after)
-					objects.erase(it);
+					eraseObject(it);
 
 				return true;
 			}
@@ -107,17 +186,13 @@ struct Block : public ASTNode
 	template<typename T>
 	void prependObjects(T& object_list)
 	{
-		deduced_foreach(i, object_list)
-			(*i)->parent = this;
-		objects.insert(objects.begin(), object_list.begin(), object_list.end());
+		insertObjectsAt(objects.begin(), object_list);
 	}
 
 	template<typename T>
 	void appendObjects(T& object_list)
 	{
-		deduced_foreach(i, object_list)
-			(*i)->parent = this;
-		objects.insert(objects.end(), object_list.begin(), object_list.end());
+		insertObjectsAt(objects.end(), object_list);
 	}
 
 	template<typename T>
@@ -130,15 +205,13 @@ struct Block : public ASTNode
 		}
 		else
 		{
-			auto it = std::find(objects.begin(), objects.end(), before);
+			auto it = positions.find(objects, before);
 			if(it != objects.end())
 			{
-				deduced_foreach(i, object_list)
-					(*i)->parent = this;
-				objects.insert(it, object_list.begin(), object_list.end());
+				insertObjectsAt(it, object_list);
 
 				if(replace_before)
-					objects.erase(it);
+					eraseObject(it);
 
 				return true;
 			}
@@ -159,16 +232,14 @@ struct Block : public ASTNode
 		}
 		else
 		{
-			auto it = std::find(objects.begin(), objects.end(), after);
+			auto it = positions.find(objects, after);
 			if(it != objects.end())
 			{
-				deduced_foreach(i, object_list)
-					(*i)->parent = this;
 				++it;
-				objects.insert(it, object_list.begin(), object_list.end());
+				insertObjectsAt(it, object_list);
 
 				if(replace_after)
-					objects.erase(it);
+					eraseObject(it);
 
 				return true;
 			}
@@ -190,12 +261,14 @@ struct Block : public ASTNode
 
     virtual bool replaceUseWith(const ASTNode& from, const ASTNode& to, bool update_parent = true)
     {
+    	positions.invalidate();
+
     	BEGIN_REPLACE()
 		REPLACE_USE_WITH(objects)
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	Block* cloned = new Block(is_pipelined_block, is_async_block);
     	foreach(i, objects)
@@ -207,7 +280,7 @@ struct Block : public ASTNode
     {
     	foreach(i, rhs.objects)
 		{
-    		objects.push_back(*i);
+    		positions.inserted(objects.insert(objects.end(), *i));
 		}
     	return true;
     }
@@ -221,11 +294,32 @@ struct Block : public ASTNode
     	ar & is_pipelined_block;
     	ar & is_async_block;
     	ar & objects;
+
+    	positions.invalidate();
     }
 
 	bool is_pipelined_block;
 	bool is_async_block;
 	std::list<ASTNode*> objects;
+
+private:
+	template<typename T>
+	void insertObjectsAt(std::list<ASTNode*>::iterator it, T& object_list)
+	{
+		deduced_foreach(i, object_list)
+		{
+			(*i)->parent = this;
+			positions.inserted(objects.insert(it, *i));
+		}
+	}
+
+	void eraseObject(std::list<ASTNode*>::iterator it)
+	{
+		positions.erased(*it);
+		objects.erase(it);
+	}
+
+	detail::BlockPositionIndex positions;
 };
 
 } } }
@@ -36,7 +36,7 @@ struct FunctionType: public ASTNode
 	DEFINE_HIERARCHY(FunctionType, (FunctionType)(ASTNode));
 
 	FunctionType() : return_type(NULL)
-	{ }
+	{ setNodeType(this); }
 
 	void appendTemplateParameter(Identifier* parameter);
 	void appendParameterType(TypeSpecifier* type);
@@ -64,7 +64,7 @@ struct FunctionType: public ASTNode
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const;
+    virtual ASTNode* cloneImpl() const;
 
     template<typename Archive>
     void serialize(Archive& ar, const unsigned int version)
@@ -24,6 +24,7 @@
 #define ZILLIANS_LANGUAGE_TREE_IDENTIFIER_H_
 
 #include "language/tree/ASTNode.h"
+#include "language/tree/SymbolTable.h"
 #include "utility/Foreach.h"
 
 namespace zillians { namespace language { namespace tree {
@@ -41,6 +42,21 @@ struct Identifier : public ASTNode
 	virtual std::wstring toString() const = 0;
 	virtual bool isEmpty() const = 0;
 
+	/**
+	 * Compare the names of two identifiers, ordered the same way as their toString() results
+	 *
+	 * Simple and nested identifiers are compared component by component through their interned
+	 * symbols, so no string is built; other identifiers fall back to toString().
+	 *
+	 * @return negative, zero or positive like std::wstring::compare()
+	 */
+	static int compareName(const Identifier& lhs, const Identifier& rhs);
+
+	bool hasSameName(const Identifier& rhs) const
+	{
+		return compareName(*this, rhs) == 0;
+	}
+
     template<typename Archive>
     void serialize(Archive& ar, const unsigned int version)
     {
@@ -57,14 +73,14 @@ struct SimpleIdentifier : public Identifier
 	DEFINE_VISITABLE();
 	DEFINE_HIERARCHY(SimpleIdentifier, (SimpleIdentifier)(Identifier)(ASTNode));
 
-	explicit SimpleIdentifier(const std::wstring& s);
+	explicit SimpleIdentifier(const Symbol& s);
 
 	virtual std::wstring toString() const;
 	virtual bool isEmpty() const;
 
     virtual bool isEqualImpl(const ASTNode& rhs, ASTNodeSet& visited) const;
     virtual bool replaceUseWith(const ASTNode& from, const ASTNode& to, bool update_parent = true);
-    virtual ASTNode* clone() const;
+    virtual ASTNode* cloneImpl() const;
 
     template<typename Archive>
     void serialize(Archive& ar, const unsigned int version)
@@ -75,7 +91,7 @@ struct SimpleIdentifier : public Identifier
     	ar & name;
     }
 
-	std::wstring name;
+	Symbol name;
 
 protected:
 	SimpleIdentifier();
@@ -98,7 +114,7 @@ struct NestedIdentifier : public Identifier
     virtual bool isEqualImpl(const ASTNode& rhs, ASTNodeSet& visited) const;
     virtual bool replaceUseWith(const ASTNode& from, const ASTNode& to, bool update_parent = true);
 
-	virtual ASTNode* clone() const;
+	virtual ASTNode* cloneImpl() const;
 
     template<typename Archive>
     void serialize(Archive& ar, const unsigned int version)
@@ -149,7 +165,7 @@ struct TemplatedIdentifier : public Identifier
 	void append(TypenameDecl* type);
     virtual bool isEqualImpl(const ASTNode& rhs, ASTNodeSet& visited) const;
     virtual bool replaceUseWith(const ASTNode& from, const ASTNode& to, bool update_parent = true);
-	virtual ASTNode* clone() const;
+	virtual ASTNode* cloneImpl() const;
 
     template<typename Archive>
     void serialize(Archive& ar, const unsigned int version)
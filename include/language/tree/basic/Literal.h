@@ -80,7 +80,7 @@ struct ObjectLiteral : public Literal
 	};
 
 	explicit ObjectLiteral(LiteralType::type t) : type(t)
-	{ }
+	{ setNodeType(this); }
 
     virtual bool isEqualImpl(const ASTNode& rhs, ASTNodeSet& visited) const
     {
@@ -98,7 +98,7 @@ struct ObjectLiteral : public Literal
     	return false;
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new ObjectLiteral(type);
     }
@@ -120,7 +120,7 @@ struct ObjectLiteral : public Literal
 	LiteralType::type type;
 
 protected:
-	ObjectLiteral() { }
+	ObjectLiteral() { setNodeType(this); }
 };
 
 struct NumericLiteral : public Literal
@@ -130,18 +130,19 @@ struct NumericLiteral : public Literal
 	DEFINE_VISITABLE();
 	DEFINE_HIERARCHY(NumericLiteral, (NumericLiteral)(Literal)(ASTNode));
 
-	explicit NumericLiteral(bool v)	 { type = PrimitiveType::BOOL_TYPE;  value.b = v;  }
-	explicit NumericLiteral(int8 v)	 { type = PrimitiveType::INT8_TYPE;  value.i8 = v;  }
-	explicit NumericLiteral(int16 v) { type = PrimitiveType::INT16_TYPE; value.i16 = v; }
-	explicit NumericLiteral(int32 v) { type = PrimitiveType::INT32_TYPE; value.i32 = v; }
-	explicit NumericLiteral(int64 v) { type = PrimitiveType::INT64_TYPE; value.i64 = v; }
+	explicit NumericLiteral(bool v)	 { setNodeType(this); type = PrimitiveType::BOOL_TYPE;  value.b = v;  }
+	explicit NumericLiteral(int8 v)	 { setNodeType(this); type = PrimitiveType::INT8_TYPE;  value.i8 = v;  }
+	explicit NumericLiteral(int16 v) { setNodeType(this); type = PrimitiveType::INT16_TYPE; value.i16 = v; }
+	explicit NumericLiteral(int32 v) { setNodeType(this); type = PrimitiveType::INT32_TYPE; value.i32 = v; }
+	explicit NumericLiteral(int64 v) { setNodeType(this); type = PrimitiveType::INT64_TYPE; value.i64 = v; }
 
-	explicit NumericLiteral(float v)  { type = PrimitiveType::FLOAT32_TYPE; value.f32 = v; }
-	explicit NumericLiteral(double v) { type = PrimitiveType::FLOAT64_TYPE; value.f64 = v; }
+	explicit NumericLiteral(float v)  { setNodeType(this); type = PrimitiveType::FLOAT32_TYPE; value.f32 = v; }
+	explicit NumericLiteral(double v) { setNodeType(this); type = PrimitiveType::FLOAT64_TYPE; value.f64 = v; }
 
 	template<typename T>
 	explicit NumericLiteral(PrimitiveType::type t, T v)
 	{
+        setNodeType(this);
         switch(t)
         {
         case PrimitiveType::type::BOOL_TYPE: value.b = (bool)v; break;
@@ -183,7 +184,7 @@ struct NumericLiteral : public Literal
     	return false;
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
         switch(type)
         {
@@ -253,7 +254,7 @@ struct NumericLiteral : public Literal
 	} value;
 
 protected:
-	NumericLiteral() { }
+	NumericLiteral() { setNodeType(this); }
 };
 
 struct StringLiteral : public Literal
@@ -264,11 +265,12 @@ struct StringLiteral : public Literal
 	DEFINE_HIERARCHY(StringLiteral, (StringLiteral)(Literal)(ASTNode));
 
 	explicit StringLiteral(const std::wstring& s) : value(s)
-	{ }
+	{ setNodeType(this); }
 
 	template<typename Iterator>
 	explicit StringLiteral(Iterator begin, Iterator end)
 	{
+		setNodeType(this);
 		const std::size_t length = end - begin;
 		value.resize(length + 1);
 		for(std::size_t i = 0; i != length; ++i)
@@ -291,7 +293,7 @@ struct StringLiteral : public Literal
     	return false;
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new StringLiteral(value);
     }
@@ -315,7 +317,7 @@ struct StringLiteral : public Literal
 	std::wstring value;
 
 protected:
-	StringLiteral() { }
+	StringLiteral() { setNodeType(this); }
 };
 
 } } }
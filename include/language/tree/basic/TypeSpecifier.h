@@ -74,7 +74,7 @@ struct TypeSpecifier : public ASTNode
     virtual bool isEqualImpl(const ASTNode& rhs, ASTNodeSet& visited) const;
     virtual bool replaceUseWith(const ASTNode& from, const ASTNode& to, bool update_parent = true);
 
-    virtual ASTNode* clone() const;
+    virtual ASTNode* cloneImpl() const;
 
     template<typename Archive>
     void serialize(Archive& ar, const unsigned int version)
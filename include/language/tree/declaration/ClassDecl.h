@@ -38,6 +38,7 @@ struct ClassDecl : public Declaration
 
 	explicit ClassDecl(Identifier* name) : Declaration(name), base(NULL)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(name && "null class name identifier is not allowed");
 	}
 
@@ -99,7 +100,7 @@ struct ClassDecl : public Declaration
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	ClassDecl* cloned = new ClassDecl((name) ? cast<Identifier>(name->clone()) : NULL);
 
@@ -141,7 +142,7 @@ struct ClassDecl : public Declaration
 	std::vector<VariableDecl*> member_variables;
 
 protected:
-	ClassDecl() { }
+	ClassDecl() { setNodeType(this); }
 };
 
 } } }
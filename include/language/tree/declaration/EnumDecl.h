@@ -38,6 +38,7 @@ struct EnumDecl : public Declaration
 
 	explicit EnumDecl(Identifier* name) : Declaration(name)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(name && "null enumeration name is not allowed");
 	}
 
@@ -74,7 +75,7 @@ struct EnumDecl : public Declaration
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	EnumDecl* cloned = new EnumDecl((name) ? cast<Identifier>(name->clone()) : NULL);
 
@@ -102,7 +103,7 @@ struct EnumDecl : public Declaration
     std::vector<VariableDecl*> values;
 
 protected:
-	EnumDecl() { }
+	EnumDecl() { setNodeType(this); }
 };
 
 } } }
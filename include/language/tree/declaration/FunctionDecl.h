@@ -41,6 +41,7 @@ struct FunctionDecl : public Declaration
 
 	explicit FunctionDecl(Identifier* name, TypeSpecifier* type, bool is_member, bool is_static, Declaration::VisibilitySpecifier::type visibility, Block* block = NULL) : Declaration(name), type(type), is_member(is_member), is_static(is_static), visibility(visibility), block(block)
 	{
+		setNodeType(this);
 		if(type) type->parent = this;
 		if(block) block->parent = this;
 	}
@@ -84,7 +85,7 @@ struct FunctionDecl : public Declaration
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	FunctionDecl* cloned = new FunctionDecl(
     			(name) ? cast<Identifier>(name->clone()) : NULL,
@@ -126,7 +127,7 @@ struct FunctionDecl : public Declaration
 	Block* block;
 
 protected:
-	FunctionDecl() { }
+	FunctionDecl() { setNodeType(this); }
 };
 
 } } }
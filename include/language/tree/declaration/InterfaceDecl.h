@@ -37,6 +37,7 @@ struct InterfaceDecl : public Declaration
 
 	explicit InterfaceDecl(Identifier* name) : Declaration(name)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(name && "null interface name is not allowed");
 	}
 
@@ -68,7 +69,7 @@ struct InterfaceDecl : public Declaration
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	InterfaceDecl* cloned = new InterfaceDecl((name) ? cast<Identifier>(name->clone()) : NULL);
 
@@ -97,7 +98,7 @@ struct InterfaceDecl : public Declaration
     std::vector<TypeSpecifier*> extend_interfaces;
 
 protected:
-	InterfaceDecl() { }
+	InterfaceDecl() { setNodeType(this); }
 };
 
 } } }
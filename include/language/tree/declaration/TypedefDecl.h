@@ -36,6 +36,7 @@ struct TypedefDecl : public Declaration
 
 	explicit TypedefDecl(TypeSpecifier* f, Identifier* t) : Declaration(t), type(f)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(f && t && "null \"from node\" or \"to node\" for typedef is not allowed");
 
 		type->parent = this;
@@ -55,7 +56,7 @@ struct TypedefDecl : public Declaration
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	TypedefDecl* cloned = new TypedefDecl(
     			(type) ? cast<TypeSpecifier>(type->clone()) : NULL,
@@ -82,7 +83,7 @@ struct TypedefDecl : public Declaration
 	TypeSpecifier* type;
 
 protected:
-	TypedefDecl() { }
+	TypedefDecl() { setNodeType(this); }
 };
 
 } } }
@@ -39,6 +39,7 @@ struct TypenameDecl : public Declaration
 
 	explicit TypenameDecl(Identifier* name, TypeSpecifier* specialized_type = NULL, Expression* default_type = NULL) : Declaration(name), specialized_type(specialized_type), default_type(default_type)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(name && "null variable name is not allowed");
 
 		if(specialized_type) specialized_type->parent = this;
@@ -75,7 +76,7 @@ struct TypenameDecl : public Declaration
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	TypenameDecl* cloned = new TypenameDecl(
     			(name) ? cast<Identifier>(name->clone()) : NULL,
@@ -105,7 +106,7 @@ struct TypenameDecl : public Declaration
 	Expression* default_type;
 
 protected:
-	TypenameDecl() { }
+	TypenameDecl() { setNodeType(this); }
 };
 
 } } }
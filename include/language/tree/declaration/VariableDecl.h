@@ -39,6 +39,7 @@ struct VariableDecl : public Declaration
 
 	explicit VariableDecl(Identifier* name, TypeSpecifier* type, bool is_member, bool is_static, bool is_const, Declaration::VisibilitySpecifier::type visibility, Expression* initializer = NULL) : Declaration(name), type(type), is_member(is_member), is_static(is_static), is_const(is_const), visibility(visibility), initializer(initializer)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(name && "null variable name is not allowed");
 
 		if(type) type->parent = this;
@@ -72,7 +73,7 @@ struct VariableDecl : public Declaration
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	VariableDecl* cloned = new VariableDecl(
     			(name) ? cast<Identifier>(name->clone()) : NULL,
@@ -111,7 +112,7 @@ struct VariableDecl : public Declaration
 	Expression* initializer;
 
 protected:
-	VariableDecl() { }
+	VariableDecl() { setNodeType(this); }
 };
 
 } } }
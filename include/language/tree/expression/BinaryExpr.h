@@ -113,6 +113,7 @@ struct BinaryExpr : public Expression
 
 	explicit BinaryExpr(OpCode::type opcode, Expression* left, Expression* right) : opcode(opcode), left(left), right(right)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(left && "null left child for binary expression is not allowed");
 		BOOST_ASSERT(right && "null right child for binary expression is not allowed");
 
@@ -270,7 +271,7 @@ struct BinaryExpr : public Expression
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new BinaryExpr(
     			opcode,
@@ -294,7 +295,7 @@ struct BinaryExpr : public Expression
 	Expression* right;
 
 protected:
-	BinaryExpr() { }
+	BinaryExpr() { setNodeType(this); }
 };
 
 } } }
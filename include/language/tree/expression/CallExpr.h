@@ -33,6 +33,7 @@ struct CallExpr : public Expression
 
 	explicit CallExpr(ASTNode* node) : node(node)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(node && "null callee for call expression is not allowed");
 
 		node->parent = this;
@@ -75,7 +76,7 @@ struct CallExpr : public Expression
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	CallExpr* cloned = new CallExpr((node) ? node->clone() : NULL);
 
@@ -99,7 +100,7 @@ struct CallExpr : public Expression
 	std::vector<Expression*> parameters;
 
 protected:
-	CallExpr() { }
+	CallExpr() { setNodeType(this); }
 };
 
 } } }
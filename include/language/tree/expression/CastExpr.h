@@ -37,6 +37,7 @@ struct CastExpr : public Expression
 
 	explicit CastExpr(Expression* node, TypeSpecifier* type) : node(node), type(type)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(node && "null node for cast expression is not allowed");
 		BOOST_ASSERT(type && "null type for cast expression is not allowed");
 
@@ -65,7 +66,7 @@ struct CastExpr : public Expression
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new CastExpr(
     			(node) ? cast<Expression>(node->clone()) : NULL,
@@ -86,7 +87,7 @@ struct CastExpr : public Expression
 	TypeSpecifier* type;
 
 protected:
-	CastExpr() { }
+	CastExpr() { setNodeType(this); }
 };
 
 } } }
@@ -36,6 +36,7 @@ struct MemberExpr : public Expression
 
 	explicit MemberExpr(ASTNode* node, Identifier* member) : node(node), member(member)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(node && "null node for member expression is not allowed");
 		BOOST_ASSERT(member && "null identifier for member expression is not allowed");
 
@@ -64,7 +65,7 @@ struct MemberExpr : public Expression
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new MemberExpr((node) ? node->clone() : NULL, (member) ? cast<Identifier>(member) : NULL);
     }
@@ -83,7 +84,7 @@ struct MemberExpr : public Expression
 	Identifier* member;
 
 protected:
-	MemberExpr() { }
+	MemberExpr() { setNodeType(this); }
 };
 
 } } }
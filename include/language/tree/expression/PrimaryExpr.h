@@ -53,6 +53,7 @@ struct PrimaryExpr : public Expression
 
 	explicit PrimaryExpr(Identifier* identifier) : catagory(Catagory::IDENTIFIER)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(identifier && "null identifier for primary expression is not allowed");
 
 		identifier->parent = this;
@@ -61,6 +62,7 @@ struct PrimaryExpr : public Expression
 
 	explicit PrimaryExpr(Literal* literal) : catagory(Catagory::LITERAL)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(literal && "null literal for primary expression is not allowed");
 
 		literal->parent = this;
@@ -69,6 +71,7 @@ struct PrimaryExpr : public Expression
 
 	explicit PrimaryExpr(FunctionDecl* lambda) : catagory(Catagory::LAMBDA)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(lambda && "null lambda for primary expression is not allowed");
 
 		lambda->parent = this;
@@ -113,7 +116,7 @@ struct PrimaryExpr : public Expression
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
         switch (catagory)
         {
@@ -151,7 +154,7 @@ struct PrimaryExpr : public Expression
 	} value;
 
 protected:
-	PrimaryExpr() { }
+	PrimaryExpr() { setNodeType(this); }
 };
 
 } } }
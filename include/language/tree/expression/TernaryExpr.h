@@ -37,6 +37,7 @@ struct TernaryExpr : public Expression
 	// so far there only one ternary expression: the conditional expression
 	TernaryExpr(Expression* cond, Expression* true_node, Expression* false_node) : cond(cond), true_node(true_node), false_node(false_node)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(cond && "null condition for ternary expression is not allowed");
 		BOOST_ASSERT(true_node && "null \"true node\" for ternary expression is not allowed");
 		BOOST_ASSERT(false_node && "null \"false node\" for ternary expression is not allowed");
@@ -70,7 +71,7 @@ struct TernaryExpr : public Expression
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new TernaryExpr(
     			(cond) ? cast<Expression>(cond->clone()) : NULL,
@@ -94,7 +95,7 @@ struct TernaryExpr : public Expression
 	Expression* false_node;
 
 protected:
-	TernaryExpr() { }
+	TernaryExpr() { setNodeType(this); }
 };
 
 } } }
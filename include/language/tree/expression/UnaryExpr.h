@@ -66,6 +66,7 @@ struct UnaryExpr : public Expression
 
 	explicit UnaryExpr(OpCode::type opcode, ASTNode* node) : opcode(opcode), node(node)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(node && "null node for unary expression is not allowed");
 
 		node->parent = this;
@@ -106,7 +107,7 @@ struct UnaryExpr : public Expression
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new UnaryExpr(opcode, (node) ? node->clone() : NULL);
     }
@@ -125,7 +126,7 @@ struct UnaryExpr : public Expression
 	ASTNode* node;
 
 protected:
-	UnaryExpr() { }
+	UnaryExpr() { setNodeType(this); }
 };
 
 } } }
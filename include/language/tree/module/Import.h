@@ -41,6 +41,7 @@ struct Import : public ASTNode
 
 	explicit Import(Identifier* ns) : alias(NULL), ns(ns)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(ns && "null identifier for import node is not allowed");
 
 		ns->parent = this;
@@ -48,6 +49,7 @@ struct Import : public ASTNode
 
 	explicit Import(Identifier* alias, Identifier* ns) : alias(alias), ns(ns)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(alias && "null identifier for import node is not allowed");
 		BOOST_ASSERT(ns && "null identifier for import node is not allowed");
 
@@ -71,7 +73,7 @@ struct Import : public ASTNode
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	if(alias)
     		return new Import(cast<Identifier>(alias->clone()), cast<Identifier>(ns->clone()));
@@ -93,7 +95,7 @@ struct Import : public ASTNode
 	Identifier* ns;
 
 protected:
-	Import() { }
+	Import() { setNodeType(this); }
 };
 
 } } }
@@ -34,6 +34,7 @@ struct Internal : public ASTNode
 
 	Internal()
 	{
+		setNodeType(this);
 		VoidTy     = new TypeSpecifier(PrimitiveType::VOID_TYPE);
 		BooleanTy  = new TypeSpecifier(PrimitiveType::BOOL_TYPE);
 		Int8Ty     = new TypeSpecifier(PrimitiveType::INT8_TYPE);
@@ -120,7 +121,7 @@ struct Internal : public ASTNode
 		END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	Internal* internal = new Internal();
 
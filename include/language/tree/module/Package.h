@@ -41,8 +41,9 @@ struct Package : public ASTNode
 	DEFINE_VISITABLE();
 	DEFINE_HIERARCHY(Package, (Package)(ASTNode));
 
-	explicit Package(SimpleIdentifier* _id) : id(_id), annotations(NULL)
+	explicit Package(SimpleIdentifier* _id) : id(_id), annotations(NULL), imported_object_count(0)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(_id && "null identifier for package node is not allowed");
 
 		id->parent = this;
@@ -55,11 +56,11 @@ struct Package : public ASTNode
 		annotations = anns;
 	}
 
-	Package* findPackage(const std::wstring& name)
+	Package* findPackage(const Symbol& name)
 	{
 		foreach(i, children)
 		{
-			if((*i)->id->toString().compare(name) == 0)
+			if((*i)->id->name == name)
 				return (*i);
 		}
 		return NULL;
@@ -81,6 +82,19 @@ struct Package : public ASTNode
 		objects.push_back(object);
 	}
 
+	/**
+	 * Mark all objects currently in this package (and its sub-packages) as imported
+	 *
+	 * Objects added afterwards, like template instantiations, are not imported even if the package is.
+	 */
+	void markImported(bool is_imported)
+	{
+		imported_object_count = is_imported ? objects.size() : 0;
+
+		foreach(i, children)
+			(*i)->markImported(is_imported);
+	}
+
     virtual bool isEqualImpl(const ASTNode& rhs, ASTNodeSet& visited) const
     {
     	BEGIN_COMPARE()
@@ -101,7 +115,7 @@ struct Package : public ASTNode
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	Package* cloned = new Package((id) ? cast<SimpleIdentifier>(id->clone()) : NULL);
 
@@ -119,7 +133,7 @@ struct Package : public ASTNode
 
     bool merge(Package& rhs)
     {
-    	if(!id->isEqual(*rhs.id))
+    	if(id->name != rhs.id->name)
     		return false;
 
     	foreach(i, rhs.children)
@@ -127,7 +141,7 @@ struct Package : public ASTNode
     		bool merged = false;
     		foreach(j, children)
 			{
-    			if((*i)->id->isEqual(*(*j)->id))
+    			if((*i)->id->name == (*j)->id->name)
     			{
     				(*j)->merge(**i);
     				merged = true;
@@ -166,9 +180,10 @@ struct Package : public ASTNode
 	std::vector<Package*> children;
 	std::vector<ASTNode*> objects;
 	Annotations* annotations;
+	std::size_t imported_object_count; // the leading objects which came from an imported AST, not serialized
 
 protected:
-	Package() { }
+	Package() : imported_object_count(0) { setNodeType(this); }
 };
 
 } } }
@@ -40,15 +40,23 @@ struct Source : public ASTNode
 
 	explicit Source(const std::string& filename, bool is_imported = false) : is_imported(is_imported), filename(filename), root(new Package(new SimpleIdentifier(L"")))
 	{
+		setNodeType(this);
 		root->parent = this;
 	}
 
 	explicit Source(const std::string& filename, Package* root, bool is_imported = false) : is_imported(is_imported), filename(filename), root(root)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(root && "null root for Source node is not allowed");
 		root->parent = this;
 	}
 
+	void markImported(bool imported)
+	{
+		is_imported = imported;
+		if(root) root->markImported(imported);
+	}
+
 	void addImport(Import* import)
 	{
 		import->parent = this;
@@ -72,7 +80,7 @@ struct Source : public ASTNode
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	Source* cloned = new Source(filename, cast<Package>(root->clone()));
 
@@ -100,7 +108,7 @@ struct Source : public ASTNode
 
 private:
 	Source() : is_imported(false)
-	{ }
+	{ setNodeType(this); }
 };
 
 } } }
@@ -31,7 +31,7 @@ namespace detail {
 struct IdentifierCompare {
     bool operator()(tree::Identifier* const  __x, tree::Identifier* const __y) const
     {
-    	return (__x->toString() < __y->toString());
+    	return Identifier::compareName(*__x, *__y) < 0;
     }
 };
 
@@ -44,8 +44,40 @@ struct Tangle : public ASTNode
 	DEFINE_VISITABLE();
 	DEFINE_HIERARCHY(Tangle, (Tangle)(ASTNode));
 
+	/**
+	 * Mangled type and symbol ids handed out to the declarations of a tangle, [first, next) (see
+	 * ManglingStage)
+	 */
+	struct MangledIds
+	{
+		MangledIds() : first_type_id(0), next_type_id(0), first_symbol_id(0), next_symbol_id(0)
+		{ }
+
+		bool overlaps(const MangledIds& rhs) const
+		{
+			return (first_type_id < rhs.next_type_id && rhs.first_type_id < next_type_id) ||
+			       (first_symbol_id < rhs.next_symbol_id && rhs.first_symbol_id < next_symbol_id);
+		}
+
+		template<typename Archive>
+		void serialize(Archive& ar, const unsigned int version)
+		{
+			UNUSED_ARGUMENT(version);
+			ar & first_type_id;
+			ar & next_type_id;
+			ar & first_symbol_id;
+			ar & next_symbol_id;
+		}
+
+		uint64 first_type_id;
+		uint64 next_type_id;
+		uint64 first_symbol_id;
+		uint64 next_symbol_id;
+	};
+
 	Tangle() : internal(new Internal())
 	{
+		setNodeType(this);
 		internal->parent = this;
 	}
 
@@ -60,7 +92,7 @@ struct Tangle : public ASTNode
 	void markImported(bool is_imported)
 	{
 		foreach(i, sources)
-			(i->second)->is_imported = is_imported;
+			(i->second)->markImported(is_imported);
 	}
 
 	void merge(Tangle& t)
@@ -70,6 +102,9 @@ struct Tangle : public ASTNode
 			addSource(i->first, i->second);
 		}
 		t.sources.clear();
+
+		mangled_ids.next_type_id = std::max(mangled_ids.next_type_id, t.mangled_ids.next_type_id);
+		mangled_ids.next_symbol_id = std::max(mangled_ids.next_symbol_id, t.mangled_ids.next_symbol_id);
 	}
 
     virtual bool isEqualImpl(const ASTNode& rhs, ASTNodeSet& visited) const
@@ -88,7 +123,7 @@ struct Tangle : public ASTNode
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	Tangle* cloned = new Tangle();
 
@@ -102,6 +137,7 @@ struct Tangle : public ASTNode
 
     	ar & boost::serialization::base_object<ASTNode>(*this);
     	ar & internal;
+    	ar & mangled_ids;
 
     	int size; ar & size;
     	for(int i=0;i<size;++i)
@@ -120,6 +156,7 @@ struct Tangle : public ASTNode
 
     	ar & boost::serialization::base_object<ASTNode>(*this);
     	ar & internal;
+    	ar & mangled_ids;
 
         size_t size = std::count_if(sources.begin(), sources.end(), [&](const std::pair<const Identifier*, Source*>& p) {
             if(p.second->is_imported) return false;
@@ -139,6 +176,10 @@ struct Tangle : public ASTNode
 
 	Internal* internal;
 	std::multimap<Identifier*, Source*, detail::IdentifierCompare> sources;
+
+	// merge() keeps next past the ids of the merged tangles, so the ones handed out next don't
+	// collide with any imported declaration
+	MangledIds mangled_ids;
 };
 
 } } }
@@ -53,6 +53,7 @@ struct BranchStmt : public Statement
 
 	explicit BranchStmt(OpCode::type opcode, ASTNode* result = NULL) : opcode(opcode), result(result)
 	{
+		setNodeType(this);
 		if(result) result->parent = this;
 	}
 
@@ -71,7 +72,7 @@ struct BranchStmt : public Statement
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new BranchStmt(opcode, (result) ? result->clone() : NULL);
     }
@@ -90,7 +91,7 @@ struct BranchStmt : public Statement
 	ASTNode* result;
 
 protected:
-	BranchStmt() { }
+	BranchStmt() { setNodeType(this); }
 };
 
 } } }
@@ -38,6 +38,7 @@ struct DeclarativeStmt : public Statement
 
 	explicit DeclarativeStmt(Declaration* declaration) : declaration(declaration)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(declaration && "null declaration for declarative statement is not allowed");
 
 		declaration->parent = this;
@@ -57,7 +58,7 @@ struct DeclarativeStmt : public Statement
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new DeclarativeStmt(cast<Declaration>(declaration->clone()));
     }
@@ -74,7 +75,7 @@ struct DeclarativeStmt : public Statement
 	Declaration* declaration;
 
 protected:
-	DeclarativeStmt() { }
+	DeclarativeStmt() { setNodeType(this); }
 };
 
 } } }
@@ -37,6 +37,7 @@ struct ExpressionStmt : public Statement
 
 	explicit ExpressionStmt(Expression* expr) : expr(expr)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(expr && "null expression for expression statement is not allowed");
 
 		expr->parent = this;
@@ -56,7 +57,7 @@ struct ExpressionStmt : public Statement
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new ExpressionStmt(cast<Expression>(expr->clone()));
     }
@@ -73,7 +74,7 @@ struct ExpressionStmt : public Statement
 	Expression* expr;
 
 protected:
-	ExpressionStmt() { }
+	ExpressionStmt() { setNodeType(this); }
 };
 
 } } }
@@ -77,6 +77,7 @@ struct ForStmt : public IterativeStmt
 
 	explicit ForStmt(ASTNode* init, ASTNode* cond, ASTNode* step, ASTNode* block = NULL) : IterativeStmt(block), init(init), cond(cond), step(step)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(init && "null init for for statement is not allowed");
 		BOOST_ASSERT(cond && "null cond for for  statement is not allowed");
 		BOOST_ASSERT(step && "null step for for  statement is not allowed");
@@ -104,7 +105,7 @@ struct ForStmt : public IterativeStmt
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new ForStmt(
     			(init) ? init->clone() : NULL,
@@ -129,7 +130,7 @@ struct ForStmt : public IterativeStmt
 	ASTNode* step;
 
 protected:
-	ForStmt() { }
+	ForStmt() { setNodeType(this); }
 };
 
 struct ForeachStmt : public IterativeStmt
@@ -141,6 +142,7 @@ struct ForeachStmt : public IterativeStmt
 
 	explicit ForeachStmt(ASTNode* iterator, Expression* range, ASTNode* block = NULL) : IterativeStmt(block), iterator(iterator), range(range)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(iterator && "null iterator for foreach statement is not allowed");
 		BOOST_ASSERT(range && "null range for foreach statement is not allowed");
 
@@ -164,7 +166,7 @@ struct ForeachStmt : public IterativeStmt
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new ForeachStmt(
     			(iterator) ? iterator->clone() : NULL,
@@ -186,7 +188,7 @@ struct ForeachStmt : public IterativeStmt
 	Expression* range;
 
 protected:
-	ForeachStmt() { }
+	ForeachStmt() { setNodeType(this); }
 };
 
 struct WhileStmt : public IterativeStmt
@@ -215,6 +217,7 @@ struct WhileStmt : public IterativeStmt
 
 	explicit WhileStmt(Style::type style, Expression* cond, ASTNode* block = NULL) : IterativeStmt(block), style(style), cond(cond)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(cond && "null condition for while statement is not allowed");
 
 		cond->parent = this;
@@ -235,7 +238,7 @@ struct WhileStmt : public IterativeStmt
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	return new WhileStmt(
     			style,
@@ -257,7 +260,7 @@ struct WhileStmt : public IterativeStmt
 	Expression* cond;
 
 protected:
-	WhileStmt() { }
+	WhileStmt() { setNodeType(this); }
 };
 
 } } }
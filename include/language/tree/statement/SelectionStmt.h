@@ -118,6 +118,7 @@ struct IfElseStmt : public SelectionStmt
 
 	explicit IfElseStmt(const Selection& branch) : if_branch(branch)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(branch.cond != NULL);
 		BOOST_ASSERT(branch.block != NULL);
 
@@ -161,7 +162,7 @@ struct IfElseStmt : public SelectionStmt
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	IfElseStmt* cloned = new IfElseStmt(if_branch.clone());
 
@@ -189,7 +190,7 @@ struct IfElseStmt : public SelectionStmt
 	ASTNode* else_block;
 
 protected:
-	IfElseStmt() { }
+	IfElseStmt() { setNodeType(this); }
 };
 
 struct SwitchStmt : public SelectionStmt
@@ -201,6 +202,7 @@ struct SwitchStmt : public SelectionStmt
 
 	explicit SwitchStmt(Expression* node) : node(node), default_block(NULL)
 	{
+		setNodeType(this);
 		BOOST_ASSERT(node && "null node for switch statement is not allowed");
 
 		node->parent = this;
@@ -240,7 +242,7 @@ struct SwitchStmt : public SelectionStmt
     	END_REPLACE()
     }
 
-    virtual ASTNode* clone() const
+    virtual ASTNode* cloneImpl() const
     {
     	SwitchStmt* cloned = new SwitchStmt((node) ? cast<Expression>(node->clone()) : NULL);
 
@@ -268,7 +270,7 @@ struct SwitchStmt : public SelectionStmt
 	ASTNode* default_block;
 
 protected:
-	SwitchStmt() { }
+	SwitchStmt() { setNodeType(this); }
 };
 
 } } }
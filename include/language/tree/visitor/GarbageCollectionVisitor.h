@@ -33,29 +33,29 @@ struct GarbageCollectionVisitor : GenericDoubleVisitor
 {
     CREATE_INVOKER(markInvoker, apply);
 
-	GarbageCollectionVisitor() : nonreachable_set(ASTNodeGC::instance()->objects)
+	GarbageCollectionVisitor() : reachable_set(ASTNodeGC::instance(), ASTNodeGC::instance()->idCount())
 	{
 		REGISTER_ALL_VISITABLE_ASTNODE(markInvoker)
 	}
 
 	~GarbageCollectionVisitor()
 	{
-		ASTNodeGC::instance()->sweep(nonreachable_set);
+		ASTNodeGC::instance()->sweep(reachable_set);
 	}
 
 	inline std::size_t get_sweep_count()
 	{
-		return nonreachable_set.size();
+		return ASTNodeGC::instance()->countNonreachable(reachable_set);
 	}
 
 	void apply(ASTNode& node)
 	{
-		nonreachable_set.erase(&node);
+		reachable_set.insert(&node);
 		if(!Composed)
 			revisit(node);
 	}
 
-	unordered_set<const ASTNode*> nonreachable_set;
+	DenseNodeSet reachable_set;
 };
 
 } } } }
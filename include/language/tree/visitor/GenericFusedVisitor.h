@@ -0,0 +1,180 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_TREE_VISITOR_GENERICFUSEDVISITOR_H_
+#define ZILLIANS_LANGUAGE_TREE_VISITOR_GENERICFUSEDVISITOR_H_
+
+#include "core/Prerequisite.h"
+#include "language/tree/visitor/GenericDoubleVisitor.h"
+#include <vector>
+
+namespace zillians { namespace language { namespace tree { namespace visitor {
+
+/**
+ * GenericFusedVisitor runs several ordinary (self-recursive) GenericDoubleVisitor's in a single walk
+ *
+ * Unlike GenericComposableVisitor, the components don't have to be written for composition: their
+ * revisit() calls are routed back here through detail::RevisitHook. At every node the followers are
+ * invoked first and their revisit() of that node only records that they want to descend; then the
+ * leader (if any) is invoked, and its revisit() walks the children once for everybody. A follower
+ * which doesn't revisit a node doesn't see that node's subtree, exactly like when it runs alone.
+ *
+ * Hence a follower must do all its work on a node before calling revisit() on it (pre-order), while
+ * the leader may also do work after revisit() (post-order). At most one leader is allowed.
+ *
+ * @note terminateRevisit() is not supported by fused components
+ */
+struct GenericFusedVisitor : public GenericDoubleVisitor, public detail::RevisitHook
+{
+	CREATE_INVOKER(applyInvoker, apply)
+
+	GenericFusedVisitor() : leader(NULL), leader_active(true), active(0), requested(0), current(NULL)
+	{
+		REGISTER_ALL_VISITABLE_ASTNODE(applyInvoker)
+	}
+
+	virtual ~GenericFusedVisitor()
+	{
+		foreach(i, followers)
+			(*i)->revisit_hook = NULL;
+		if(leader)
+			leader->revisit_hook = NULL;
+	}
+
+	void addFollower(GenericDoubleVisitor& visitor)
+	{
+		BOOST_ASSERT(followers.size() < 32 && "too many fused visitors");
+		BOOST_ASSERT(!visitor.revisit_hook && "visitor already fused");
+
+		adoptTraversalMode(visitor);
+		visitor.revisit_hook = this;
+		active |= (1u << followers.size());
+		followers.push_back(&visitor);
+	}
+
+	void setLeader(GenericDoubleVisitor& visitor)
+	{
+		BOOST_ASSERT(!leader && "only one fused visitor may do work after revisit()");
+		BOOST_ASSERT(!visitor.revisit_hook && "visitor already fused");
+
+		adoptTraversalMode(visitor);
+		visitor.revisit_hook = this;
+		leader = &visitor;
+	}
+
+	void apply(ASTNode& node)
+	{
+		ASTNode* parent_current = current;
+		uint32 parent_requested = requested;
+
+		current = &node;
+		requested = 0;
+
+		for(uint32 i = 0; i < followers.size(); ++i)
+		{
+			if(active & (1u << i))
+				followers[i]->visit(node);
+		}
+
+		if(leader && leader_active)
+			leader->visit(node);
+
+		// the leader didn't descend (or there's no leader), but some followers still want to
+		if(requested)
+		{
+			uint32 mask = requested;
+			requested = 0;
+			descend(node, mask, false);
+		}
+
+		current = parent_current;
+		requested = parent_requested;
+	}
+
+	virtual void revisit(GenericDoubleVisitor& component, ASTNode& node)
+	{
+		if(&component == leader)
+		{
+			if(&node == current)
+			{
+				uint32 mask = requested;
+				requested = 0;
+				descend(node, mask, true);
+			}
+			else
+			{
+				descend(node, 0, true);
+			}
+		}
+		else
+		{
+			uint32 bit = followerBit(component);
+			if(&node == current)
+				requested |= bit;
+			else
+				descend(node, bit, false);
+		}
+	}
+
+private:
+	void descend(ASTNode& node, uint32 mask, bool with_leader)
+	{
+		uint32 parent_active = active;
+		bool parent_leader_active = leader_active;
+
+		active = mask;
+		leader_active = with_leader;
+		revisitor.visit(node);
+
+		active = parent_active;
+		leader_active = parent_leader_active;
+	}
+
+	// the walk is shared, so all components must agree on what to walk through
+	void adoptTraversalMode(GenericDoubleVisitor& visitor)
+	{
+		if(followers.empty() && !leader)
+			setActiveSourcesOnly(visitor.isActiveSourcesOnly());
+		else
+			BOOST_ASSERT(isActiveSourcesOnly() == visitor.isActiveSourcesOnly() && "fused visitors disagree on active sources only traversal");
+	}
+
+	uint32 followerBit(GenericDoubleVisitor& component)
+	{
+		for(uint32 i = 0; i < followers.size(); ++i)
+		{
+			if(followers[i] == &component)
+				return 1u << i;
+		}
+		UNREACHABLE_CODE();
+		return 0;
+	}
+
+private:
+	std::vector<GenericDoubleVisitor*> followers;
+	GenericDoubleVisitor* leader;
+	bool leader_active;
+	uint32 active;
+	uint32 requested;
+	ASTNode* current;
+};
+
+} } } }
+
+#endif /* ZILLIANS_LANGUAGE_TREE_VISITOR_GENERICFUSEDVISITOR_H_ */
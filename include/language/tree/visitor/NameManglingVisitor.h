@@ -343,8 +343,7 @@ private:
 
 	std::ostream& outStream()
 	{
-		static std::stringstream NullOutStream;
-		return mCurrentOutStream ? *mCurrentOutStream : NullOutStream;
+		return mCurrentOutStream ? *mCurrentOutStream : mMutedOutStream;
 	}
 
 	void mangleParent(ASTNode* node)
@@ -419,6 +418,7 @@ private:
 	int mParamDepth;
 	bool mModeCallByValue;
 	std::stringstream* mCurrentOutStream;
+	std::stringstream mMutedOutStream; // per visitor, so concurrent compile jobs never share it
 
 	class AliasMgr
 	{
@@ -509,8 +509,8 @@ private:
 
 	void mangleVoid()
 	{
-		TypeSpecifier type_specifier(PrimitiveType::VOID_TYPE);
-		visit(type_specifier);
+		// what mangling a primitive void TypeSpecifier gives, without creating one on the stack
+		outStream() << "v";
 	}
 
 	static std::wstring getBasename(Identifier* ident)
@@ -573,7 +573,7 @@ private:
 #if 0 // HACK: disabled to avoid BOOST_ASSERT
     		ResolvedType::set(type_specifier, package);
 #else
-    		type_specifier->set<ResolvedType>(new ResolvedType(node));
+    		NodeContextTable<ResolvedType>::assign(type_specifier, ResolvedType(node));
 #endif
     		return type_specifier;
     	}
@@ -586,9 +586,9 @@ private:
 public:
 	std::string encode(const std::wstring ucs4)
 	{
-		auto toAsciiNumber = [](char c)
+		auto toAsciiNumber = [](char c) -> std::string
 			{
-				static char buffer[4];
+				char buffer[4];
 				snprintf(buffer, 3, "%d", c);
 				return buffer;
 			};
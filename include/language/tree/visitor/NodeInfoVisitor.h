@@ -21,26 +21,22 @@
 #define ZILLIANS_LANGUAGE_TREE_VISITOR_GENERAL_NODEINFOVISITOR_H_
 
 #include "core/Prerequisite.h"
-#include "core/Visitor.h"
-#include "language/tree/visitor/GenericVisitor.h"
+#include "language/tree/visitor/StaticVisitor.h"
 
 namespace zillians { namespace language { namespace tree { namespace visitor {
 
-struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive_dfs>
+// NodeInfoVisitor is created all over the resolver, so it's dispatched statically to make construction free
+struct NodeInfoVisitor : StaticVisitor<NodeInfoVisitor>
 {
-	CREATE_INVOKER(infoInvoker, info)
-
 	NodeInfoVisitor(int32 max_depth = 20) : current_depth(0), max_depth(max_depth)
-	{
-		REGISTER_ALL_VISITABLE_ASTNODE(infoInvoker)
-	}
+	{ }
 
-	void info(ASTNode& node)
+	void apply(ASTNode& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 	}
 
-	void info(Identifier& node)
+	void apply(Identifier& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -50,7 +46,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << node.toString();
 	}
 
-	void info(Import& node)
+	void apply(Import& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -74,7 +70,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		}
 	}
 
-	void info(Package& node)
+	void apply(Package& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -87,7 +83,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 			stream << node.id->toString();
 	}
 
-	void info(Block& node)
+	void apply(Block& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -102,7 +98,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 			stream << L"[block]";
 	}
 
-	void info(TypeSpecifier& node)
+	void apply(TypeSpecifier& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -112,7 +108,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << node.toString();
 	}
 
-	void info(ClassDecl& node)
+	void apply(ClassDecl& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -122,7 +118,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << node.name->toString();
 	}
 
-	void info(InterfaceDecl& node)
+	void apply(InterfaceDecl& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -132,7 +128,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << node.name->toString();
 	}
 
-	void info(EnumDecl& node)
+	void apply(EnumDecl& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -142,7 +138,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << node.name->toString();
 	}
 
-	void info(FunctionDecl& node)
+	void apply(FunctionDecl& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -152,7 +148,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << node.name->toString();
 	}
 
-	void info(TypenameDecl& node)
+	void apply(TypenameDecl& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -162,7 +158,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << node.name->toString();
 	}
 
-	void info(Statement& node)
+	void apply(Statement& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -172,7 +168,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[stmt]";
 	}
 
-	void info(BranchStmt& node)
+	void apply(BranchStmt& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -182,7 +178,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[branch_stmt]";
 	}
 
-	void info(DeclarativeStmt& node)
+	void apply(DeclarativeStmt& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -192,7 +188,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[decl_stmt]";
 	}
 
-	void info(ExpressionStmt& node)
+	void apply(ExpressionStmt& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -202,7 +198,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[expr_stmt]";
 	}
 
-	void info(ForStmt& node)
+	void apply(ForStmt& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -212,7 +208,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[for_stmt]";
 	}
 
-	void info(ForeachStmt& node)
+	void apply(ForeachStmt& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -222,7 +218,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[foreach_stmt]";
 	}
 
-	void info(WhileStmt& node)
+	void apply(WhileStmt& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -232,7 +228,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[while_stmt]";
 	}
 
-	void info(IfElseStmt& node)
+	void apply(IfElseStmt& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -242,7 +238,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[ifelse_stmt]";
 	}
 
-	void info(SwitchStmt& node)
+	void apply(SwitchStmt& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -252,7 +248,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[switch_stmt]";
 	}
 
-	void info(Expression& node)
+	void apply(Expression& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -262,7 +258,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[expr]";
 	}
 
-	void info(UnaryExpr& node)
+	void apply(UnaryExpr& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -272,7 +268,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[unary_expr]";
 	}
 
-	void info(BinaryExpr& node)
+	void apply(BinaryExpr& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -282,7 +278,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[binary_expr]";
 	}
 
-	void info(TernaryExpr& node)
+	void apply(TernaryExpr& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -292,7 +288,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[ternary_expr]";
 	}
 
-	void info(CallExpr& node)
+	void apply(CallExpr& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -302,7 +298,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[call_expr]";
 	}
 
-	void info(CastExpr& node)
+	void apply(CastExpr& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -312,7 +308,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[cast_expr]";
 	}
 
-	void info(PrimaryExpr& node)
+	void apply(PrimaryExpr& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
@@ -322,7 +318,7 @@ struct NodeInfoVisitor : Visitor<ASTNode, void, VisitorImplementation::recursive
 		stream << L"[primary_expr]";
 	}
 
-	void info(MemberExpr& node)
+	void apply(MemberExpr& node)
 	{
 		if(node.parent) tryVisit(*node.parent);
 
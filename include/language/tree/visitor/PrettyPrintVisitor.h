@@ -1121,7 +1121,7 @@ private:
 		{
 			increaseIdent();
 			{
-				STREAM << L"<source_info line=\"" << source_info->line << "\" column=\"" << source_info->column << "\"/>" << std::endl;
+				STREAM << L"<source_info line=\"" << source_info->line() << "\" column=\"" << source_info->column() << "\"/>" << std::endl;
 			}
 			decreaseIdent();
 		}
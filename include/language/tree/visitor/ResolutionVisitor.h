@@ -610,22 +610,7 @@ struct ResolutionVisitor : Visitor<ASTNode, void, VisitorImplementation::recursi
 
         zillians::language::stage::SourceInfoContext* declContext = stage::SourceInfoContext::get(decl);
         zillians::language::stage::SourceInfoContext*  useContext = stage::SourceInfoContext::get(use);
-        if(declContext->line < useContext->line)
-        {
-            return true;
-        }
-        else if(useContext->line < declContext->line)
-        {
-            return false;
-        }
-        else if(declContext->column <= useContext->column)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
+        return declContext->compare(*useContext) <= 0;
     }
 
 	void resolve(VariableDecl& node)
@@ -672,22 +657,7 @@ struct ResolutionVisitor : Visitor<ASTNode, void, VisitorImplementation::recursi
 
         zillians::language::stage::SourceInfoContext* declContext = stage::SourceInfoContext::get(decl);
         zillians::language::stage::SourceInfoContext*  useContext = stage::SourceInfoContext::get(use);
-        if(declContext->line < useContext->line)
-        {
-            return true;
-        }
-        else if(useContext->line < declContext->line)
-        {
-            return false;
-        }
-        else if(declContext->column <= useContext->column)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
+        return declContext->compare(*useContext) <= 0;
     }
 
 	void resolve(TypenameDecl& node)
@@ -796,7 +766,7 @@ public:
 			// if both use and decl are templated identifier, we need to make sure it's compatible
 			TemplatedIdentifier* use_template = cast<TemplatedIdentifier>(use);
 			TemplatedIdentifier* decl_template = cast<TemplatedIdentifier>(decl);
-			if(use_template->id->toString() == decl_template->id->toString())
+			if(use_template->id->hasSameName(*decl_template->id))
 			{
 				if(decl_template->isVariadic())
 				{
@@ -913,14 +883,14 @@ public:
 		{
 			BOOST_ASSERT(isa<SimpleIdentifier>(use));
 			BOOST_ASSERT(isa<SimpleIdentifier>(decl));
-			return (use->toString() == decl->toString());
+			return (cast<SimpleIdentifier>(use)->name == cast<SimpleIdentifier>(decl)->name);
 		}
 		else if(ASTNodeHelper::isCallIdentifier(current) && !isa<TemplatedIdentifier>(use) && isa<TemplatedIdentifier>(decl))
         {
 			BOOST_ASSERT(isa<SimpleIdentifier>(use));
 			BOOST_ASSERT(!isa<SimpleIdentifier>(decl));
             TemplatedIdentifier* declTemplatedId = cast<TemplatedIdentifier>(decl);
-            return use->toString() == declTemplatedId->id->toString();
+            return use->hasSameName(*declTemplatedId->id);
         }
 		else
 		{
@@ -0,0 +1,119 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_TREE_VISITOR_STATICVISITOR_H_
+#define ZILLIANS_LANGUAGE_TREE_VISITOR_STATICVISITOR_H_
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/tree/visitor/detail/GenericChildrenTraversal.h"
+#include <boost/preprocessor/seq/for_each.hpp>
+
+#define STATIC_VISITOR_DISPATCH_CASE(r, impl, elem) \
+		case ASTNodeType::ASTNODE_TYPE_NAME(elem): return impl.apply(static_cast<ASTNODE_TYPE_NAME(elem)&>(node));
+
+namespace zillians { namespace language { namespace tree { namespace visitor {
+
+/**
+ * StaticVisitor is the compile-time dispatched counterpart of Visitor<ASTNode, ...>
+ *
+ * Derived implements apply() overloads just like a runtime visitor does, and visit() picks the
+ * overload for the dynamic type of the node with a switch on ASTNode::nodeType(). Overload
+ * resolution happens at compile time, so a node type without its own apply() falls back to the
+ * closest base class overload, and apply() calls can be inlined.
+ *
+ * There's no invoker table to register, so constructing a visitor costs nothing beyond its own
+ * members. Use it for visitors created on hot paths (e.g. NodeInfoVisitor in the resolver).
+ *
+ * @see StaticDoubleVisitor
+ */
+template<typename Derived, typename ReturnType = void>
+struct StaticVisitor
+{
+	ReturnType visit(ASTNode& node)
+	{
+		Derived& impl = static_cast<Derived&>(*this);
+		switch(node.nodeType())
+		{
+		BOOST_PP_SEQ_FOR_EACH(STATIC_VISITOR_DISPATCH_CASE, impl, ASTNODE_TYPE_HIERARCHY)
+		}
+		UNREACHABLE_CODE();
+		return impl.apply(node);
+	}
+};
+
+/**
+ * StaticDoubleVisitor is the compile-time dispatched counterpart of GenericDoubleVisitor
+ *
+ * Derived implements apply() for the nodes it cares about (including the apply(ASTNode&) fallback)
+ * and calls revisit() to continue into the children, which are handed back to Derived::visit();
+ * the traversal order is the same as GenericDoubleVisitor's since both share
+ * detail::GenericChildrenTraversal.
+ */
+template<typename Derived>
+struct StaticDoubleVisitor : StaticVisitor<Derived>
+{
+	struct ApplyVisitor : StaticVisitor<ApplyVisitor>, detail::GenericChildrenTraversal<Derived>
+	{
+		using detail::GenericChildrenTraversal<Derived>::apply;
+	};
+
+	StaticDoubleVisitor()
+	{
+		revisitor.user_visitor = static_cast<Derived*>(this);
+	}
+
+	StaticDoubleVisitor(const StaticDoubleVisitor& other)
+	{
+		revisitor.user_visitor = static_cast<Derived*>(this);
+		revisitor.active_sources_only = other.revisitor.active_sources_only;
+	}
+
+	StaticDoubleVisitor& operator=(const StaticDoubleVisitor& other)
+	{
+		revisitor.active_sources_only = other.revisitor.active_sources_only;
+		return *this;
+	}
+
+	void revisit(ASTNode& node)
+	{
+		revisitor.visit(node);
+	}
+
+	/**
+	 * Walk the active sources only, leaving out everything that came from an imported AST
+	 *
+	 * @see detail::GenericChildrenTraversal::active_sources_only
+	 */
+	void setActiveSourcesOnly(bool enabled)
+	{
+		revisitor.active_sources_only = enabled;
+	}
+
+	bool isActiveSourcesOnly() const
+	{
+		return revisitor.active_sources_only;
+	}
+
+	ApplyVisitor revisitor;
+};
+
+} } } }
+
+#endif /* ZILLIANS_LANGUAGE_TREE_VISITOR_STATICVISITOR_H_ */
@@ -21,6 +21,7 @@
  */
 
 #include "language/ThorScriptCompiler.h"
+#include "language/stage/FusedStage.h"
 #include "language/stage/parser/ThorScriptParserStage.h"
 #include "language/stage/transformer/LiteralCompactionStage.h"
 #include "language/stage/transformer/RestructureStage.h"
@@ -46,19 +47,47 @@ ThorScriptCompiler::ThorScriptCompiler() : stage::StageBuilder(true)
 		boost::mpl::vector<
 			ThorScriptParserStage,
 			ASTDeserializationStage,
-			SemanticVerificationStage0,
-			LiteralCompactionStage,
+			FusedStage<boost::mpl::vector<LiteralCompactionStage, SemanticVerificationStage0>>,
 			RestructureStage,
 			ResolutionStage,
             ImplicitConversionStage,
-			SemanticVerificationStage1,
+			FusedStage<boost::mpl::vector<ManglingStage, SemanticVerificationStage1>>,
 			StaticTestVerificationStage,
-			ManglingStage,
 			LLVMGeneratorStage,
 			LLVMDebugInfoGeneratorStage,
 			LLVMBitCodeGeneratorStage,
 			ASTSerializationStage>>();
 
+	// same as the default mode, but with every stage run on its own so they can be profiled separately
+	addMode<
+		boost::mpl::vector<
+			ThorScriptParserStage,
+			ASTDeserializationStage,
+			LiteralCompactionStage,
+			SemanticVerificationStage0,
+			RestructureStage,
+			ResolutionStage,
+			ImplicitConversionStage,
+			ManglingStage,
+			SemanticVerificationStage1,
+			StaticTestVerificationStage,
+			LLVMGeneratorStage,
+			LLVMDebugInfoGeneratorStage,
+			LLVMBitCodeGeneratorStage,
+			ASTSerializationStage>>("mode-unfused", "for profiling each stage of the default mode");
+
+	// the front half of the default mode, used to build the system API into the precompiled prelude (see --emit-prelude)
+	addMode<
+		boost::mpl::vector<
+			ThorScriptParserStage,
+			ASTDeserializationStage,
+			FusedStage<boost::mpl::vector<LiteralCompactionStage, SemanticVerificationStage0>>,
+			RestructureStage,
+			ResolutionStage,
+			ImplicitConversionStage,
+			FusedStage<boost::mpl::vector<ManglingStage, SemanticVerificationStage1>>,
+			ASTSerializationStage>>("mode-prelude", "for building the precompiled system prelude");
+
 	addMode<
 		boost::mpl::vector<
 			ThorScriptParserStage,
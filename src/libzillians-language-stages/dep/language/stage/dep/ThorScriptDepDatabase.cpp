@@ -0,0 +1,399 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/stage/dep/ThorScriptDepDatabase.h"
+#include "utility/Foreach.h"
+#include "utility/UnicodeUtil.h"
+#include "utility/sha1.h"
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/set.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+namespace zillians { namespace language { namespace stage {
+
+namespace {
+
+const uint32 format_version = 1;
+
+std::string normalize(const boost::filesystem::path& p)
+{
+    std::string result = p.string();
+    if(result.compare(0, 2, "./") == 0)
+    {
+        result.erase(0, 2);
+    }
+    return result;
+}
+
+bool readFile(const std::string& filename, std::string& content)
+{
+    std::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+    if(!fin.is_open())
+    {
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    return !fin.bad();
+}
+
+}
+
+template<typename Archive>
+void ThorScriptDepDatabase::FileRecord::serialize(Archive& ar, const unsigned int version)
+{
+    UNUSED_ARGUMENT(version);
+    ar & mtime;
+    ar & size;
+    ar & hash;
+    ar & imports;
+}
+
+template<typename Archive>
+void ThorScriptDepDatabase::DirectoryRecord::serialize(Archive& ar, const unsigned int version)
+{
+    UNUSED_ARGUMENT(version);
+    ar & mtime;
+    ar & files;
+    ar & directories;
+}
+
+template<typename Archive>
+void ThorScriptDepDatabase::BundleRecord::serialize(Archive& ar, const unsigned int version)
+{
+    UNUSED_ARGUMENT(version);
+    ar & mtime;
+    ar & size;
+    ar & packages;
+}
+
+ThorScriptDepDatabase::ThorScriptDepDatabase(const boost::filesystem::path& file) : file(file), previousStart(0), start(std::time(NULL))
+{ }
+
+bool ThorScriptDepDatabase::load()
+{
+    std::ifstream fin(file.string().c_str());
+    if(!fin.good())
+    {
+        return false;
+    }
+
+    try
+    {
+        boost::archive::text_iarchive ia(fin);
+        uint32 version = 0;
+        ia >> version;
+        if(version == format_version)
+        {
+            ia >> previousStart;
+            ia >> files;
+            ia >> directories;
+            ia >> bundles;
+            ia >> edges;
+            return true;
+        }
+    }
+    catch(const std::exception&)
+    {
+        // a broken database is as good as none
+    }
+
+    previousStart = 0;
+    files.clear();
+    directories.clear();
+    bundles.clear();
+    edges.clear();
+    return false;
+}
+
+bool ThorScriptDepDatabase::save()
+{
+    namespace fs = boost::filesystem;
+
+    for(auto i = files.begin(); i != files.end(); )
+        i = usedFiles.count(i->first) ? std::next(i) : files.erase(i);
+    for(auto i = directories.begin(); i != directories.end(); )
+        i = usedDirectories.count(i->first) ? std::next(i) : directories.erase(i);
+    for(auto i = bundles.begin(); i != bundles.end(); )
+        i = usedBundles.count(i->first) ? std::next(i) : bundles.erase(i);
+
+    boost::system::error_code error;
+    if(file.has_parent_path())
+    {
+        fs::create_directories(file.parent_path(), error);
+    }
+
+    fs::path temporary = fs::unique_path(file.string() + ".%%%%-%%%%.tmp", error);
+    if(error)
+    {
+        return false;
+    }
+
+    try
+    {
+        std::ofstream fout(temporary.string().c_str());
+        if(!fout.good())
+        {
+            return false;
+        }
+
+        boost::archive::text_oarchive oa(fout);
+        oa << format_version;
+        oa << start;
+        oa << files;
+        oa << directories;
+        oa << bundles;
+        oa << edges;
+    }
+    catch(const std::exception&)
+    {
+        fs::remove(temporary, error);
+        return false;
+    }
+
+    fs::rename(temporary, file, error);
+    if(error)
+    {
+        fs::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+std::set<std::string> ThorScriptDepDatabase::globTsFiles(const std::string& dir)
+{
+    std::set<std::string> result;
+    listDirectory(dir, result);
+    return result;
+}
+
+void ThorScriptDepDatabase::scanImports(const std::vector<std::string>& filenames, uint32 threads, std::vector<ThorScriptImportScanner::Result>& results)
+{
+    namespace fs = boost::filesystem;
+
+    results.assign(filenames.size(), ThorScriptImportScanner::Result());
+
+    // stat everything, files whose record is still trusted need nothing else
+    std::vector<std::size_t> pending;
+    std::vector<std::time_t> mtimes(filenames.size(), 0);
+    std::vector<uint64> sizes(filenames.size(), 0);
+    for(std::size_t i = 0; i != filenames.size(); ++i)
+    {
+        usedFiles.insert(filenames[i]);
+
+        boost::system::error_code error;
+        mtimes[i] = fs::last_write_time(filenames[i], error);
+        if(!error)
+            sizes[i] = fs::file_size(filenames[i], error);
+
+        auto record = files.find(filenames[i]);
+        if(!error && record != files.end() && record->second.size == sizes[i] && isTrusted(record->second.mtime, mtimes[i]))
+        {
+            foreach(package, record->second.imports)
+                results[i].packages.push_back(s_to_ws(*package));
+            results[i].succeeded = true;
+        }
+        else
+        {
+            pending.push_back(i);
+        }
+    }
+
+    // the rest is read and hashed, only files whose content really changed are scanned again
+    std::vector<std::string> hashes(filenames.size());
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+        std::string content;
+        for(std::size_t k = next++; k < pending.size(); k = next++)
+        {
+            std::size_t i = pending[k];
+            if(!readFile(filenames[i], content))
+                continue;
+
+            hashes[i] = sha1::sha1(content);
+            auto record = files.find(filenames[i]);
+            if(record != files.end() && record->second.hash == hashes[i])
+            {
+                foreach(package, record->second.imports)
+                    results[i].packages.push_back(s_to_ws(*package));
+                results[i].succeeded = true;
+            }
+            else
+            {
+                results[i].succeeded = ThorScriptImportScanner::scanBuffer(content.data(), content.data() + content.size(), results[i].packages);
+            }
+        }
+    };
+
+    std::size_t thread_count = std::min<std::size_t>(std::max<uint32>(threads, 1), pending.size());
+    std::vector<std::thread> workers;
+    for(std::size_t i = 1; i < thread_count; ++i)
+        workers.push_back(std::thread(worker));
+    worker();
+    for(std::size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+    foreach(k, pending)
+    {
+        if(!results[*k].succeeded)
+        {
+            files.erase(filenames[*k]);
+            continue;
+        }
+
+        FileRecord& record = files[filenames[*k]];
+        record.mtime = mtimes[*k];
+        record.size = sizes[*k];
+        record.hash = hashes[*k];
+        record.imports.clear();
+        foreach(package, results[*k].packages)
+            record.imports.push_back(ws_to_s(*package));
+    }
+}
+
+std::string ThorScriptDepDatabase::hashOf(const std::string& filename) const
+{
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code error;
+    std::time_t mtime = fs::last_write_time(filename, error);
+    uint64 size = error ? 0 : fs::file_size(filename, error);
+
+    auto record = files.find(filename);
+    if(!error && record != files.end() && record->second.size == size && isTrusted(record->second.mtime, mtime))
+    {
+        return record->second.hash;
+    }
+
+    std::string content;
+    if(!readFile(filename, content))
+    {
+        return std::string();
+    }
+    return sha1::sha1(content);
+}
+
+bool ThorScriptDepDatabase::findBundle(const std::string& astPath, std::vector<std::wstring>& packages)
+{
+    namespace fs = boost::filesystem;
+
+    usedBundles.insert(astPath);
+
+    boost::system::error_code error;
+    std::time_t mtime = fs::last_write_time(astPath, error);
+    uint64 size = error ? 0 : fs::file_size(astPath, error);
+
+    auto record = bundles.find(astPath);
+    if(error || record == bundles.end() || record->second.size != size || !isTrusted(record->second.mtime, mtime))
+    {
+        return false;
+    }
+
+    foreach(package, record->second.packages)
+        packages.push_back(s_to_ws(*package));
+    return true;
+}
+
+void ThorScriptDepDatabase::storeBundle(const std::string& astPath, const std::vector<std::wstring>& packages)
+{
+    namespace fs = boost::filesystem;
+
+    usedBundles.insert(astPath);
+
+    boost::system::error_code error;
+    BundleRecord record;
+    record.mtime = fs::last_write_time(astPath, error);
+    if(!error)
+        record.size = fs::file_size(astPath, error);
+    if(error)
+    {
+        bundles.erase(astPath);
+        return;
+    }
+
+    foreach(package, packages)
+        record.packages.push_back(ws_to_s(*package));
+    bundles[astPath] = record;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// private member function
+//////////////////////////////////////////////////////////////////////////////
+
+bool ThorScriptDepDatabase::isTrusted(std::time_t recordMtime, std::time_t mtime) const
+{
+    // mtime has a resolution of one second, see class comment
+    return recordMtime == mtime && mtime < previousStart;
+}
+
+void ThorScriptDepDatabase::listDirectory(const std::string& dir, std::set<std::string>& result)
+{
+    namespace fs = boost::filesystem;
+
+    // a package directory is globbed for every file importing it, but only checked once per run
+    auto record = directories.find(dir);
+    if(!usedDirectories.count(dir))
+    {
+        boost::system::error_code error;
+        std::time_t mtime = fs::last_write_time(dir, error);
+        if(error || !fs::is_directory(dir, error))
+        {
+            return;
+        }
+
+        usedDirectories.insert(dir);
+
+        // a directory's mtime changes when entries are added, removed or renamed, not when files are written
+        if(record == directories.end() || !isTrusted(record->second.mtime, mtime))
+        {
+            DirectoryRecord listing;
+            listing.mtime = mtime;
+            for(fs::directory_iterator i(dir, error), end; !error && i != end; i.increment(error))
+            {
+                boost::system::error_code status_error;
+                if(fs::is_directory(i->symlink_status(status_error)))
+                {
+                    listing.directories.push_back(normalize(i->path()));
+                }
+                else if(i->path().extension() == ".t" && fs::is_regular_file(i->path(), status_error))
+                {
+                    listing.files.push_back(normalize(i->path()));
+                }
+            }
+            record = directories.insert(std::make_pair(dir, DirectoryRecord())).first;
+            record->second = listing;
+        }
+    }
+
+    result.insert(record->second.files.begin(), record->second.files.end());
+
+    std::vector<std::string> subdirectories = record->second.directories;
+    foreach(i, subdirectories)
+    {
+        listDirectory(*i, result);
+    }
+}
+
+} } }
@@ -23,6 +23,7 @@
 #include <vector>
 #include <set>
 #include <iterator>
+#include <thread>
 #include <boost/filesystem.hpp>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/adj_list_serialize.hpp>
@@ -35,7 +36,8 @@
 #include "language/stage/dep/ThorScriptDepStage.h"
 #include "utility/sha1.h"
 #include "language/stage/dep/ThorScriptSourceTangleGraph.h"
-#include "language/grammar/ThorScriptPackageDependencyGrammar.h"
+#include "language/stage/dep/ThorScriptImportScanner.h"
+#include "language/stage/dep/ThorScriptDepDatabase.h"
 #include "language/ThorScriptManifest.h"
 #include "utility/UnicodeUtil.h"
 
@@ -49,34 +51,6 @@ namespace zillians { namespace language { namespace stage {
 // static functions
 //////////////////////////////////////////////////////////////////////////////
 
-static std::set<std::string> globAllTsFiles(const std::string& dirPath)
-{
-    std::set<std::string> result;
-    if(!boost::filesystem::exists(dirPath))
-    {
-        return result;
-    }
-    namespace fs = boost::filesystem;
-    fs::path p(dirPath);
-    for (auto i = fs::recursive_directory_iterator(p); i != fs::recursive_directory_iterator(); ++i)
-    {
-        if(fs::exists(i->path()) &&
-           fs::is_regular_file(i->path()) &&
-           i->path().string().substr(i->path().string().size()-2) == ".t")
-        {
-            if(i->path().string().substr(0, 2) == "./")
-            {
-                result.insert(i->path().string().substr(2));
-            }
-            else
-            {
-                result.insert(i->path().string());
-            }
-        }
-    }
-    return result;
-}
-
 static bool isDirectory(const std::string& pathString)
 {
     namespace fs = boost::filesystem;
@@ -153,55 +127,27 @@ static boost::filesystem::path getAstPath(const boost::filesystem::path& bundleF
 
 bool ThorScriptDepStage::parseFileImportedPackages(const std::string& tsFileName, std::set<std::wstring>& packages)
 {
-    std::string filename = tsFileName ;
-    std::ifstream in(filename, std::ios_base::in);
-
-    if(!in.good())
+    // most files have been scanned up front, see execute()
+    auto scanned = scannedImports.find(tsFileName);
+    if(scanned != scannedImports.end())
     {
-        LOG4CXX_ERROR(LoggerWrapper::ParserStage, "failed to open file: " << filename);
-        return false;
-    }
-
-    // ignore the BOM marking the beginning of a UTF-8 file in Windows
-    if(in.peek() == '\xef')
-    {
-        char s[3];
-        in >> s[0] >> s[1] >> s[2];
-        s[3] = '\0';
-        if (s != std::string("\xef\xbb\xbf"))
+        if(!scanned->second.succeeded)
         {
-            std::cerr << "parser error: unexpected characters from input file: " << filename << std::endl;
+            LOG4CXX_ERROR(logger, "failed to scan imports of file: " << tsFileName);
             return false;
         }
+        packages.insert(scanned->second.packages.begin(), scanned->second.packages.end());
+        return true;
     }
 
-    std::string source_code_raw;
-    in.unsetf(std::ios::skipws); // disable white space skipping
-    std::copy(std::istream_iterator<char>(in), std::istream_iterator<char>(), std::back_inserter(source_code_raw));
-
-    // convert is frem UTF8 into UCS4 as a string by using u8_to_u32_iterator
-    std::wstring source_code;
-    utf8_to_ucs4(source_code_raw, source_code);
-
-    // enable correct locale so that we can print UCS4 characters
-    enable_default_locale(std::wcout);
-
-    // try to parse
-    std::vector<std::wstring> resultVec;
-    typedef boost::spirit::classic::position_iterator2<std::wstring::iterator> pos_iterator_type;
-    try
-    {
-        pos_iterator_type begin(source_code.begin(), source_code.end(), s_to_ws(filename));
-        pos_iterator_type end;
-
-        zillians::language::grammar::getImportedPackages(begin, end, resultVec);
-    }
-    catch (std::exception& e)
+    std::vector<ThorScriptImportScanner::Result> results;
+    database->scanImports(std::vector<std::string>(1, tsFileName), 1, results);
+    if(!results[0].succeeded)
     {
-        std::wcerr << "ts-dep parsing error!" << std::endl ;
+        LOG4CXX_ERROR(logger, "failed to scan imports of file: " << tsFileName);
         return false;
     }
-    packages.insert(resultVec.begin(), resultVec.end());
+    packages.insert(results[0].packages.begin(), results[0].packages.end());
     return true;
 }
 
@@ -268,7 +214,7 @@ bool ThorScriptDepStage::addFileDependency(std::string tsFileName, const std::ma
         // if is package directory, recusively add all files under the dir.
         else if(isDirectory(pathName))
         {
-            std::set<std::string> allFilesUnderDir = globAllTsFiles(pathName);
+            std::set<std::string> allFilesUnderDir = database->globTsFiles(pathName);
             for(auto f = allFilesUnderDir.begin(); f != allFilesUnderDir.end(); ++f)
             {
                 boost::graph::add_edge(tsFileName, *f, fileGraph);
@@ -299,6 +245,17 @@ bool ThorScriptDepStage::addFileDependency(std::string tsFileName, const std::ma
 
 bool ThorScriptDepStage::scanBundlePackage(const boost::filesystem::path& astPath, std::multimap<std::string, std::wstring>& allBundlePackage)
 {
+    // loading a whole bundle tree just for its package names is expensive, do it once per bundle
+    std::vector<std::wstring> packages;
+    if(database->findBundle(astPath.string(), packages))
+    {
+        foreach(i, packages)
+        {
+            allBundlePackage.insert(std::make_pair(astPath.string(), *i));
+        }
+        return true;
+    }
+
     if(!boost::filesystem::exists(astPath))
     {
         LOG4CXX_ERROR(logger, "Input file `" << astPath.string() << "` does not exists.");
@@ -319,7 +276,9 @@ bool ThorScriptDepStage::scanBundlePackage(const boost::filesystem::path& astPat
     foreach(i, tangle->sources)
     {
         allBundlePackage.insert(std::make_pair(astPath.string(), i->first->toString()));
+        packages.push_back(i->first->toString());
     }
+    database->storeBundle(astPath.string(), packages);
     return true;
 }
 
@@ -363,9 +322,15 @@ bool ThorScriptDepStage::analyzeTangle(const boost::filesystem::path& buildPath,
 
     // serialization
     std::ofstream fout((buildPath / "ts.dep").string().c_str());
-    boost::archive::text_oarchive oa(fout);
-    oa << tangleG ;
+    if(!fout.is_open())
+        return false;
+    {
+        boost::archive::text_oarchive oa(fout);
+        oa << tangleG ;
+    }
     fout.close();
+    if(fout.fail())
+        return false;
 
     // and restore
     std::ifstream fin((buildPath / "ts.dep").string().c_str());
@@ -404,7 +369,7 @@ bool ThorScriptDepStage::scanAllBundlePackage(const boost::filesystem::path& bui
 // class member function
 //////////////////////////////////////////////////////////////////////////////
 
-ThorScriptDepStage::ThorScriptDepStage() : rootDir("./"), buildPath("./build"), logger(log4cxx::Logger::getLogger("ts-dep"))
+ThorScriptDepStage::ThorScriptDepStage() : scanThreads(1), rootDir("./"), buildPath("./build"), logger(log4cxx::Logger::getLogger("ts-dep"))
 {
     log4cxx::BasicConfigurator::configure();
     logger->setLevel(log4cxx::Level::getAll());
@@ -426,6 +391,7 @@ std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_descriptio
 	option_desc_public->add_options()
         ("root-dir", po::value<std::string>())
         ("build-path", po::value<std::string>())
+        ("scan-threads", po::value<uint32>(), "number of threads scanning imports (defaults to the number of cores)")
         ("input", po::value<std::vector<std::string>>(), "input file")
     ;
 
@@ -446,17 +412,20 @@ bool ThorScriptDepStage::parseOptions(po::variables_map& vm)
     {
         buildPath = vm["build-path"].as<std::string>();
     }
-    if(vm.count("input"))
+    if(vm.count("scan-threads"))
     {
-        inputFiles = vm["input"].as<std::vector<std::string>>();
-        return true;
+        scanThreads = std::max<uint32>(vm["scan-threads"].as<uint32>(), 1);
     }
     else
     {
-        std::set<std::string> inputFileSet = globAllTsFiles("src");
-        inputFiles.assign(inputFileSet.begin(), inputFileSet.end());
-        return true;
+        scanThreads = std::max<uint32>(std::thread::hardware_concurrency(), 1);
+    }
+    if(vm.count("input"))
+    {
+        inputFiles = vm["input"].as<std::vector<std::string>>();
     }
+    // otherwise all files under `src' are globbed in execute(), relative to root-dir
+    return true;
 }
 
 bool ThorScriptDepStage::execute(bool& continue_execution)
@@ -478,6 +447,16 @@ bool ThorScriptDepStage::execute(bool& continue_execution)
         return false;
     }
 
+    // what the previous run learned, only changed files and directories are looked at again
+    database.reset(new ThorScriptDepDatabase(buildPath / "ts.depdb"));
+    database->load();
+
+    if(inputFiles.empty())
+    {
+        std::set<std::string> inputFileSet = database->globTsFiles("src");
+        inputFiles.assign(inputFileSet.begin(), inputFileSet.end());
+    }
+
     foreach(i, inputFiles)
     {
         if(!boost::filesystem::exists(*i))
@@ -505,14 +484,48 @@ bool ThorScriptDepStage::execute(bool& continue_execution)
         LOG4CXX_ERROR(logger, "source directory is empty.");
         return false;
     }
+
+    // scan the imports of all input files in one batch, the dependency walk below then only looks them up
+    std::vector<ThorScriptImportScanner::Result> scanResults;
+    database->scanImports(inputFiles, scanThreads, scanResults);
+    for(std::size_t i = 0; i != inputFiles.size(); ++i)
+    {
+        scannedImports[inputFiles[i]] = scanResults[i];
+    }
+
     FileGraphType fileGraph;
     foreach(i, inputFiles)
     {
         addFileDependency(*i, packagesInAsts, fileGraph, logger);
     }
 
-    // analyze source file tangles (strong connected components)
-    analyzeTangle(buildPath, fileGraph);
+    // the tangles only have to be analyzed again if the file graph changed
+    ThorScriptDepDatabase::FileEdges edges;
+    for(auto vp = boost::vertices(fileGraph); vp.first != vp.second; ++vp.first)
+    {
+        std::set<std::string>& targets = edges[fileGraph[*vp.first].name];
+        for(auto ep = boost::out_edges(*vp.first, fileGraph); ep.first != ep.second; ++ep.first)
+        {
+            targets.insert(fileGraph[boost::target(*ep.first, fileGraph)].name);
+        }
+    }
+
+    if(edges != database->edges || !boost::filesystem::exists(buildPath / "ts.dep"))
+    {
+        // analyze source file tangles (strong connected components)
+        // keep the recorded edges on failure, so the next run analyzes the tangles again
+        if(!analyzeTangle(buildPath, fileGraph))
+        {
+            LOG4CXX_ERROR(logger, "failed to analyze source file tangles");
+            return false;
+        }
+        database->edges.swap(edges);
+    }
+
+    if(!database->save())
+    {
+        LOG4CXX_WARN(logger, "failed to save dependency database `" << (buildPath / "ts.depdb").string() << "`");
+    }
 
     return true;
 }
@@ -0,0 +1,272 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/stage/dep/ThorScriptImportScanner.h"
+#include <boost/regex/pending/unicode_iterator.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+namespace zillians { namespace language { namespace stage {
+
+namespace {
+
+/**
+ * Byte reader with arbitrary look-ahead, which pulls the file in chunk by chunk on demand
+ */
+class Reader
+{
+public:
+    static const std::size_t chunk_size = 4096;
+
+    explicit Reader(std::FILE* file) : file(file), position(0)
+    { }
+
+    Reader(const char* first, const char* last) : file(NULL), buffer(first, last), position(0)
+    { }
+
+    /// the byte at the given distance ahead, or -1 past the end of the input
+    int peek(std::size_t ahead = 0)
+    {
+        while(position + ahead >= buffer.size())
+        {
+            if(!fill())
+                return -1;
+        }
+        return static_cast<unsigned char>(buffer[position + ahead]);
+    }
+
+    void advance(std::size_t n = 1)
+    {
+        position += n;
+    }
+
+private:
+    bool fill()
+    {
+        if(!file)
+            return false;
+
+        // only the unconsumed bytes are kept, so the buffer never holds more than a couple of chunks
+        buffer.erase(0, position);
+        position = 0;
+
+        char chunk[chunk_size];
+        std::size_t n = std::fread(chunk, 1, chunk_size, file);
+        if(n == 0)
+            return false;
+
+        buffer.append(chunk, n);
+        return true;
+    }
+
+private:
+    std::FILE* file;
+    std::string buffer;
+    std::size_t position;
+};
+
+static bool isIdentifierByte(int c)
+{
+    // bytes of non-ASCII characters are taken as part of an identifier, just like unicode letters are
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c >= 0x80;
+}
+
+/// skip whitespace and comments, fails on an unterminated block comment
+static bool skipBlank(Reader& reader)
+{
+    while(true)
+    {
+        int c = reader.peek();
+        if(c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v')
+        {
+            reader.advance();
+        }
+        else if(c == '/' && reader.peek(1) == '/')
+        {
+            reader.advance(2);
+            while((c = reader.peek()) != -1 && c != '\n')
+                reader.advance();
+        }
+        else if(c == '/' && reader.peek(1) == '*')
+        {
+            reader.advance(2);
+            while(!(reader.peek() == '*' && reader.peek(1) == '/'))
+            {
+                if(reader.peek() == -1)
+                    return false;
+                reader.advance();
+            }
+            reader.advance(2);
+        }
+        else
+        {
+            return true;
+        }
+    }
+}
+
+static void readIdentifier(Reader& reader, std::string& identifier)
+{
+    for(int c = reader.peek(); isIdentifierByte(c); c = reader.peek())
+    {
+        identifier.push_back(static_cast<char>(c));
+        reader.advance();
+    }
+}
+
+/// read "a.b.c" (blanks are allowed around the dots)
+static bool readNestedIdentifier(Reader& reader, std::string& name)
+{
+    while(true)
+    {
+        std::string::size_type length = name.size();
+        readIdentifier(reader, name);
+        if(name.size() == length)
+            return false;
+
+        if(!skipBlank(reader))
+            return false;
+
+        if(reader.peek() != '.')
+            return true;
+
+        reader.advance();
+        name.push_back('.');
+
+        if(!skipBlank(reader))
+            return false;
+    }
+}
+
+static std::wstring decode(const std::string& utf8)
+{
+    typedef boost::u8_to_u32_iterator<std::string::const_iterator> iterator;
+    return std::wstring(iterator(utf8.begin(), utf8.begin(), utf8.end()), iterator(utf8.end(), utf8.begin(), utf8.end()));
+}
+
+/**
+ * Accepts what the parser accepts before the first declaration:
+ *
+ *   import a.b.c;
+ *   import c = a.b.c;
+ *   import . = a.b.c;
+ */
+static bool scan(Reader& reader, std::vector<std::wstring>& packages)
+{
+    if(reader.peek() == 0xEF && reader.peek(1) == 0xBB && reader.peek(2) == 0xBF)
+        reader.advance(3);
+
+    while(true)
+    {
+        if(!skipBlank(reader))
+            return false;
+
+        std::string keyword;
+        readIdentifier(reader, keyword);
+        if(keyword != "import")
+            return true; // the first declaration (or the end of file), no more imports
+
+        if(!skipBlank(reader))
+            return false;
+
+        std::string name;
+        if(reader.peek() == '.')
+        {
+            reader.advance();
+            if(!skipBlank(reader) || reader.peek() != '=')
+                return false;
+        }
+        else
+        {
+            if(!readNestedIdentifier(reader, name))
+                return false;
+
+            if(reader.peek() == '=' && name.find('.') != std::string::npos)
+                return false;
+        }
+
+        // the alias is of no interest, only the imported package is
+        if(reader.peek() == '=')
+        {
+            reader.advance();
+            name.clear();
+
+            if(!skipBlank(reader) || !readNestedIdentifier(reader, name))
+                return false;
+        }
+
+        if(reader.peek() != ';')
+            return false;
+        reader.advance();
+
+        try
+        {
+            packages.push_back(decode(name));
+        }
+        catch(const std::out_of_range&)
+        {
+            return false; // invalid UTF-8 sequence
+        }
+    }
+}
+
+}
+
+bool ThorScriptImportScanner::scanFile(const std::string& filename, std::vector<std::wstring>& packages)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if(!file)
+        return false;
+
+    Reader reader(file);
+    bool succeeded = scan(reader, packages);
+
+    std::fclose(file);
+    return succeeded;
+}
+
+bool ThorScriptImportScanner::scanBuffer(const char* first, const char* last, std::vector<std::wstring>& packages)
+{
+    Reader reader(first, last);
+    return scan(reader, packages);
+}
+
+void ThorScriptImportScanner::scanFiles(const std::vector<std::string>& filenames, uint32 threads, std::vector<Result>& results)
+{
+    results.assign(filenames.size(), Result());
+
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+        for(std::size_t i = next++; i < filenames.size(); i = next++)
+            results[i].succeeded = scanFile(filenames[i], results[i].packages);
+    };
+
+    std::size_t thread_count = std::min<std::size_t>(std::max<uint32>(threads, 1), filenames.size());
+    std::vector<std::thread> workers;
+    for(std::size_t i = 1; i < thread_count; ++i)
+        workers.push_back(std::thread(worker));
+    worker();
+    for(std::size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+}
+
+} } }
@@ -220,6 +220,17 @@ bool ThorScriptDriver::setProjectPathAndBuildPath(std::vector<std::string>& argv
         }
     }
 
+    opt = "--prelude=";
+    foreach(i, argv)
+    {
+        if(i->find(opt) == 0)
+        {
+            preludePath = boost::filesystem::absolute(i->substr(opt.size()), originalPath).string();
+            argv.erase(i);
+            break;
+        }
+    }
+
     opt = "--dump-graphviz-dir=";
     foreach(i, argv)
     {
@@ -618,6 +629,10 @@ bool ThorScriptDriver::make(const ThorScriptDriver::BUILD_TYPE type)
     {
         cmd += " --prepand-package=" + prepandPackage;
     }
+    if(preludePath != "")
+    {
+        cmd += " --prelude=" + preludePath;
+    }
     if(dumpGraphvizDir != "")
     {
         cmd += " --dump-graphviz-dir=" + dumpGraphvizDir;
@@ -0,0 +1,147 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/stage/make/ThorScriptMakeScheduler.h"
+#include "utility/Foreach.h"
+#include <boost/graph/topological_sort.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace zillians { namespace language { namespace stage {
+
+ThorScriptMakeScheduler::ThorScriptMakeScheduler(const TangleGraphType& graph, const std::vector<double>& costs) : graph(graph), priorities(boost::num_vertices(graph), 0.0), states(boost::num_vertices(graph), JobState::WAITING)
+{
+    // dependencies come before their dependents, so walking it backwards every dependent is done first
+    std::vector<Vertex> order;
+    boost::topological_sort(graph, std::back_inserter(order));
+
+    for(auto i = order.rbegin(); i != order.rend(); ++i)
+    {
+        double longest = 0.0;
+        boost::graph_traits<TangleGraphType>::in_edge_iterator ei, ei_end;
+        for(boost::tie(ei, ei_end) = boost::in_edges(*i, graph); ei != ei_end; ++ei)
+        {
+            longest = std::max(longest, priorities[boost::source(*ei, graph)]);
+        }
+        priorities[*i] = costs[*i] + longest;
+    }
+}
+
+bool ThorScriptMakeScheduler::run(std::size_t threads, const std::function<int(Vertex)>& job)
+{
+    std::size_t count = boost::num_vertices(graph);
+    std::fill(states.begin(), states.end(), JobState::WAITING);
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::priority_queue<std::pair<double, Vertex>> ready;
+    std::vector<std::size_t> remaining(count);
+    std::size_t running = 0;
+    bool failed = false;
+
+    for(Vertex v = 0; v < count; ++v)
+    {
+        remaining[v] = boost::out_degree(v, graph);
+        if(remaining[v] == 0)
+        {
+            ready.push(std::make_pair(priorities[v], v));
+        }
+    }
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true)
+        {
+            wakeup.wait(lock, [&]() { return failed || !ready.empty() || running == 0; });
+            if(failed || ready.empty())
+            {
+                break;
+            }
+
+            Vertex v = ready.top().second;
+            ready.pop();
+            states[v] = JobState::RUNNING;
+            ++running;
+
+            lock.unlock();
+            int result = -1;
+            try
+            {
+                result = job(v);
+            }
+            catch(...)
+            {
+                // counted as a failure, whatever was thrown; the other threads must not wait for it forever
+            }
+            lock.lock();
+
+            --running;
+            if(result == 0)
+            {
+                states[v] = JobState::SUCCEEDED;
+
+                boost::graph_traits<TangleGraphType>::in_edge_iterator ei, ei_end;
+                for(boost::tie(ei, ei_end) = boost::in_edges(v, graph); ei != ei_end; ++ei)
+                {
+                    Vertex dependent = boost::source(*ei, graph);
+                    if(--remaining[dependent] == 0)
+                    {
+                        ready.push(std::make_pair(priorities[dependent], dependent));
+                    }
+                }
+            }
+            else
+            {
+                states[v] = JobState::FAILED;
+                failed = true;
+            }
+            wakeup.notify_all();
+        }
+    };
+
+    std::size_t thread_count = std::max<std::size_t>(std::min(threads, count), 1);
+    std::vector<std::thread> workers;
+    for(std::size_t i = 1; i < thread_count; ++i)
+    {
+        workers.push_back(std::thread(worker));
+    }
+    worker();
+    foreach(i, workers)
+    {
+        i->join();
+    }
+
+    bool succeeded = true;
+    foreach(i, states)
+    {
+        if(*i == JobState::WAITING)
+        {
+            *i = JobState::CANCELLED;
+        }
+        succeeded = succeeded && (*i == JobState::SUCCEEDED);
+    }
+    return succeeded;
+}
+
+} } }
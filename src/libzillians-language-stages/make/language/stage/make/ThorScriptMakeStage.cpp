@@ -22,12 +22,15 @@
 #include "core/Prerequisite.h"
 #include "language/stage/make/ThorScriptMakeStage.h"
 #include "language/stage/dep/ThorScriptSourceTangleGraph.h"
-#include "threading/JoinFunctionModule.h"
+#include "language/stage/make/ThorScriptMakeScheduler.h"
+#include "language/CompilationSession.h"
+#include "language/ThorScriptCompiler.h"
 #include "utility/UnicodeUtil.h"
 #include "utility/Filesystem.h"
 #include "utility/sha1.h"
 
 #include <boost/any.hpp>
+#include <boost/algorithm/string/join.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/adj_list_serialize.hpp>
@@ -36,6 +39,12 @@
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/serialization/set.hpp>
 #include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <llvm/Support/Threading.h>
 
 namespace zillians { namespace language { namespace stage {
 
@@ -43,22 +52,6 @@ namespace zillians { namespace language { namespace stage {
 // static functions
 //////////////////////////////////////////////////////////////////////////////
 
-typedef std::set<boost::graph_traits<TangleGraphType>::vertex_descriptor> VertexSet;
-
-static VertexSet findFirstBuildTargets(const TangleGraphType& g)
-{
-    VertexSet result;
-    for(auto vi = boost::vertices(g); vi.first != vi.second; ++vi.first)
-    {
-        //boost::graph_traits<TangleGraphType>::vertex_descriptor vd = *vi.first;
-        if(boost::out_degree(*vi.first, g) == 0)
-        {
-            result.insert(*vi.first);
-        }
-    }
-    return result;
-}
-
 static std::string tangleFilesConcate(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g)
 {
     std::string result;
@@ -101,28 +94,97 @@ bool isImportBundleTangle(TangleGraphType& g, boost::graph_traits<TangleGraphTyp
     boost::filesystem::path p(filename);
     return p.extension() == ".ast";
 }
+
+/**
+ * Identify a file too big to be hashed on every build (ts-compile itself, the prelude and bundles)
+ */
+static std::string fileStamp(const boost::filesystem::path& p)
+{
+    boost::system::error_code error;
+    std::time_t mtime = boost::filesystem::last_write_time(p, error);
+    uint64 size = error ? 0 : boost::filesystem::file_size(p, error);
+    if(error)
+    {
+        return "-";
+    }
+
+    std::ostringstream stamp;
+    stamp << mtime << ":" << size;
+    return stamp.str();
+}
+
+static std::string readFingerprint(const boost::filesystem::path& p)
+{
+    std::string fingerprint;
+    std::ifstream fin(p.string().c_str());
+    fin >> fingerprint;
+    return fingerprint;
+}
+
+/**
+ * Times of the last successful compile of each tangle, by tangle file name
+ */
+static std::map<std::string, double> loadBuildTimes(const boost::filesystem::path& p)
+{
+    std::map<std::string, double> times;
+    std::ifstream fin(p.string().c_str());
+    double seconds = 0.0;
+    std::string name;
+    while(fin >> seconds && std::getline(fin >> std::ws, name))
+    {
+        times[name] = seconds;
+    }
+    return times;
+}
+
+static void saveBuildTimes(const boost::filesystem::path& p, const std::map<std::string, double>& times)
+{
+    boost::filesystem::path temporary = p.string() + ".tmp";
+    {
+        std::ofstream fout(temporary.string().c_str());
+        foreach(i, times)
+        {
+            fout << i->second << " " << i->first << "\n";
+        }
+    }
+
+    boost::system::error_code error;
+    boost::filesystem::rename(temporary, p, error);
+}
+
+static std::string joinCompileArgs(const std::vector<std::string>& args)
+{
+    std::string cmd = args.front();
+    for(std::size_t i = 1; i < args.size(); ++i)
+    {
+        cmd += " '" + args[i] + "'";
+    }
+    return cmd;
+}
 //////////////////////////////////////////////////////////////////////////////
 // private member function
 //////////////////////////////////////////////////////////////////////////////
 
-std::string ThorScriptMakeStage::genCompileCmd(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g)
+std::vector<std::string> ThorScriptMakeStage::genCompileArgs(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g)
 {
-    std::string cmd = (executablePath / "ts-compile").string();
-
-    // TODO pass the buildType to ts-compile
-    if(buildType == BUILD_TYPE::DEBUG)
-        cmd += " --debug ";
+    std::vector<std::string> args;
 
     // source files
     std::set<std::string>& sourceFiles = g[v];
     if(allSourceAreAst(sourceFiles))
     {
-        return "";
+        return args;
     }
 
+    args.push_back((executablePath / "ts-compile").string());
+
+    // TODO pass the buildType to ts-compile
+    if(buildType == BUILD_TYPE::DEBUG)
+        args.push_back("--debug");
+
     foreach(i, sourceFiles)
     {
-        cmd += " '" + *i + "'";
+        args.push_back(*i);
     }
 
     // ast files
@@ -140,34 +202,157 @@ std::string ThorScriptMakeStage::genCompileCmd(boost::graph_traits<TangleGraphTy
             const std::string& astfile = tangleFileName(target, g) + ".ast";
             loadAstPath = buildPath / astfile;
         }
-        cmd += " '--load-ast=" + loadAstPath.string() + "'";
+        args.push_back("--load-ast=" + loadAstPath.string());
+    }
+
+    // the precompiled system API (see the ts-prelude target), only when asked for
+    if(!preludePath.empty())
+    {
+        args.push_back("--prelude=" + preludePath.string());
     }
 
     // output files
     std::string outputFileName = tangleFileName(v, g);
     boost::filesystem::path astPath = buildPath / (outputFileName + ".ast");
     boost::filesystem::path llvmPath = buildPath / (outputFileName + ".bc");
-    cmd += " '--emit-ast=" + astPath.string() + "'";
-    cmd += " '--emit-llvm=" + llvmPath.string() + "'";
+    args.push_back("--emit-ast=" + astPath.string());
+    args.push_back("--emit-llvm=" + llvmPath.string());
     if(dumpGraphviz)
     {
-        cmd += " '--dump-graphviz'";
+        args.push_back("--dump-graphviz");
         boost::filesystem::path graphvizPath = buildPath / "graphviz" / outputFileName;
-        cmd += " '--dump-graphviz-dir=" + graphvizPath.string() + "'";
+        args.push_back("--dump-graphviz-dir=" + graphvizPath.string());
     }
     if(!prepandPackage.empty())
     {
-        cmd += " '--prepand-package=" + prepandPackage + "'";
+        args.push_back("--prepand-package=" + prepandPackage);
     }
 
-    return cmd;
+    // all compile jobs share one parse cache, so only changed sources are parsed again
+    args.push_back("--parse-cache-dir=" + (buildPath / "parse-cache").string());
+
+    return args;
+}
+
+std::string ThorScriptMakeStage::genFingerprint(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g, const std::string& cmd)
+{
+    // the command has all the flags and the paths of the compiler, the inputs and the outputs
+    std::string material = cmd;
+    material += "\n" + fileStamp(executablePath / "ts-compile");
+    if(!preludePath.empty())
+    {
+        material += "\n" + fileStamp(preludePath);
+    }
+    if(inProcess)
+    {
+        // the compiler stages linked into ts-make do the work instead of ts-compile
+        material += "\n" + fileStamp(Filesystem::current_executable_path());
+    }
+
+    foreach(i, g[v])
+    {
+        material += "\n" + *i + " " + sources->hashOf(*i);
+    }
+
+    // only the interface of a dependency matters, changing its function bodies doesn't affect this tangle
+    boost::graph_traits<TangleGraphType>::out_edge_iterator ei, ei_end;
+    for(boost::tie(ei, ei_end) = boost::out_edges(v, g); ei != ei_end; ++ei)
+    {
+        boost::graph_traits<TangleGraphType>::vertex_descriptor target = boost::target(*ei, g);
+        if(isImportBundleTangle(g, target))
+        {
+            material += "\n" + *g[target].begin() + " " + fileStamp(*g[target].begin());
+        }
+        else
+        {
+            boost::filesystem::path astPath = buildPath / (tangleFileName(target, g) + ".ast");
+            std::string dependencyInterface = readFingerprint(astPath.string() + ".interface");
+            material += "\n" + astPath.string() + " " + (dependencyInterface.empty() ? fileStamp(astPath) : dependencyInterface);
+        }
+    }
+
+    return sha1::sha1(material);
+}
+
+int ThorScriptMakeStage::compile(boost::graph_traits<TangleGraphType>::vertex_descriptor v, TangleGraphType& g, const std::vector<std::string>& args)
+{
+    // nothing to compile for imported bundles
+    if(args.empty())
+    {
+        return 0;
+    }
+    std::string cmd = joinCompileArgs(args);
+
+    // dependencies have been compiled by now, so their interface fingerprints are current
+    std::string outputFileName = tangleFileName(v, g);
+    boost::filesystem::path fingerprintPath = buildPath / (outputFileName + ".fingerprint");
+    std::string fingerprint = genFingerprint(v, g, cmd);
+
+    if(readFingerprint(fingerprintPath) == fingerprint &&
+       boost::filesystem::exists(buildPath / (outputFileName + ".ast")) &&
+       boost::filesystem::exists(buildPath / (outputFileName + ".bc")))
+    {
+        if(dumpCompileCommand)
+        {
+            std::cout << "[ts-make] up to date: `" << outputFileName << "`" << std::endl;
+        }
+        return 0;
+    }
+
+    // a failed or interrupted compile must not leave the previous fingerprint behind
+    boost::system::error_code error;
+    boost::filesystem::remove(fingerprintPath, error);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int result = inProcess ? compileInProcess(args) : system(cmd.c_str());
+    if(result == 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(buildTimesMutex);
+            buildTimes[outputFileName] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::ofstream fout(fingerprintPath.string().c_str());
+        fout << fingerprint << std::endl;
+    }
+    return result;
+}
+
+int ThorScriptMakeStage::compileInProcess(const std::vector<std::string>& args)
+{
+    std::vector<const char*> argv;
+    foreach(i, args)
+    {
+        argv.push_back(i->c_str());
+    }
+
+    // tangles are already compiled side by side, and dependencies are decoded from one cache for all jobs
+    argv.push_back("--parser-threads=1");
+    argv.push_back("--shared-ast-cache");
+
+    // the job's arena and its parser, generator and configuration contexts live and die with it
+    CompilationSession session;
+
+    int result = -1;
+    try
+    {
+        ThorScriptCompiler compiler;
+        compiler.setSession(&session);
+        result = compiler.main(argv.size(), &argv[0]);
+    }
+    catch(const std::exception& e)
+    {
+        LOG4CXX_ERROR(logger, "Compile job `" << joinCompileArgs(args) << "` failed: " << e.what());
+    }
+
+    return result;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 // class member function
 //////////////////////////////////////////////////////////////////////////////
 
-ThorScriptMakeStage::ThorScriptMakeStage() : dumpCompileCommand(false), projectPath("./"), buildPath("./build/"), logger(log4cxx::Logger::getLogger("ts-make")), dumpGraphviz(false)
+ThorScriptMakeStage::ThorScriptMakeStage() : dumpCompileCommand(false), inProcess(false), jobs(1), projectPath("./"), buildPath("./build/"), logger(log4cxx::Logger::getLogger("ts-make")), buildType(BUILD_TYPE::RELEASE), dumpGraphviz(false)
 {
 	boost::filesystem::path make_path = Filesystem::current_executable_path();
 	executablePath = make_path.parent_path();
@@ -195,6 +380,9 @@ std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_descriptio
         ("build-path", po::value<std::string>())
         ("debug", "debug build")
         ("release", "release build")
+        ("in-process", "compile tangles on worker threads of ts-make instead of spawning ts-compile")
+        ("jobs,j", po::value<unsigned>(), "number of tangles compiled at once (defaults to the number of cores)")
+        ("prelude", po::value<std::string>(), "precompiled system API image loaded by every compile job")
     ;
 
 	foreach(i, option_desc_public->options()) option_desc_private->add(*i);
@@ -235,6 +423,27 @@ bool ThorScriptMakeStage::parseOptions(po::variables_map& vm)
     {
         buildType = BUILD_TYPE::RELEASE;
     }
+    if(vm.count("in-process"))
+    {
+        inProcess = true;
+    }
+    if(vm.count("jobs"))
+    {
+        jobs = std::max<unsigned>(vm["jobs"].as<unsigned>(), 1);
+    }
+    else
+    {
+        jobs = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    }
+    if(vm.count("prelude"))
+    {
+        preludePath = boost::filesystem::path(vm["prelude"].as<std::string>());
+        if(!boost::filesystem::exists(preludePath))
+        {
+            LOG4CXX_ERROR(logger, "Prelude image `" << preludePath.string() << "' does not exist");
+            return false;
+        }
+    }
     if(vm.count("dump-graphviz"))
     {
         dumpGraphviz = true;
@@ -246,15 +455,6 @@ bool ThorScriptMakeStage::parseOptions(po::variables_map& vm)
     return true;
 }
 
-struct Shell
-{
-    Shell(const std::string& cmd_) : cmd(cmd_) {}
-    int operator()(int) {
-        return system(cmd.c_str());
-    }
-    std::string cmd;
-};
-
 bool ThorScriptMakeStage::execute(bool& continue_execution)
 {
 	UNUSED_ARGUMENT(continue_execution);
@@ -287,46 +487,89 @@ bool ThorScriptMakeStage::execute(bool& continue_execution)
     ia >> tangleRestored;
     fin.close();
 
-    // create braodcast node
-    tbb::flow::graph g;
-    tbb::flow::broadcast_node<int> start;
+    // ts-dep has just hashed the sources, only files changed since are read again
+    sources.reset(new ThorScriptDepDatabase(buildPath / "ts.depdb"));
+    sources->load();
 
-    // create internal node
-    std::vector<zillians::JoinFunctionModule> moduleVec;
-    for(auto vi = boost::vertices(tangleRestored); vi.first != vi.second; ++vi.first)
+    if(inProcess)
     {
-        std::string cmd = genCompileCmd(*vi.first, tangleRestored);
-        if(dumpCompileCommand)
+        // jobs share the process from now on, each with its own LLVM context
+        llvm::llvm_start_multithreaded();
+    }
+
+    // the longest chain of compile work starts first, estimated from how long each tangle took last time
+    boost::filesystem::path buildTimesPath = buildPath / "ts.times";
+    buildTimes = loadBuildTimes(buildTimesPath);
+
+    std::size_t count = boost::num_vertices(tangleRestored);
+    std::vector<std::vector<std::string>> compileArgs(count);
+    std::vector<std::string> names(count);
+    double knownSeconds = 0.0;
+    std::size_t knownFiles = 0;
+    for(std::size_t v = 0; v < count; ++v)
+    {
+        compileArgs[v] = genCompileArgs(v, tangleRestored);
+        names[v] = tangleFileName(v, tangleRestored);
+        if(dumpCompileCommand && !compileArgs[v].empty())
         {
-            std::cout << "[ts-make] call shell: `" << cmd << "`" <<  std::endl ;
+            std::cout << "[ts-make] " << (inProcess ? "compile in process" : "call shell") << ": `" << joinCompileArgs(compileArgs[v]) << "`" <<  std::endl ;
         }
-        int inputNum = boost::out_degree(*vi.first, tangleRestored);
-        if(inputNum == 0)
+
+        auto time = buildTimes.find(names[v]);
+        if(time != buildTimes.end())
         {
-            inputNum = 1;
+            knownSeconds += time->second;
+            knownFiles += tangleRestored[v].size();
         }
-        zillians::JoinFunctionModule m(g, Shell(cmd), inputNum);
-        moduleVec.push_back(m);
     }
 
-    // connect internal node
-    boost::graph_traits<TangleGraphType>::edge_iterator ei, ei_end;
-    for(boost::tie(ei, ei_end) = boost::edges(tangleRestored); ei != ei_end; ++ei)
+    // tangles never compiled before are estimated by their number of files
+    double secondsPerFile = (knownFiles > 0) ? knownSeconds / knownFiles : 1.0;
+    std::vector<double> costs(count, 0.0);
+    for(std::size_t v = 0; v < count; ++v)
     {
-        int sourceNode = boost::source(*ei, tangleRestored);
-        int targetNode = boost::target(*ei, tangleRestored);
-        tbb::flow::make_edge(moduleVec[targetNode].getOutputPort(), moduleVec[sourceNode].getNextInputPort());
+        if(compileArgs[v].empty())
+        {
+            continue;
+        }
+        auto time = buildTimes.find(names[v]);
+        costs[v] = (time != buildTimes.end()) ? time->second : secondsPerFile * tangleRestored[v].size();
     }
 
-    // connect breadcast node and beginning nodes
-    VertexSet beginNodes = findFirstBuildTargets(tangleRestored);
-    foreach(v, beginNodes)
+    ThorScriptMakeScheduler scheduler(tangleRestored, costs);
+    bool succeeded = scheduler.run(jobs, [&](ThorScriptMakeScheduler::Vertex v) {
+        int result = compile(v, tangleRestored, compileArgs[v]);
+        if(result != 0)
+        {
+            LOG4CXX_ERROR(logger, "Failed to compile `" << boost::algorithm::join(tangleRestored[v], " ") << "`");
+        }
+        return result;
+    });
+
+    // times of tangles which are gone are dropped
+    std::map<std::string, double> currentBuildTimes;
+    for(std::size_t v = 0; v < count; ++v)
     {
-        tbb::flow::make_edge(start, moduleVec[*v].getNextInputPort());
+        if(buildTimes.count(names[v]))
+        {
+            currentBuildTimes[names[v]] = buildTimes[names[v]];
+        }
     }
+    saveBuildTimes(buildTimesPath, currentBuildTimes);
 
-    start.try_put(1);
-    g.wait_for_all();
+    if(!succeeded)
+    {
+        std::size_t cancelled = 0;
+        for(std::size_t v = 0; v < count; ++v)
+        {
+            if(scheduler.state(v) == ThorScriptMakeScheduler::JobState::CANCELLED)
+            {
+                ++cancelled;
+            }
+        }
+        LOG4CXX_ERROR(logger, "Build stopped, " << cancelled << " tangle(s) not compiled");
+        return false;
+    }
 
     return true;
 }
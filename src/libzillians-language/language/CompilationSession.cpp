@@ -0,0 +1,66 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/CompilationSession.h"
+#include "language/logging/LoggerWrapper.h"
+#include <mutex>
+
+namespace zillians { namespace language {
+
+namespace {
+
+CompilationSession*& scopedSession()
+{
+	static __thread CompilationSession* current = NULL;
+	return current;
+}
+
+}
+
+CompilationSession::Scope::Scope(CompilationSession& session) : previous(scopedSession()), contexts_scope(session.hub), sources_scope(session.source_table), arena_scope(session.gc)
+{
+	scopedSession() = &session;
+}
+
+CompilationSession::Scope::~Scope()
+{
+	scopedSession() = previous;
+}
+
+CompilationSession::CompilationSession()
+{
+	// the logger is shared by all sessions, sessions created at once on several threads must not all create it
+	static std::once_flag logger_created;
+	std::call_once(logger_created, [] { LoggerWrapper::instance(); });
+}
+
+CompilationSession::~CompilationSession()
+{
+	// destroy the nodes first, within the session as they were created; the contexts go after
+	// with the hub (the generator context takes the LLVM modules and context with it)
+	Scope scope(*this);
+	gc.cleanup();
+}
+
+CompilationSession* CompilationSession::current()
+{
+	return scopedSession();
+}
+
+} }
@@ -23,7 +23,7 @@ namespace zillians { namespace language {
 
 bool hasConfigurationContext()
 {
-	if(GlobalContext::instance()->get<ConfigurationContext>())
+	if(GlobalContext::current().get<ConfigurationContext>())
 		return true;
 	else
 		return false;
@@ -31,12 +31,12 @@ bool hasConfigurationContext()
 
 ConfigurationContext& getConfigurationContext()
 {
-	return *GlobalContext::instance()->get<ConfigurationContext>();
+	return *GlobalContext::current().get<ConfigurationContext>();
 }
 
 void setConfigurationContext(ConfigurationContext* context)
 {
-	GlobalContext::instance()->set<ConfigurationContext>(context);
+	GlobalContext::current().set<ConfigurationContext>(context);
 }
 
 } }
@@ -18,12 +18,20 @@
  */
 
 #include "language/context/GeneratorContext.h"
+#include "utility/Foreach.h"
 
 namespace zillians { namespace language {
 
+GeneratorContext::~GeneratorContext()
+{
+	foreach(i, modules)
+		delete *i;
+	delete context;
+}
+
 bool hasGeneratorContext()
 {
-	if(GlobalContext::instance()->get<GeneratorContext>())
+	if(GlobalContext::current().get<GeneratorContext>())
 		return true;
 	else
 		return false;
@@ -31,12 +39,12 @@ bool hasGeneratorContext()
 
 GeneratorContext& getGeneratorContext()
 {
-	return *GlobalContext::instance()->get<GeneratorContext>();
+	return *GlobalContext::current().get<GeneratorContext>();
 }
 
 void setGeneratorContext(GeneratorContext* context)
 {
-	GlobalContext::instance()->set<GeneratorContext>(context);
+	GlobalContext::current().set<GeneratorContext>(context);
 }
 
 } }
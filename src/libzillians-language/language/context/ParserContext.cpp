@@ -21,19 +21,42 @@
 
 namespace zillians { namespace language {
 
+namespace {
+
+ParserContext*& scopedParserContext()
+{
+	static __thread ParserContext* current = NULL;
+	return current;
+}
+
+}
+
+ParserContext::Scope::Scope(ParserContext& context) : previous(scopedParserContext())
+{
+	scopedParserContext() = &context;
+}
+
+ParserContext::Scope::~Scope()
+{
+	scopedParserContext() = previous;
+}
+
 bool hasParserContext()
 {
-	return (!!GlobalContext::instance()->get<ParserContext>());
+	return scopedParserContext() || (!!GlobalContext::current().get<ParserContext>());
 }
 
 ParserContext& getParserContext()
 {
-	return *GlobalContext::instance()->get<ParserContext>();
+	if(scopedParserContext())
+		return *scopedParserContext();
+
+	return *GlobalContext::current().get<ParserContext>();
 }
 
 void setParserContext(ParserContext* context)
 {
-	GlobalContext::instance()->set<ParserContext>(context);
+	GlobalContext::current().set<ParserContext>(context);
 }
 
 } }
@@ -0,0 +1,38 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/stage/FusableStage.h"
+#include "language/tree/visitor/GenericDoubleVisitor.h"
+#include "language/context/ParserContext.h"
+
+namespace zillians { namespace language { namespace stage {
+
+bool FusableStage::execute(bool& continue_execution)
+{
+	tree::visitor::GenericDoubleVisitor* visitor = NULL;
+	if(!prepareTraversal(visitor))
+		return false;
+
+	if(visitor)
+		visitor->visit(*getParserContext().tangle);
+
+	return finishTraversal(continue_execution);
+}
+
+} } }
@@ -22,10 +22,11 @@
 #include "utility/Foreach.h"
 #include "language/tree/ASTNode.h"
 #include "language/context/ConfigurationContext.h"
+#include "language/CompilationSession.h"
 
 namespace zillians { namespace language { namespace stage {
 
-StageConductor::StageConductor(bool require_input) : mOptionDescGlobal()
+StageConductor::StageConductor(bool require_input) : mOptionDescGlobal(), mObserver(NULL), mSession(NULL)
 {
 	// make sure logger is initialized;
 	LoggerWrapper::instance();
@@ -54,6 +55,16 @@ void StageConductor::appendStage(shared_ptr<Stage> stage)
 	mStages.push_back(stage);
 }
 
+void StageConductor::setObserver(Observer* observer)
+{
+	mObserver = observer;
+}
+
+void StageConductor::setSession(CompilationSession* session)
+{
+	mSession = session;
+}
+
 void StageConductor::appendOptionsFromAllStages(po::options_description& options_desc_public, po::options_description& options_desc_private)
 {
 	foreach(i, mStages)
@@ -67,6 +78,28 @@ void StageConductor::appendOptionsFromAllStages(po::options_description& options
 }
 
 int StageConductor::main(int argc, const char** argv)
+{
+	// within a given session, everything the run creates is kept until the owner destroys the session
+	if(mSession)
+	{
+		CompilationSession::Scope scope(*mSession);
+		return run(argc, argv);
+	}
+
+	// otherwise all AST nodes created in this run live in the compilation arena, which is
+	// dropped in bulk at the end rather than destroyed node by node (the process exits right after)
+	tree::ASTNodeGC arena;
+	int result = 0;
+	{
+		tree::ASTNodeGC::Scope scope(arena);
+		result = run(argc, argv);
+	}
+	arena.release();
+
+	return result;
+}
+
+int StageConductor::run(int argc, const char** argv)
 {
 	// initialize the global configuration context
 	ConfigurationContext* config = new ConfigurationContext();
@@ -122,7 +155,15 @@ int StageConductor::main(int argc, const char** argv)
 		{
 			bool c = true;
 
-			if(!(*stage)->execute(c))
+			if(mObserver)
+				mObserver->beforeExecute(**stage);
+
+			bool succeeded = (*stage)->execute(c);
+
+			if(mObserver)
+				mObserver->afterExecute(**stage, succeeded);
+
+			if(!succeeded)
 			{
                 if(strcmp((*stage)->name(), "Resolution Stage") == 0 && vm.count("keep-going-on-resolution-fail")) continue;
 				//std::cerr << "execution failed at stage: " << (*stage)->name() << std::endl;
@@ -0,0 +1,190 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/stage/parser/ParseCache.h"
+#include "language/stage/parser/SourceLineTable.h"
+#include "language/stage/parser/context/SourceSpanContext.h"
+#include "language/stage/serialization/visitor/ASTSerializationStageVisitor.h"
+#include "language/stage/serialization/visitor/ASTDeserializationStageVisitor.h"
+#include "utility/Foreach.h"
+#include "utility/UnicodeUtil.h"
+#include "utility/sha1.h"
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/lexical_cast.hpp>
+#include <fstream>
+
+namespace zillians { namespace language { namespace stage {
+
+const uint32 ParseCache::format_version = 2;
+
+namespace {
+
+// the spans of the top-level declarations go along, so cached sources can be reparsed; like
+// SourceInfoContext, the line table goes instead of the file number (the archive tracks the
+// pointer, so it's written only once for both) and is registered again on load
+void saveSpans(boost::archive::text_oarchive& oa, tree::Package& package)
+{
+	foreach(i, package.objects)
+	{
+		SourceSpanContext* span = SourceSpanContext::get(*i);
+		const SourceLineTable* lines = span ? SourceTable::instance().get(span->file) : NULL;
+		if(!lines)
+			continue;
+
+		bool more = true;
+		tree::ASTNode* decl = *i;
+		uint64 begin = span->begin;
+		uint64 end = span->end;
+		oa << more;
+		oa << decl;
+		oa << begin;
+		oa << end;
+		oa << lines;
+	}
+
+	foreach(i, package.children)
+		saveSpans(oa, **i);
+}
+
+void loadSpans(boost::archive::text_iarchive& ia)
+{
+	for(;;)
+	{
+		bool more = false;
+		ia >> more;
+		if(!more)
+			break;
+
+		tree::ASTNode* decl = NULL;
+		uint64 begin = 0;
+		uint64 end = 0;
+		SourceLineTable* lines = NULL;
+		ia >> decl;
+		ia >> begin;
+		ia >> end;
+		ia >> lines;
+		if(decl && lines)
+			SourceSpanContext::set(decl, SourceSpanContext(begin, end, SourceTable::instance().adopt(lines)));
+	}
+}
+
+}
+
+ParseCache::ParseCache(const boost::filesystem::path& directory) : directory(directory)
+{ }
+
+std::string ParseCache::key(const SourceBuffer& buffer, const std::string& filename, const std::deque<std::wstring>& package) const
+{
+	std::string material = boost::lexical_cast<std::string>(format_version);
+	material.push_back('\0');
+	material += filename;
+	material.push_back('\0');
+	foreach(i, package)
+	{
+		material += ws_to_s(*i);
+		material.push_back('.');
+	}
+	material.push_back('\0');
+	material.append(buffer.data(), buffer.size());
+
+	return sha1::sha1(material);
+}
+
+bool ParseCache::load(const std::string& key, tree::Identifier*& package_id, tree::Source*& source) const
+{
+	std::ifstream ifs((directory / (key + ".ast")).string());
+	if(!ifs.good())
+		return false;
+
+	try
+	{
+		boost::archive::text_iarchive ia(ifs);
+		tree::ASTNode* loaded_package_id = NULL;
+		tree::ASTNode* loaded_source = NULL;
+		ia >> loaded_package_id;
+		ia >> loaded_source;
+
+		if(!tree::isa<tree::Identifier>(loaded_package_id) || !tree::isa<tree::Source>(loaded_source))
+			return false;
+
+		visitor::ASTDeserializationStageVisitor<boost::archive::text_iarchive> deserializer(ia);
+		deserializer.visit(*loaded_package_id);
+		deserializer.visit(*loaded_source);
+		loadSpans(ia);
+
+		package_id = tree::cast<tree::Identifier>(loaded_package_id);
+		source = tree::cast<tree::Source>(loaded_source);
+		return true;
+	}
+	catch(const std::exception&)
+	{
+		// a stale or broken entry is just a miss
+		return false;
+	}
+}
+
+bool ParseCache::store(const std::string& key, tree::Identifier* package_id, tree::Source* source) const
+{
+	boost::system::error_code error;
+	boost::filesystem::create_directories(directory, error);
+
+	boost::filesystem::path temporary = directory / boost::filesystem::unique_path(key + ".%%%%-%%%%-%%%%.tmp", error);
+	if(error)
+		return false;
+
+	try
+	{
+		std::ofstream ofs(temporary.string());
+		if(!ofs.good())
+			return false;
+
+		boost::archive::text_oarchive oa(ofs);
+		tree::ASTNode* saved_package_id = package_id;
+		tree::ASTNode* saved_source = source;
+		oa << saved_package_id;
+		oa << saved_source;
+
+		visitor::ASTSerializationStageVisitor<boost::archive::text_oarchive> serializer(oa);
+		serializer.visit(*saved_package_id);
+		serializer.visit(*saved_source);
+
+		bool more = false;
+		if(source->root)
+			saveSpans(oa, *source->root);
+		oa << more;
+	}
+	catch(const std::exception&)
+	{
+		// failing to fill the cache must not fail the compilation
+		boost::filesystem::remove(temporary, error);
+		return false;
+	}
+
+	// rename() replaces the entry atomically, whoever wins a race writes the very same content
+	boost::filesystem::rename(temporary, directory / (key + ".ast"), error);
+	if(error)
+	{
+		boost::filesystem::remove(temporary, error);
+		return false;
+	}
+	return true;
+}
+
+} } }
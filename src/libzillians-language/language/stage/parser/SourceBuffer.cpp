@@ -0,0 +1,138 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/stage/parser/SourceBuffer.h"
+#include <algorithm>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace zillians { namespace language { namespace stage {
+
+SourceBuffer::SourceBuffer() : opened(false), first(NULL), last(NULL), mapped_address(NULL), mapped_size(0)
+{ }
+
+SourceBuffer::~SourceBuffer()
+{
+	close();
+}
+
+bool SourceBuffer::open(const std::string& filename)
+{
+	close();
+
+#if !defined(_WIN32)
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat st;
+	if(::fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	if(st.st_size > 0)
+	{
+		void* address = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(address == MAP_FAILED)
+		{
+			::close(fd);
+			return false;
+		}
+		mapped_address = address;
+		mapped_size = st.st_size;
+	}
+	::close(fd); // the mapping stays valid after the descriptor is closed
+
+	first = static_cast<const char*>(mapped_address);
+	last = first + mapped_size;
+#else
+	std::ifstream in(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+	if(!in.good())
+		return false;
+
+	in.seekg(0, std::ios_base::end);
+	fallback.resize(static_cast<std::size_t>(in.tellg()));
+	in.seekg(0, std::ios_base::beg);
+	if(!fallback.empty())
+		in.read(&fallback[0], fallback.size());
+
+	first = fallback.data();
+	last = first + fallback.size();
+#endif
+
+	// ignore the BOM marking the beginning of a UTF-8 file in Windows
+	if(last - first >= 3 && first[0] == '\xef' && first[1] == '\xbb' && first[2] == '\xbf')
+		first += 3;
+
+	this->filename = filename;
+	opened = true;
+	return true;
+}
+
+void SourceBuffer::close()
+{
+#if !defined(_WIN32)
+	if(mapped_address)
+		::munmap(mapped_address, mapped_size);
+#endif
+	mapped_address = NULL;
+	mapped_size = 0;
+	fallback.clear();
+	line_table.reset();
+	filename.clear();
+
+	first = last = NULL;
+	opened = false;
+}
+
+shared_ptr<SourceLineTable> SourceBuffer::lineTable() const
+{
+	if(!line_table)
+		line_table.reset(new SourceLineTable(filename, first, last));
+	return line_table;
+}
+
+void SourceBuffer::locate(const char* position, uint32& line, uint32& column) const
+{
+	lineTable()->locate(std::min<std::size_t>(std::max(position, first) - first, size()), line, column);
+}
+
+std::wstring SourceBuffer::getLine(uint32 line) const
+{
+	const std::vector<uint32>& line_offsets = lineTable()->line_offsets;
+	if(line == 0 || line > line_offsets.size())
+		return std::wstring();
+
+	const char* b = first + line_offsets[line - 1];
+	const char* e = (line < line_offsets.size()) ? first + line_offsets[line] : last;
+	while(e != b && (e[-1] == '\n' || e[-1] == '\r'))
+		--e;
+
+	return std::wstring(iterator(b, b, e), iterator(e, b, e));
+}
+
+} } }
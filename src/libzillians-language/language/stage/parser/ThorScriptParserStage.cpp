@@ -18,17 +18,27 @@
  */
 
 #include "language/stage/parser/ThorScriptParserStage.h"
+#include "language/stage/parser/SourceBuffer.h"
+#include "language/stage/parser/ParseCache.h"
+#include "language/stage/parser/context/SourceSpanContext.h"
 #include "language/context/ParserContext.h"
 #include "language/grammar/ThorScript.h"
 #include "language/action/SemanticActions.h"
 #include "language/tree/visitor/PrettyPrintVisitor.h"
+#include "language/tree/ASTNodeHelper.h"
 #include "language/ThorScriptCompiler.h"
 #include "utility/Foreach.h"
 #include "utility/UnicodeUtil.h"
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cwchar>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
 namespace classic = boost::spirit::classic;
 namespace qi = boost::spirit::qi;
@@ -114,9 +124,29 @@ static boost::filesystem::path normalize_path(boost::filesystem::path p)
 		return resolve(boost::filesystem::absolute(p));
 }
 
+typedef SourceBuffer::iterator pos_iterator_type;
+typedef grammar::ThorScript<pos_iterator_type, action::ThorScriptTreeAction> parser_type;
+typedef grammar::ThorScript<pos_iterator_type, action::ThorScriptTreeAction, true> debug_parser_type;
+typedef grammar::detail::WhiteSpace<pos_iterator_type> skipper_type;
+
+// building the grammar takes about as long as parsing a small file, and it holds no parsing state,
+// so a single instance is shared by every file and parser thread
+// (rule debugging lives in a grammar of its own, built for --debug-parser only)
+static const parser_type& shared_parser()
+{
+	static const parser_type parser;
+	return parser;
+}
+
+static const skipper_type& shared_skipper()
+{
+	static const skipper_type skipper;
+	return skipper;
 }
 
-ThorScriptParserStage::ThorScriptParserStage() : debug_parser(false), debug_ast(false), debug_ast_with_loc(false), use_relative_path(false), dump_graphviz(false)
+}
+
+ThorScriptParserStage::ThorScriptParserStage() : parser_threads(1), debug_parser(false), debug_ast(false), debug_ast_with_loc(false), use_relative_path(false), dump_graphviz(false)
 { }
 
 ThorScriptParserStage::~ThorScriptParserStage()
@@ -133,7 +163,9 @@ std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_descriptio
 	shared_ptr<po::options_description> option_desc_private(new po::options_description());
 
 	option_desc_public->add_options()
-		("root-dir", po::value<std::string>(), "root source directory");
+		("root-dir", po::value<std::string>(), "root source directory")
+		("parser-threads", po::value<uint32>(), "number of threads parsing input files concurrently (defaults to the number of cores)")
+		("parse-cache-dir", po::value<std::string>(), "directory to cache parsed source files in");
 
 	foreach(i, option_desc_public->options()) option_desc_private->add(*i);
 
@@ -152,6 +184,16 @@ std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_descriptio
 
 bool ThorScriptParserStage::parseOptions(po::variables_map& vm)
 {
+	if(vm.count("parser-threads") == 0)
+		parser_threads = std::max<uint32>(std::thread::hardware_concurrency(), 1);
+	else
+		parser_threads = std::max<uint32>(vm["parser-threads"].as<uint32>(), 1);
+
+	if(vm.count("parse-cache-dir") > 0)
+		parse_cache.reset(new ParseCache(vm["parse-cache-dir"].as<std::string>()));
+	else
+		parse_cache.reset();
+
 	debug_parser = (vm.count("debug-parser") > 0);
 	debug_ast = (vm.count("debug-parser-ast") > 0);
 	debug_ast_with_loc = (vm.count("debug-parser-ast-with-loc") > 0);
@@ -189,6 +231,11 @@ bool ThorScriptParserStage::execute(bool& continue_execution)
 	if(!hasParserContext())
 		setParserContext(new ParserContext());
 
+    // enable correct locale so that we can print UCS4 characters (once, the stage may be executed again and again)
+    static std::once_flag locale_enabled;
+    std::call_once(locale_enabled, [] { enable_default_locale(std::wcout); });
+
+	std::vector<ParsedSource> parsed_sources;
 	foreach(i, inputs)
 	{
 		boost::filesystem::path p(*i);
@@ -197,10 +244,78 @@ bool ThorScriptParserStage::execute(bool& continue_execution)
 #else
 		if(strcmp(p.extension().c_str(), ".t") == 0)
 #endif
-			if(!parse(p))
-				return false;
+		{
+			parsed_sources.push_back(ParsedSource());
+			parsed_sources.back().path = p;
+		}
 	}
 
+	// parse all files concurrently, each one into its own arena and parser context; the files are
+	// numbered in the source table of the compilation
+	SourceTable& sources = SourceTable::instance();
+	std::atomic<std::size_t> next_source(0);
+	auto worker = [&]() {
+		SourceTable::Scope sources_scope(sources);
+		for(std::size_t i = next_source++; i < parsed_sources.size(); i = next_source++)
+		{
+			ParsedSource& parsed = parsed_sources[i];
+			parsed.arena.reset(new ASTNodeGC());
+
+			ASTNodeGC::Scope arena_scope(*parsed.arena);
+			ParserContext context(NULL);
+			ParserContext::Scope context_scope(context);
+
+			try
+			{
+				parsed.succeeded = parse(parsed);
+			}
+			catch(const std::exception& e)
+			{
+				parsed.diagnostics += s_to_ws(e.what()) + L"\n";
+				parsed.succeeded = false;
+			}
+			catch(...)
+			{
+				// anything escaping a std::thread would terminate the whole process
+				parsed.diagnostics += L"unknown exception while parsing " + parsed.path.wstring() + L"\n";
+				parsed.succeeded = false;
+			}
+		}
+	};
+
+	std::size_t thread_count = std::min<std::size_t>(debug_parser ? 1 : parser_threads, parsed_sources.size());
+	std::vector<std::thread> threads;
+	for(std::size_t i = 1; i < thread_count; ++i)
+		threads.push_back(std::thread(worker));
+	worker();
+	foreach(i, threads)
+		i->join();
+
+	// join the sources into the tangle in input order, which gives the very same tree (node ids
+	// included) as parsing the files one by one
+	foreach(i, parsed_sources)
+	{
+		if(!i->diagnostics.empty())
+			std::wcerr << i->diagnostics;
+
+		if(!i->succeeded)
+			return false;
+
+		ASTNodeGC::instance()->adopt(*i->arena, [](const ASTNode* node, uint32 offset) {
+			const_cast<ASTNode*>(node)->node_id += offset;
+		});
+
+		// map the created program by the nested identifier as its key
+		getParserContext().tangle->addSource(i->containing_package_id, i->source);
+		getParserContext().active_source = i->source;
+		getParserContext().active_package = i->active_package;
+	}
+
+    if(dump_graphviz)
+    {
+        boost::filesystem::path p(dump_graphviz_dir);
+        ASTNodeHelper::visualize(getParserContext().tangle, p / "post-parse.dot");
+    }
 
 	if(getParserContext().tangle && (debug_ast || debug_ast_with_loc))
 	{
@@ -211,8 +326,10 @@ bool ThorScriptParserStage::execute(bool& continue_execution)
 	return true;
 }
 
-bool ThorScriptParserStage::parse(const boost::filesystem::path& p)
+bool ThorScriptParserStage::parse(ParsedSource& parsed)
 {
+	const boost::filesystem::path& p = parsed.path;
+
 	std::deque<std::wstring> parent_sequence;
 	if (!enumerate_package(root_dir, normalize_path(p), parent_sequence))
 	{
@@ -230,6 +347,30 @@ bool ThorScriptParserStage::parse(const boost::filesystem::path& p)
         parent_sequence.insert(parent_sequence.end(), v.begin(), v.end());
     }
 
+	SourceBuffer buffer;
+	if(!buffer.open(p.string()))
+	{
+		LOG4CXX_ERROR(LoggerWrapper::ParserStage, "failed to open file: " << p.string());
+		return false;
+	}
+
+	// an unchanged file is loaded from the cache instead of being parsed again
+	std::string cache_key;
+	if(parse_cache && !debug_parser)
+	{
+		cache_key = parse_cache->key(buffer, p.string(), parent_sequence);
+		if(parse_cache->load(cache_key, parsed.containing_package_id, parsed.source))
+		{
+			parsed.active_package = parsed.source->root;
+			foreach(i, parent_sequence)
+				parsed.active_package = parsed.active_package->findPackage(*i);
+			return true;
+		}
+
+		// drop whatever a broken entry left behind, nothing else lives in the per-file arena yet
+		ASTNodeGC::instance()->cleanup();
+	}
+
 	getParserContext().active_source = new Source(p.string());
 	SourceInfoContext::set(getParserContext().active_source, new SourceInfoContext(0, 0)); // for logger, just in case
 	getParserContext().active_package = getParserContext().active_source->root;
@@ -256,85 +397,286 @@ bool ThorScriptParserStage::parse(const boost::filesystem::path& p)
 		containing_package_id = new SimpleIdentifier(L"");
 	}
 
-	// map the created program by the nested identifier as its key
-	getParserContext().tangle->addSource(containing_package_id, getParserContext().active_source);
+	// the source is added to the tangle later on, see execute()
+	parsed.containing_package_id = containing_package_id;
+	parsed.source = getParserContext().active_source;
+	parsed.active_package = getParserContext().active_package;
 
-	std::ifstream in(p.string(), std::ios_base::in);
+    getParserContext().debug.source = &buffer;
+    getParserContext().debug.source_index = SourceTable::instance().add(buffer.lineTable());
+    getParserContext().debug.position = buffer.data();
 
+	if(getParserContext().debug.source_index > SourceInfoContext::max_file || buffer.size() > SourceInfoContext::max_offset)
+		LOG4CXX_WARN(LoggerWrapper::ParserStage, "locations in " << p.string() << " are kept as line and column, the file is too large or there are too many files to number");
 
-	if(!in.good())
+    // try to parse directly over the mapped UTF-8 content
+	bool succeeded = false;
+	try
 	{
-		LOG4CXX_ERROR(LoggerWrapper::ParserStage, "failed to open file: " << p.string());
+		pos_iterator_type begin = buffer.begin();
+		pos_iterator_type end = buffer.end();
+
+		if(debug_parser)
+		{
+			debug_parser_type parser;
+			succeeded = qi::phrase_parse(
+					begin, end,
+					parser,
+					shared_skipper());
+		}
+		else
+		{
+			succeeded = qi::phrase_parse(
+					begin, end,
+					shared_parser(),
+					shared_skipper());
+		}
+	}
+	catch (const qi::expectation_failure<pos_iterator_type>& e)
+	{
+		uint32 line = 0, column = 0;
+		buffer.locate(e.first, line, column);
+
+		// TODO output error using Logger
+		// (collected and printed by execute() so messages of concurrently parsed files don't interleave)
+		std::wstring current_line;
+		expand_tabs(buffer.getLine(line), current_line);
+		std::wostringstream message;
+		message << L"parse error at file " << p.wstring() << L" line " << line
+				<< L" column " << column << std::endl
+				<< L"'" << current_line << L"'" << std::endl
+				<< std::setw(column) << L" " << L"^- here" << std::endl;
+		parsed.diagnostics += message.str();
+	}
+	catch (const std::out_of_range&)
+	{
+		// thrown by the UTF-8 decoding iterator
+		parsed.diagnostics += L"parser error: invalid UTF-8 sequence in input file: " + p.wstring() + L"\n";
+	}
+
+	// the buffer goes away with this scope, so nothing may refer to it afterwards
+	getParserContext().debug.source = NULL;
+	getParserContext().debug.position = NULL;
+
+	if(succeeded && !cache_key.empty())
+		parse_cache->store(cache_key, containing_package_id, getParserContext().active_source);
+
+	return succeeded;
+}
+
+bool ThorScriptParserStage::reparse(Source* source, const std::vector<TextEdit>& edits, ReparseResult& result)
+{
+	BOOST_ASSERT(source && "null source for incremental reparse is not allowed");
+
+	// the declarations are all added to the innermost package of the file, see parse()
+	Package* package = source->root;
+	while(package->objects.empty() && package->children.size() == 1)
+		package = package->children.front();
+
+	// objects added by later stages (template instantiations for example) have no span and are left alone
+	std::vector<ASTNode*> decls;
+	foreach(i, package->objects)
+	{
+		if(SourceSpanContext::get(*i))
+			decls.push_back(*i);
+	}
+
+	if(decls.empty())
+		return false;
+
+	// locations past the numbered files hold line and column, which can't be moved along
+	uint32 previous_index = SourceSpanContext::get(decls.front())->file;
+	if(previous_index > SourceInfoContext::max_file)
+		return false;
+
+	const SourceLineTable* previous_table = SourceTable::instance().get(previous_index);
+	if(!previous_table)
 		return false;
+
+	for(std::size_t i = 1; i < edits.size(); ++i)
+	{
+		if(edits[i].offset < edits[i-1].offset + edits[i-1].length)
+			return false;
 	}
 
-    // ignore the BOM marking the beginning of a UTF-8 file in Windows
-    if(in.peek() == '\xef')
-    {
-        char s[3];
-        in >> s[0] >> s[1] >> s[2];
-        s[3] = '\0';
-        if (s != std::string("\xef\xbb\xbf"))
-        {
-            std::cerr << "parser error: unexpected characters from input file: " << p.string() << std::endl;
-            return false;
-        }
-    }
+	// the declarations and the gaps after each of them (white spaces and comments, or new
+	// declarations once edited) are numbered alternately: 2i is declaration i, 2i+1 the gap after
+	// it; an edit merely touching the first or the last token of a declaration touches it as well
+	std::vector<bool> touched(decls.size() * 2, false);
+	foreach(e, edits)
+	{
+		if(e->offset < SourceSpanContext::get(decls.front())->begin)
+			return false; // in the imports
 
-    std::string source_code_raw;
-	in.unsetf(std::ios::skipws); // disable white space skipping
-	std::copy(std::istream_iterator<char>(in), std::istream_iterator<char>(), std::back_inserter(source_code_raw));
+		if(e->offset + e->length > previous_table->size)
+			return false; // past the end of the previous content
 
-    // convert it from UTF8 into UCS4 as a string by using u8_to_u32_iterator
-    std::wstring source_code;
-	utf8_to_ucs4(source_code_raw, source_code);
+		for(std::size_t i = 0; i < decls.size(); ++i)
+		{
+			SourceSpanContext* span = SourceSpanContext::get(decls[i]);
+			std::size_t gap_end = (i + 1 < decls.size()) ? SourceSpanContext::get(decls[i + 1])->begin : previous_table->size + 1;
 
-    // enable correct locale so that we can print UCS4 characters
-    enable_default_locale(std::wcout);
+			if(e->offset <= span->end && e->offset + e->length >= span->begin)
+				touched[2 * i] = true;
 
-    getParserContext().dump_rule_debug = debug_parser;
-    getParserContext().enable_semantic_action = !debug_parser;
-    getParserContext().debug.line = 1;
-    getParserContext().debug.column = 1;
+			if(e->length ? (e->offset < gap_end && e->offset + e->length > span->end) : (e->offset > span->end && e->offset < gap_end))
+				touched[2 * i + 1] = true;
+		}
+	}
 
-    // try to parse
-	typedef classic::position_iterator2<std::wstring::iterator> pos_iterator_type;
-	try
+	// where an offset into the previous content ends up after the edits
+	auto shift = [&](std::size_t offset, bool inclusive) -> std::size_t {
+		std::size_t shifted = offset;
+		foreach(e, edits)
+		{
+			if(e->offset > offset || (e->offset == offset && !inclusive))
+				break;
+			shifted = shifted + e->text.size() - e->length;
+		}
+		return shifted;
+	};
+
+	SourceBuffer buffer;
+	if(!buffer.open(source->filename))
+		return false;
+
+	// make sure the edits describe the file as it is now; offsets past the packed range would be
+	// located right away, against the previous content
+	if(shift(previous_table->size, true) != buffer.size() || buffer.size() > SourceInfoContext::max_offset)
+		return false;
+
+	// each run of adjacent touched declarations and gaps is reparsed into a scratch package, all
+	// in a scratch arena which is adopted by the one of the source only once every run succeeded;
+	// the tree is not modified before that, and a failure leaves nothing behind
+	ASTNodeGC scratch;
+	ASTNodeGC::Scope scratch_scope(scratch);
+
+	ParserContext context(NULL);
+	ParserContext::Scope context_scope(context);
+	context.debug.source = &buffer;
+	context.debug.source_index = previous_index; // the new content takes over the number once every run succeeded
+
+	struct Run
+	{
+		std::size_t first; // the declarations [first, last) are replaced
+		std::size_t last;
+		Package* parsed;
+	};
+
+	std::vector<Run> runs;
+	for(std::size_t k = 0; k < touched.size(); ++k)
 	{
-		pos_iterator_type begin(source_code.begin(), source_code.end(), p.wstring());
-		pos_iterator_type end;
+		if(!touched[k])
+			continue;
+
+		std::size_t first_item = k;
+		while(k + 1 < touched.size() && touched[k + 1])
+			++k;
+		std::size_t last_item = k;
+
+		Run run;
+		run.first = (first_item + 1) / 2;
+		run.last = last_item / 2 + 1;
+		run.parsed = new Package(new SimpleIdentifier(L""));
+
+		// a run starting (ending) with a gap starts after (ends before) an untouched declaration
+		std::size_t begin_offset = (first_item % 2 == 0)
+				? shift(SourceSpanContext::get(decls[first_item / 2])->begin, false)
+				: shift(SourceSpanContext::get(decls[first_item / 2])->end, true);
+		std::size_t end_offset = (last_item % 2 == 0)
+				? shift(SourceSpanContext::get(decls[last_item / 2])->end, true)
+				: (last_item / 2 + 1 < decls.size() ? shift(SourceSpanContext::get(decls[last_item / 2 + 1])->begin, false) : buffer.size());
+		if(begin_offset > end_offset)
+			return false;
 
-		grammar::ThorScript<pos_iterator_type, action::ThorScriptTreeAction> parser;
-		grammar::detail::WhiteSpace<pos_iterator_type> skipper;
+		context.active_package = run.parsed;
+		context.debug.position = buffer.data() + begin_offset;
 
-		if(!qi::phrase_parse(
-				begin, end,
-				parser,
-				skipper))
+		try
+		{
+			pos_iterator_type begin = buffer.at(begin_offset);
+			pos_iterator_type end = buffer.at(end_offset);
+
+			if(!qi::phrase_parse(begin, end, shared_parser().global_decl_list > qi::eoi, shared_skipper()))
+				return false;
+		}
+		catch(const qi::expectation_failure<pos_iterator_type>&)
+		{
+			return false; // left for the full parse to report
+		}
+		catch(const std::out_of_range&)
 		{
 			return false;
 		}
+
+		runs.push_back(run);
 	}
-	catch (const qi::expectation_failure<pos_iterator_type>& e)
+
+	// untouched declarations keep their nodes, their locations are moved into the new content
+	for(std::size_t i = 0; i < decls.size(); ++i)
 	{
-		const classic::file_position_base<std::wstring>& pos = e.first.get_position();
+		if(touched[2 * i])
+			continue;
 
-		// TODO output error using Logger
-		std::wstring current_line;
-		expand_tabs(e.first.get_currentline(), current_line);
-		std::wcerr << L"parse error at file " << pos.file << L" line " << pos.line
-				<< L" column " << pos.column << std::endl
-				<< L"'" << current_line << L"'" << std::endl
-				<< std::setw(pos.column) << L" " << L"^- here" << std::endl;
+		SourceSpanContext* span = SourceSpanContext::get(decls[i]);
+		std::size_t begin_offset = shift(span->begin, false);
+		std::size_t end_offset = shift(span->end, true);
+		std::size_t delta = begin_offset - span->begin; // no edit lies inside, so it moves as a whole
 
-		return false;
+		ASTNodeHelper::foreachApply<ASTNode>(*decls[i], [&](ASTNode& node) {
+			SourceInfoContext* info = SourceInfoContext::get(&node);
+			if(info && info->isPacked() && info->file() == previous_index)
+				*info = SourceInfoContext::at(previous_index, info->offset() + delta);
+		});
+
+		SourceSpanContext::set(decls[i], SourceSpanContext(begin_offset, end_offset, previous_index));
 	}
 
-    if(dump_graphviz)
-    {
-        boost::filesystem::path p(dump_graphviz_dir);
-        ASTNodeHelper::visualize(getParserContext().tangle, p / "post-parse.dot");
-    }
+	// the file keeps its number, so a resident compiler doesn't run out of them
+	SourceTable::instance().replace(previous_index, buffer.lineTable());
+
+	// splice the reparsed declarations in
+	foreach(run, runs)
+	{
+		std::vector<ASTNode*> parsed = run->parsed->objects;
+		std::size_t previous_count = run->last - run->first;
+		std::size_t replaced_count = std::min(parsed.size(), previous_count);
+
+		for(std::size_t i = 0; i < replaced_count; ++i)
+			package->replaceUseWith(*decls[run->first + i], *parsed[i]);
+
+		if(parsed.size() > previous_count)
+		{
+			// a run without any declaration starts with the gap after the untouched declaration run->first - 1
+			ASTNode* anchor = replaced_count ? parsed[replaced_count - 1] : decls[run->first - 1];
+			std::vector<ASTNode*>::iterator position = std::find(package->objects.begin(), package->objects.end(), anchor);
+			for(std::size_t i = replaced_count; i < parsed.size(); ++i)
+			{
+				parsed[i]->parent = package;
+				position = package->objects.insert(position + 1, parsed[i]);
+			}
+		}
+		else
+		{
+			for(std::size_t i = run->first + replaced_count; i < run->last; ++i)
+			{
+				package->objects.erase(std::find(package->objects.begin(), package->objects.end(), decls[i]));
+				decls[i]->parent = NULL;
+			}
+		}
+
+		result.changed.insert(result.changed.end(), parsed.begin(), parsed.end());
+		result.removed.insert(result.removed.end(), decls.begin() + run->first, decls.begin() + run->last);
+
+		// the scratch package itself is not needed any more
+		run->parsed->objects.clear();
+		delete run->parsed->id;
+		delete run->parsed;
+	}
+
+	ASTNodeGC::ownerOf(source)->adopt(scratch, [](const ASTNode* node, uint32 offset) {
+		const_cast<ASTNode*>(node)->node_id += offset;
+	});
 
 	return true;
 }
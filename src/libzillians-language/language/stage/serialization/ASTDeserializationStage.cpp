@@ -19,12 +19,15 @@
 
 #include "language/stage/serialization/ASTDeserializationStage.h"
 #include "language/stage/serialization/detail/ASTSerializationHelper.h"
+#include "language/stage/serialization/detail/PreludeImage.h"
+#include "language/stage/serialization/detail/ASTImageCache.h"
 #include "language/context/ParserContext.h"
 #include <boost/filesystem.hpp>
+#include <iostream>
 
 namespace zillians { namespace language { namespace stage {
 
-ASTDeserializationStage::ASTDeserializationStage() : enabled_load(false), dump_graphviz(false)
+ASTDeserializationStage::ASTDeserializationStage() : enabled_load(false), use_shared_cache(false), dump_graphviz(false)
 { }
 
 ASTDeserializationStage::~ASTDeserializationStage()
@@ -41,11 +44,13 @@ std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_descriptio
 	shared_ptr<po::options_description> option_desc_private(new po::options_description());
 
 	option_desc_public->add_options()
-		("load-ast", po::value<std::vector<std::string>>(), "load serialized AST file as root");
+		("load-ast", po::value<std::vector<std::string>>(), "load serialized AST file as root")
+		("prelude", po::value<std::string>(), "load precompiled system prelude image");
 
 	foreach(i, option_desc_public->options()) option_desc_private->add(*i);
 
 	option_desc_private->add_options()
+		("shared-ast-cache", "decode loaded AST files from the process-wide image cache (in-process ts-make jobs)")
 		//("dump-graphviz", "dump AST in graphviz format")
 		//("dump-graphviz-dir", po::value<std::string>(), "dump AST in graphviz format")
     ;
@@ -61,6 +66,13 @@ bool ASTDeserializationStage::parseOptions(po::variables_map& vm)
 		ast_files_to_load = vm["load-ast"].as<std::vector<std::string>>();
 	}
 
+	if(vm.count("prelude") > 0)
+		prelude_file = vm["prelude"].as<std::string>();
+	else
+		prelude_file.clear();
+
+	use_shared_cache = (vm.count("shared-ast-cache") > 0);
+
 	dump_graphviz = (vm.count("dump-graphviz") > 0);
     if(vm.count("dump-graphviz-dir") > 0)
     {
@@ -78,13 +90,50 @@ bool ASTDeserializationStage::execute(bool& continue_execution)
 	if(!hasParserContext())
 		setParserContext(new ParserContext());
 
+	// the system API comes resolved and mangled already, nothing of it is parsed again
+	if(!prelude_file.empty())
+	{
+		tree::Tangle* t = PreludeImage::load(prelude_file);
+		if(!t) return false;
+
+		t->markImported(true /*is_imported*/);
+		if(getParserContext().tangle)
+		{
+			getParserContext().tangle->merge(*t);
+		}
+		else
+		{
+			getParserContext().tangle = t;
+		}
+	}
+
+	// ids of tangles compiled against each other never overlap, but tangles compiled side by side
+	// (importing the same ones) may have been handed the same ids, which their code already uses
+	std::vector<std::pair<std::string, tree::Tangle::MangledIds>> loaded_ids;
+
 	foreach(i, ast_files_to_load)
 	{
         std::string ast_file_to_load = *i;
-		tree::ASTNode* deserialized = ASTSerializationHelper::deserialize(ast_file_to_load);
-		if(!deserialized || !tree::isa<tree::Tangle>(deserialized)) return false;
+		tree::Tangle* t = NULL;
+		if(use_shared_cache)
+		{
+			t = ASTImageCache::instance().load(ast_file_to_load);
+		}
+		else
+		{
+			tree::ASTNode* deserialized = ASTSerializationHelper::deserialize(ast_file_to_load);
+			if(deserialized && tree::isa<tree::Tangle>(deserialized))
+				t = tree::cast<tree::Tangle>(deserialized);
+		}
+		if(!t) return false;
+
+		foreach(j, loaded_ids)
+		{
+			if(j->second.overlaps(t->mangled_ids))
+				std::cerr << "warning: mangled ids of `" << ast_file_to_load << "` overlap the ones of `" << j->first << "`, compile one of them against the other" << std::endl;
+		}
+		loaded_ids.push_back(std::make_pair(ast_file_to_load, t->mangled_ids));
 
-		tree::Tangle* t = tree::cast<tree::Tangle>(deserialized);
 		t->markImported(true /*is_imported*/);
 		if(getParserContext().tangle)
 		{
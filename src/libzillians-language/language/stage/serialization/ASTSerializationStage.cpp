@@ -19,7 +19,9 @@
 
 #include "language/stage/serialization/ASTSerializationStage.h"
 #include "language/stage/serialization/detail/ASTSerializationHelper.h"
+#include "language/stage/serialization/detail/PreludeImage.h"
 #include "language/context/ParserContext.h"
+#include <fstream>
 
 namespace zillians { namespace language { namespace stage {
 
@@ -44,18 +46,29 @@ std::pair<shared_ptr<po::options_description>, shared_ptr<po::options_descriptio
 
 	foreach(i, option_desc_public->options()) option_desc_private->add(*i);
 
-	option_desc_private->add_options();
+	option_desc_private->add_options()
+		("emit-prelude", po::value<std::string>(), "emit precompiled prelude image (used when building the system API)");
 
 	return std::make_pair(option_desc_public, option_desc_private);
 }
 
 bool ASTSerializationStage::parseOptions(po::variables_map& vm)
 {
-	enabled = (vm.count("emit-ast") > 0);
-	if(enabled)
+	enabled = (vm.count("emit-ast") > 0 || vm.count("emit-prelude") > 0);
+	if(vm.count("emit-ast") > 0)
 	{
 		ast_file = vm["emit-ast"].as<std::string>();
 	}
+	if(vm.count("emit-prelude") > 0)
+	{
+		prelude_file = vm["emit-prelude"].as<std::string>();
+	}
+
+	// see ASTDeserializationStage
+	if(vm.count("load-ast") > 0)
+		dependency_ast_files = vm["load-ast"].as<std::vector<std::string>>();
+	else
+		dependency_ast_files.clear();
 
 	return true;
 }
@@ -68,7 +81,24 @@ bool ASTSerializationStage::execute(bool& continue_execution)
 	if(!hasParserContext())
 		return false;
 
-	if(!ASTSerializationHelper::serialize(ast_file, getParserContext().tangle))
+	if(!ast_file.empty())
+	{
+		if(!ASTSerializationHelper::serialize(ast_file, getParserContext().tangle))
+			return false;
+
+		// see ThorScriptMakeStage, dependents of the tangle are compiled again only if this changes,
+		// which it also does whenever the interface of a dependency changes
+		std::vector<std::string> dependency_fingerprints;
+		foreach(i, dependency_ast_files)
+			dependency_fingerprints.push_back(ASTSerializationHelper::readInterfaceFingerprint(*i));
+
+		std::ofstream interface_file((ast_file + ".interface").c_str());
+		interface_file << ASTSerializationHelper::interfaceFingerprint(getParserContext().tangle, dependency_fingerprints) << std::endl;
+		if(!interface_file.good())
+			return false;
+	}
+
+	if(!prelude_file.empty() && !PreludeImage::write(prelude_file, getParserContext().tangle))
 		return false;
 
 	UNUSED_ARGUMENT(continue_execution);
@@ -0,0 +1,89 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/stage/serialization/detail/ASTImageCache.h"
+#include "language/stage/serialization/detail/ASTSerializationHelper.h"
+#include "language/stage/serialization/detail/PreludeImage.h"
+#include <boost/filesystem.hpp>
+#include <sstream>
+
+namespace zillians { namespace language { namespace stage {
+
+ASTImageCache& ASTImageCache::instance()
+{
+	static ASTImageCache cache;
+	return cache;
+}
+
+tree::Tangle* ASTImageCache::load(const std::string& filename)
+{
+	shared_ptr<const std::string> encoded = image(filename);
+	if(!encoded)
+		return NULL;
+
+	return PreludeImage::decode(encoded->data(), encoded->size());
+}
+
+void ASTImageCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+}
+
+shared_ptr<const std::string> ASTImageCache::image(const std::string& filename)
+{
+	boost::system::error_code error;
+	std::time_t mtime = boost::filesystem::last_write_time(filename, error);
+	if(error) mtime = 0;
+	uintmax_t size = boost::filesystem::file_size(filename, error);
+	if(error) size = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto i = entries.find(filename);
+		if(i != entries.end() && i->second.mtime == mtime && i->second.size == size)
+			return i->second.image;
+	}
+
+	// parse outside the lock so jobs waiting for other files aren't held up; two jobs asking for
+	// the same file at once may both parse it, which is harmless
+	std::ostringstream out(std::ios_base::out | std::ios_base::binary);
+	{
+		tree::ASTNodeGC arena;
+		tree::ASTNodeGC::Scope scope(arena);
+
+		tree::ASTNode* deserialized = ASTSerializationHelper::deserialize(filename);
+		if(!deserialized || !tree::isa<tree::Tangle>(deserialized))
+			return shared_ptr<const std::string>();
+
+		if(!PreludeImage::encode(out, tree::cast<tree::Tangle>(deserialized)))
+			return shared_ptr<const std::string>();
+	}
+
+	Entry entry;
+	entry.mtime = mtime;
+	entry.size = size;
+	entry.image.reset(new std::string(out.str()));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	entries[filename] = entry;
+	return entry.image;
+}
+
+} } }
@@ -23,6 +23,10 @@
 #include "language/stage/serialization/detail/ASTSerializationHelper.h"
 #include "language/stage/serialization/visitor/ASTDeserializationStageVisitor.h"
 #include "language/stage/serialization/visitor/ASTSerializationStageVisitor.h"
+#include "language/tree/ASTNodeHelper.h"
+#include "utility/sha1.h"
+#include <iterator>
+#include <sstream>
 
 namespace zillians { namespace language { namespace stage {
 
@@ -65,4 +69,75 @@ tree::ASTNode* ASTSerializationHelper::deserialize(const std::string& filename)
 	return from_serialize;
 }
 
+static bool isTemplated(tree::FunctionDecl& decl)
+{
+	if(tree::isa<tree::TemplatedIdentifier>(decl.name))
+		return true;
+
+	for(tree::ClassDecl* owner = tree::ASTNodeHelper::getOwner<tree::ClassDecl>(&decl); owner; owner = tree::ASTNodeHelper::getOwner<tree::ClassDecl>(owner))
+	{
+		if(tree::isa<tree::TemplatedIdentifier>(owner->name))
+			return true;
+	}
+	return false;
+}
+
+std::string ASTSerializationHelper::interfaceFingerprint(tree::ASTNode* node)
+{
+	// detach the bodies for the time of serializing, dependents only instantiate template ones
+	std::vector<std::pair<tree::FunctionDecl*, tree::Block*>> detached;
+	tree::ASTNodeHelper::foreachApply<tree::FunctionDecl>(*node, [&](tree::FunctionDecl& decl) {
+		if(decl.block && !isTemplated(decl))
+			detached.push_back(std::make_pair(&decl, decl.block));
+	});
+
+	foreach(i, detached)
+		i->first->block = NULL;
+
+	std::ostringstream oss;
+	try
+	{
+		boost::archive::text_oarchive oa(oss, boost::archive::no_header);
+		tree::ASTNode* to_serialize = node;
+		oa << to_serialize;
+	}
+	catch(...)
+	{
+		foreach(i, detached)
+			i->first->block = i->second;
+		throw;
+	}
+
+	foreach(i, detached)
+		i->first->block = i->second;
+
+	return sha1::sha1(oss.str());
+}
+
+std::string ASTSerializationHelper::interfaceFingerprint(tree::ASTNode* node, const std::vector<std::string>& dependency_fingerprints)
+{
+	std::string material = interfaceFingerprint(node);
+	foreach(i, dependency_fingerprints)
+		material += "\n" + *i;
+
+	return sha1::sha1(material);
+}
+
+std::string ASTSerializationHelper::readInterfaceFingerprint(const std::string& ast_file)
+{
+	std::string fingerprint;
+	{
+		std::ifstream ifs((ast_file + ".interface").c_str());
+		std::getline(ifs, fingerprint);
+	}
+	if(!fingerprint.empty())
+		return fingerprint;
+
+	std::ifstream ifs(ast_file.c_str(), std::ios_base::in | std::ios_base::binary);
+	if(!ifs.good())
+		return std::string();
+
+	return sha1::sha1(std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()));
+}
+
 } } }
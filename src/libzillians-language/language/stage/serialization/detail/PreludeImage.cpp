@@ -0,0 +1,255 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+#include "language/stage/serialization/detail/PreludeImage.h"
+#include "language/stage/serialization/visitor/ASTDeserializationStageVisitor.h"
+#include "language/stage/serialization/visitor/ASTSerializationStageVisitor.h"
+
+#include <cstring>
+#include <fstream>
+#include <streambuf>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace zillians { namespace language { namespace stage {
+
+namespace {
+
+// bump whenever the layout of the header or of the archived tree changes
+static const uint32 image_version = 2;
+
+struct ImageHeader
+{
+	char magic[8];
+	uint32 version;
+	uint32 reserved;
+	uint64 payload_size;
+};
+
+static const char image_magic[8] = { 'T', 'S', 'P', 'R', 'E', 'L', 'U', 'D' };
+
+/**
+ * Read-only view of a whole image file, mapped shared so all processes loading the same
+ * image are served from the same page cache pages
+ */
+class MappedImage : boost::noncopyable
+{
+public:
+	MappedImage() : address(NULL), length(0)
+	{ }
+
+	~MappedImage()
+	{
+#if !defined(_WIN32)
+		if(address)
+			::munmap(address, length);
+#endif
+	}
+
+	bool open(const std::string& filename)
+	{
+#if !defined(_WIN32)
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if(fd < 0)
+			return false;
+
+		struct stat st;
+		if(::fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* mapped = ::mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if(mapped == MAP_FAILED)
+			return false;
+
+		address = mapped;
+		length = st.st_size;
+#else
+		std::ifstream in(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+		if(!in.good())
+			return false;
+
+		fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		address = &fallback[0];
+		length = fallback.size();
+#endif
+		return true;
+	}
+
+	const char* data() const  { return static_cast<const char*>(address); }
+	std::size_t size() const  { return length; }
+
+private:
+	void* address;
+	std::size_t length;
+#if defined(_WIN32)
+	std::string fallback;
+#endif
+};
+
+// lets the archive read straight out of the mapping without copying it into a stream first
+struct MappedStreamBuffer : std::streambuf
+{
+	MappedStreamBuffer(const char* first, std::size_t size)
+	{
+		char* begin = const_cast<char*>(first); // never written through, the get area is read-only
+		setg(begin, begin, begin + size);
+	}
+};
+
+}
+
+bool PreludeImage::write(const std::string& filename, tree::Tangle* tangle)
+{
+	boost::system::error_code error;
+	boost::filesystem::path temporary = boost::filesystem::unique_path(filename + ".%%%%-%%%%.tmp", error);
+	if(error)
+		return false;
+
+	try
+	{
+		std::ofstream ofs(temporary.string(), std::ios_base::out | std::ios_base::binary);
+		if(!ofs.good())
+		{
+			std::cerr << "Can not open file `" << temporary.string() << "` to write" << std::endl;
+			return false;
+		}
+
+		ImageHeader header;
+		std::memcpy(header.magic, image_magic, sizeof(image_magic));
+		header.version = image_version;
+		header.reserved = 0;
+		header.payload_size = 0;
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		if(!encode(ofs, tangle))
+		{
+			ofs.close();
+			boost::filesystem::remove(temporary, error);
+			return false;
+		}
+
+		// the payload size lets load() reject a truncated image before handing it to the archive
+		header.payload_size = static_cast<uint64>(ofs.tellp()) - sizeof(header);
+		ofs.seekp(0);
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		if(!ofs.good())
+		{
+			boost::filesystem::remove(temporary, error);
+			return false;
+		}
+	}
+	catch(const std::exception&)
+	{
+		boost::filesystem::remove(temporary, error);
+		return false;
+	}
+
+	// ts-compile processes of a running build may be loading the old image, so replace it atomically
+	boost::filesystem::rename(temporary, filename, error);
+	if(error)
+	{
+		boost::filesystem::remove(temporary, error);
+		return false;
+	}
+	return true;
+}
+
+tree::Tangle* PreludeImage::load(const std::string& filename)
+{
+	MappedImage image;
+	if(!image.open(filename))
+	{
+		std::cerr << "Can not open file `" << filename << "` to read" << std::endl;
+		return NULL;
+	}
+
+	ImageHeader header;
+	if(image.size() < sizeof(header))
+		return NULL;
+	std::memcpy(&header, image.data(), sizeof(header));
+
+	if(std::memcmp(header.magic, image_magic, sizeof(image_magic)) != 0 ||
+	   header.version != image_version ||
+	   header.payload_size != image.size() - sizeof(header))
+	{
+		std::cerr << "Prelude image `" << filename << "` is broken or built by another version of the compiler" << std::endl;
+		return NULL;
+	}
+
+	tree::Tangle* tangle = decode(image.data() + sizeof(header), header.payload_size);
+	if(!tangle)
+		std::cerr << "Prelude image `" << filename << "` is broken or built by another version of the compiler" << std::endl;
+	return tangle;
+}
+
+bool PreludeImage::encode(std::ostream& out, tree::Tangle* tangle)
+{
+	try
+	{
+		boost::archive::binary_oarchive oa(out);
+		tree::ASTNode* to_serialize = tangle;
+		oa << to_serialize;
+
+		visitor::ASTSerializationStageVisitor<boost::archive::binary_oarchive> serializer(oa);
+		serializer.visit(*to_serialize);
+	}
+	catch(const std::exception&)
+	{
+		return false;
+	}
+	return out.good();
+}
+
+tree::Tangle* PreludeImage::decode(const char* data, std::size_t size)
+{
+	try
+	{
+		MappedStreamBuffer buffer(data, size);
+		boost::archive::binary_iarchive ia(buffer);
+		tree::ASTNode* from_serialize = NULL;
+		ia >> from_serialize;
+
+		if(!tree::isa<tree::Tangle>(from_serialize))
+			return NULL;
+
+		visitor::ASTDeserializationStageVisitor<boost::archive::binary_iarchive> deserializer(ia);
+		deserializer.visit(*from_serialize);
+
+		return tree::cast<tree::Tangle>(from_serialize);
+	}
+	catch(const std::exception&)
+	{
+		return NULL;
+	}
+}
+
+} } }
@@ -93,6 +93,7 @@ bool ImplicitConversionStage::execute(bool& continue_execution)
         }
 
         visitor::ImplicitConversionStageVisitor implicitConvert;
+        implicitConvert.setActiveSourcesOnly(true);
         implicitConvert.visit(*parser_context.tangle);
         implicitConvert.applyTransforms();
 
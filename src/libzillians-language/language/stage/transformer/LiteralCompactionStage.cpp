@@ -61,10 +61,8 @@ bool LiteralCompactionStage::parseOptions(po::variables_map& vm)
 	return true;
 }
 
-bool LiteralCompactionStage::execute(bool& continue_execution)
+bool LiteralCompactionStage::prepareTraversal(tree::visitor::GenericDoubleVisitor*& walker)
 {
-	UNUSED_ARGUMENT(continue_execution);
-
 	if(!hasParserContext())
 		return false;
 
@@ -72,21 +70,9 @@ bool LiteralCompactionStage::execute(bool& continue_execution)
 
 	if(parser_context.active_source)
 	{
-		visitor::LiteralCompactionStageVisitor compactor;
-		compactor.visit(*parser_context.active_source);
-
-		if(debug)
-		{
-			tree::visitor::PrettyPrintVisitor printer;
-			printer.visit(*parser_context.active_source);
-		}
-
-        if(dump_graphviz)
-        {
-            boost::filesystem::path p(dump_graphviz_dir);
-            ASTNodeHelper::visualize(getParserContext().tangle, p / "post-literal-compaction.dot");
-        }
-
+		// only the active source is compacted, the others are walked through but left untouched
+		compactor.reset(new visitor::LiteralCompactionStageVisitor(parser_context.active_source));
+		walker = compactor.get();
 		return true;
 	}
 	else
@@ -95,4 +81,27 @@ bool LiteralCompactionStage::execute(bool& continue_execution)
 	}
 }
 
+bool LiteralCompactionStage::finishTraversal(bool& continue_execution)
+{
+	UNUSED_ARGUMENT(continue_execution);
+
+	compactor.reset();
+
+	ParserContext& parser_context = getParserContext();
+
+	if(debug)
+	{
+		tree::visitor::PrettyPrintVisitor printer;
+		printer.visit(*parser_context.active_source);
+	}
+
+    if(dump_graphviz)
+    {
+        boost::filesystem::path p(dump_graphviz_dir);
+        ASTNodeHelper::visualize(getParserContext().tangle, p / "post-literal-compaction.dot");
+    }
+
+	return true;
+}
+
 } } }
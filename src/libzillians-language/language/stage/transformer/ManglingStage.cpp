@@ -56,10 +56,8 @@ bool ManglingStage::parseOptions(po::variables_map& vm)
 	return true;
 }
 
-bool ManglingStage::execute(bool& continue_execution)
+bool ManglingStage::prepareTraversal(tree::visitor::GenericDoubleVisitor*& walker)
 {
-	UNUSED_ARGUMENT(continue_execution);
-
 	if(disable_mangling)
 		return true;
 
@@ -70,8 +68,14 @@ bool ManglingStage::execute(bool& continue_execution)
 
 	if(parser_context.active_source)
 	{
-		visitor::ManglingStageVisitor mangler;
-		mangler.visit(*parser_context.tangle);
+		// imported declarations are deserialized along with their mangled names and ids, and the
+		// tangle knows the largest ids of all of them, see ASTDeserializationStage
+		tree::Tangle& tangle = *parser_context.tangle;
+		mangler.reset(new visitor::ManglingStageVisitor(tangle.mangled_ids.next_type_id, tangle.mangled_ids.next_symbol_id));
+		tangle.mangled_ids.first_type_id = mangler->nextTypeId();
+		tangle.mangled_ids.first_symbol_id = mangler->nextSymbolId();
+		mangler->setActiveSourcesOnly(true);
+		walker = mangler.get();
 		return true;
 	}
 	else
@@ -80,4 +84,19 @@ bool ManglingStage::execute(bool& continue_execution)
 	}
 }
 
+bool ManglingStage::finishTraversal(bool& continue_execution)
+{
+	UNUSED_ARGUMENT(continue_execution);
+
+	if(mangler)
+	{
+		// recorded in the AST, so tangles compiled against this one number past it
+		getParserContext().tangle->mangled_ids.next_type_id = mangler->nextTypeId();
+		getParserContext().tangle->mangled_ids.next_symbol_id = mangler->nextSymbolId();
+	}
+
+	mangler.reset();
+	return true;
+}
+
 } } }
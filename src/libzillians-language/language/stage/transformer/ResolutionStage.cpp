@@ -169,6 +169,7 @@ void ResolutionStage::resolveTypes(bool report_error_summary, bool& making_progr
 	visitor::ResolutionStageVisitor visitor(visitor::ResolutionStageVisitor::Target::TYPE_RESOLUTION, resolver);
 
 	visitor.reset();
+	visitor.setActiveSourcesOnly(true);
 	visitor.visit(*parser_context.tangle);
 
 	std::size_t unresolved_count = 0; 
@@ -230,6 +231,7 @@ void ResolutionStage::resolveSymbols(bool report_error_summary, bool& making_pro
 	visitor::ResolutionStageVisitor visitor(visitor::ResolutionStageVisitor::Target::SYMBOL_RESOLUTION, resolver);
 
 	visitor.reset();
+	visitor.setActiveSourcesOnly(true);
 	visitor.visit(*parser_context.tangle);
 
 	std::size_t unresolved_count = visitor.getUnresolvedCount();
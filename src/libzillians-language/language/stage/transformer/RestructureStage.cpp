@@ -76,6 +76,7 @@ bool RestructureStage::execute(bool& continue_execution)
 		while(true)
 		{
 			visitor::RestructureStageVisitor restruct;
+			restruct.setActiveSourcesOnly(true);
 			restruct.visit(*parser_context.tangle);
 			if(restruct.hasTransforms())
 				restruct.applyTransforms();
@@ -55,10 +55,8 @@ bool SemanticVerificationStage0::parseOptions(po::variables_map& vm)
 	return true;
 }
 
-bool SemanticVerificationStage0::execute(bool& continue_execution)
+bool SemanticVerificationStage0::prepareTraversal(tree::visitor::GenericDoubleVisitor*& walker)
 {
-	UNUSED_ARGUMENT(continue_execution);
-
 	if(!hasParserContext())
 		return false;
 
@@ -66,9 +64,8 @@ bool SemanticVerificationStage0::execute(bool& continue_execution)
 
 	if(parser_context.tangle)
 	{
-		visitor::SemanticVerificationStageVisitor0 verifier;
-		verifier.visit(*parser_context.tangle);
-		verifier.applyCleanup();
+		verifier.reset(new visitor::SemanticVerificationStageVisitor0());
+		walker = verifier.get();
 		return true;
 	}
 	else
@@ -77,4 +74,13 @@ bool SemanticVerificationStage0::execute(bool& continue_execution)
 	}
 }
 
+bool SemanticVerificationStage0::finishTraversal(bool& continue_execution)
+{
+	UNUSED_ARGUMENT(continue_execution);
+
+	verifier->applyCleanup();
+	verifier.reset();
+	return true;
+}
+
 } } }
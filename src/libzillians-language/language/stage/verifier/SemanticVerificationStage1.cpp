@@ -55,10 +55,8 @@ bool SemanticVerificationStage1::parseOptions(po::variables_map& vm)
 	return true;
 }
 
-bool SemanticVerificationStage1::execute(bool& continue_execution)
+bool SemanticVerificationStage1::prepareTraversal(tree::visitor::GenericDoubleVisitor*& walker)
 {
-	UNUSED_ARGUMENT(continue_execution);
-
 	if(!hasParserContext())
 		return false;
 
@@ -66,9 +64,10 @@ bool SemanticVerificationStage1::execute(bool& continue_execution)
 
 	if(parser_context.tangle)
 	{
-		visitor::SemanticVerificationStageVisitor1 verifier;
-		verifier.visit(*parser_context.tangle);
-		verifier.applyCleanup();
+		// imported sources have been verified when they were compiled
+		verifier.reset(new visitor::SemanticVerificationStageVisitor1());
+		verifier->setActiveSourcesOnly(true);
+		walker = verifier.get();
 		return true;
 	}
 	else
@@ -77,4 +76,13 @@ bool SemanticVerificationStage1::execute(bool& continue_execution)
 	}
 }
 
+bool SemanticVerificationStage1::finishTraversal(bool& continue_execution)
+{
+	UNUSED_ARGUMENT(continue_execution);
+
+	verifier->applyCleanup();
+	verifier.reset();
+	return true;
+}
+
 } } }
@@ -400,8 +400,7 @@ struct CodePoint
         Source* sourceNode = ASTNodeHelper::getOwner<Source>(node);
         filename = s_to_ws(sourceNode->filename);
         stage::SourceInfoContext* source_info = stage::SourceInfoContext::get(node);
-        line = source_info->line;
-        column = source_info->column;
+        source_info->locate(line, column);
     }
 
     std::wstring filename;
@@ -1,5 +1,7 @@
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp> // for the prelude image, see PreludeImage
+#include <boost/archive/binary_iarchive.hpp>
 
 #include "language/tree/ASTNodeFactory.h"
 
@@ -49,7 +49,7 @@ std::wstring FunctionType::toString() const
 	return ss.str();
 }
 
-ASTNode* FunctionType::clone() const
+ASTNode* FunctionType::cloneImpl() const
 {
 	FunctionType* cloned = new FunctionType();
 	foreach(i, parameter_types) cloned->parameter_types.push_back( (*i) ? cast<TypeSpecifier>((*i)->clone()) : NULL);
@@ -24,11 +24,58 @@
 
 namespace zillians { namespace language { namespace tree {
 
+namespace {
+
+// view an identifier as a sequence of simple components, which is how its toString() is formed
+bool getComponents(const Identifier& id, const Identifier* const*& begin, std::size_t& count, const Identifier*& self)
+{
+	if(isa<SimpleIdentifier>(&id))
+	{
+		self = &id;
+		begin = &self;
+		count = 1;
+		return true;
+	}
+	else if(isa<NestedIdentifier>(&id))
+	{
+		const std::vector<Identifier*>& list = cast<const NestedIdentifier>(&id)->identifier_list;
+		foreach(i, list)
+			if(!isa<SimpleIdentifier>(*i)) return false;
+
+		begin = list.empty() ? NULL : &list[0];
+		count = list.size();
+		return true;
+	}
+	return false;
+}
+
+}
+
+int Identifier::compareName(const Identifier& lhs, const Identifier& rhs)
+{
+	const Identifier* const* lhs_begin = NULL; std::size_t lhs_count = 0; const Identifier* lhs_self = NULL;
+	const Identifier* const* rhs_begin = NULL; std::size_t rhs_count = 0; const Identifier* rhs_self = NULL;
+
+	if(!getComponents(lhs, lhs_begin, lhs_count, lhs_self) || !getComponents(rhs, rhs_begin, rhs_count, rhs_self))
+		return lhs.toString().compare(rhs.toString());
+
+	// '.' sorts before every character allowed in an identifier, so comparing component by
+	// component (a shorter prefix goes first) gives the same order as comparing the joined strings
+	for(std::size_t i = 0; i < lhs_count && i < rhs_count; ++i)
+	{
+		int result = cast<const SimpleIdentifier>(lhs_begin[i])->name.compare(cast<const SimpleIdentifier>(rhs_begin[i])->name);
+		if(result != 0)
+			return result;
+	}
+
+	return (lhs_count < rhs_count) ? -1 : ((lhs_count > rhs_count) ? 1 : 0);
+}
+
 SimpleIdentifier::SimpleIdentifier()
-{ }
+{ setNodeType(this); }
 
-SimpleIdentifier::SimpleIdentifier(const std::wstring& s) : name(s)
-{ }
+SimpleIdentifier::SimpleIdentifier(const Symbol& s) : name(s)
+{ setNodeType(this); }
 
 std::wstring SimpleIdentifier::toString() const
 {
@@ -37,7 +84,7 @@ std::wstring SimpleIdentifier::toString() const
 
 bool SimpleIdentifier::isEmpty() const
 {
-	return (name.length() == 0);
+	return name.empty();
 }
 
 bool SimpleIdentifier::isEqualImpl(const ASTNode& rhs, ASTNodeSet& visited) const
@@ -54,7 +101,7 @@ bool SimpleIdentifier::replaceUseWith(const ASTNode& from, const ASTNode& to, bo
 	END_REPLACE()
 }
 
-ASTNode* SimpleIdentifier::clone() const
+ASTNode* SimpleIdentifier::cloneImpl() const
 {
 	return new SimpleIdentifier(name);
 }
@@ -65,7 +112,7 @@ ASTNode* SimpleIdentifier::clone() const
 namespace zillians { namespace language { namespace tree {
 
 NestedIdentifier::NestedIdentifier()
-{ }
+{ setNodeType(this); }
 
 std::wstring NestedIdentifier::toString() const
 {
@@ -112,7 +159,7 @@ bool NestedIdentifier::replaceUseWith(const ASTNode& from, const ASTNode& to, bo
 	END_REPLACE()
 }
 
-ASTNode* NestedIdentifier::clone() const
+ASTNode* NestedIdentifier::cloneImpl() const
 {
 	NestedIdentifier* cloned = new NestedIdentifier();
 	foreach(i, identifier_list) cloned->appendIdentifier(cast<Identifier>((*i)->clone()));
@@ -124,10 +171,11 @@ ASTNode* NestedIdentifier::clone() const
 namespace zillians { namespace language { namespace tree {
 
 TemplatedIdentifier::TemplatedIdentifier()
-{ }
+{ setNodeType(this); }
 
 TemplatedIdentifier::TemplatedIdentifier(Usage::type type, Identifier* id) : type(type), id(id)
 {
+	setNodeType(this);
 	id->parent = this;
 }
 
@@ -253,7 +301,7 @@ bool TemplatedIdentifier::replaceUseWith(const ASTNode& from, const ASTNode& to,
 	END_REPLACE()
 }
 
-ASTNode* TemplatedIdentifier::clone() const
+ASTNode* TemplatedIdentifier::cloneImpl() const
 {
 	TemplatedIdentifier* cloned = new TemplatedIdentifier(type, (id) ? cast<Identifier>(id->clone()) : NULL);
 
@@ -24,22 +24,25 @@
 namespace zillians { namespace language { namespace tree {
 
 TypeSpecifier::TypeSpecifier()
-{ }
+{ setNodeType(this); }
 
 TypeSpecifier::TypeSpecifier(FunctionType* function_proto)
 {
+	setNodeType(this);
 	referred.unspecified = NULL;
 	update(function_proto);
 }
 
 TypeSpecifier::TypeSpecifier(PrimitiveType::type primitive)
 {
+	setNodeType(this);
 	referred.unspecified = NULL;
 	update(primitive);
 }
 
 TypeSpecifier::TypeSpecifier(Identifier* unspecified)
 {
+	setNodeType(this);
 	referred.unspecified = NULL;
 	update(unspecified);
 }
@@ -116,7 +119,7 @@ bool TypeSpecifier::replaceUseWith(const ASTNode& from, const ASTNode& to, bool
 	END_REPLACE()
 }
 
-ASTNode* TypeSpecifier::clone() const
+ASTNode* TypeSpecifier::cloneImpl() const
 {
 	switch(type)
 	{
@@ -63,7 +63,7 @@ void ASTGraphvizNodeGenerator::addNode(ASTNode& node,
 	}
 	else
     {
-        stream << L"(" << std::dec << source_info->line << L":" << source_info->column << L")";
+        stream << L"(" << std::dec << source_info->line() << L":" << source_info->column() << L")";
     }
     stream << L"\"";
 
@@ -134,7 +134,7 @@ void ASTGraphvizNodeGenerator::label(Block& node)
 
 	if (source_info)
 	{
-        stream << L"(" << std::dec << source_info->line << L":" << source_info->column << L")";
+        stream << L"(" << std::dec << source_info->line() << L":" << source_info->column() << L")";
 	}
 
     if(node.is_pipelined_block)
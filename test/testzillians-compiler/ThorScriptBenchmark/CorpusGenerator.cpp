@@ -0,0 +1,139 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CorpusGenerator.h"
+#include <fstream>
+#include <sstream>
+
+namespace zillians { namespace language { namespace benchmark {
+
+namespace {
+
+static std::string className(unsigned package, unsigned klass)
+{
+	std::ostringstream name;
+	name << "P" << package << "C" << klass;
+	return name.str();
+}
+
+static std::string functionName(unsigned package, unsigned klass)
+{
+	std::ostringstream name;
+	name << "p" << package << "_c" << klass;
+	return name.str();
+}
+
+static void generateFile(const CorpusShape& shape, unsigned package, unsigned klass, std::ostream& out)
+{
+	const std::string name = className(package, klass);
+
+	for(unsigned i = (package > shape.import_depth) ? package - shape.import_depth : 0; i < package; ++i)
+		out << "import . = p" << i << ";\n";
+	out << "\n";
+
+	// a chain of templates, each one wrapping the previous one
+	for(unsigned d = 0; d < shape.template_depth; ++d)
+	{
+		out << "class " << name << "T" << d << "<T>\n{\n";
+		if(d == 0)
+			out << "\tpublic var value:T;\n";
+		else
+			out << "\tpublic var inner:" << name << "T" << d - 1 << "<T>;\n";
+		out << "}\n\n";
+	}
+
+	out << "class " << name << "\n{\n";
+	out << "\tpublic var value:int32;\n";
+
+	for(unsigned s = 1; s <= shape.overloads; ++s)
+	{
+		out << "\n\tpublic static function g(";
+		for(unsigned i = 0; i < s; ++i)
+			out << (i ? ", " : "") << "a" << i << ":int32";
+		out << ") : int32\n\t{\n\t\treturn a0";
+		for(unsigned i = 1; i < s; ++i)
+			out << " + a" << i;
+		out << ";\n\t}\n";
+	}
+
+	for(unsigned k = 0; k < shape.functions; ++k)
+	{
+		out << "\n\tpublic static function f" << k << "(a:int32) : int32\n\t{\n";
+		if(k == 0 && shape.template_depth > 0)
+			out << "\t\tvar t:" << name << "T" << shape.template_depth - 1 << "<int32>;\n";
+
+		out << "\t\treturn ";
+		if(shape.overloads > 0)
+		{
+			out << "g(a";
+			for(unsigned i = 1; i < k % shape.overloads + 1; ++i)
+				out << ", a";
+			out << ")";
+		}
+		else
+		{
+			out << "a";
+		}
+		if(k > 0)
+			out << " + f" << k - 1 << "(a)";
+		out << ";\n\t}\n";
+	}
+	out << "}\n\n";
+
+	// calls into every imported package
+	out << "function " << functionName(package, klass) << "(a:int32) : int32\n{\n";
+	out << "\tvar x:" << name << ";\n";
+	out << "\treturn a";
+	for(unsigned i = (package > shape.import_depth) ? package - shape.import_depth : 0; i < package; ++i)
+		out << " + " << functionName(i, klass) << "(a)";
+	out << ";\n}\n";
+}
+
+}
+
+std::size_t generateCorpus(const CorpusShape& shape, const boost::filesystem::path& root, std::vector<std::string>& files)
+{
+	std::size_t bytes = 0;
+
+	for(unsigned p = 0; p < shape.packages; ++p)
+	{
+		std::ostringstream package;
+		package << "p" << p;
+
+		boost::filesystem::path directory = root / "src" / package.str();
+		boost::filesystem::create_directories(directory);
+
+		for(unsigned c = 0; c < shape.classes; ++c)
+		{
+			std::ostringstream content;
+			generateFile(shape, p, c, content);
+
+			boost::filesystem::path file = directory / (className(p, c) + ".t");
+			std::ofstream out(file.string().c_str());
+			out << content.str();
+
+			bytes += content.str().size();
+			files.push_back(file.string());
+		}
+	}
+
+	return bytes;
+}
+
+} } }
@@ -0,0 +1,59 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_BENCHMARK_CORPUSGENERATOR_H_
+#define ZILLIANS_LANGUAGE_BENCHMARK_CORPUSGENERATOR_H_
+
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+
+namespace zillians { namespace language { namespace benchmark {
+
+/**
+ * Shape of a synthetic ThorScript project
+ *
+ * Every package is a directory under src/ with one file per class. Each file holds a chain of
+ * class templates template_depth deep (instantiated from the class), the class with its
+ * functions and an overload set, and a free function calling into the imported packages.
+ * Package i imports the import_depth packages before it, so the imports form a chain.
+ */
+struct CorpusShape
+{
+	CorpusShape() : packages(4), classes(8), functions(8), template_depth(3), overloads(4), import_depth(1)
+	{ }
+
+	unsigned packages;
+	unsigned classes;       // per package
+	unsigned functions;     // per class
+	unsigned template_depth;
+	unsigned overloads;     // size of the overload set in each class
+	unsigned import_depth;  // number of preceding packages imported by each package
+};
+
+/**
+ * Write the corpus under root (root/src/...), the generated files are appended to files
+ *
+ * @return total size of the generated sources in bytes
+ */
+std::size_t generateCorpus(const CorpusShape& shape, const boost::filesystem::path& root, std::vector<std::string>& files);
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_BENCHMARK_CORPUSGENERATOR_H_ */
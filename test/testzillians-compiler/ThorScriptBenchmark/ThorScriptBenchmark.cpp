@@ -0,0 +1,376 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * ts-bench generates a synthetic ThorScript project, compiles it in-process through the whole
+ * ThorScriptCompiler pipeline and reports wall time, allocations and memory usage of each stage
+ * as JSON, so that compiler throughput can be tracked over time. The emitted AST is then loaded
+ * again to time tree-level operations (see TreeBenchmark.h) on a realistic tree.
+ */
+
+#include "language/ThorScriptCompiler.h"
+#include "language/context/ParserContext.h"
+#include "language/stage/serialization/detail/ASTSerializationHelper.h"
+#include "CorpusGenerator.h"
+#include "TreeBenchmark.h"
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace zillians::language;
+
+//////////////////////////////////////////////////////////////////////////////
+// allocation accounting
+//////////////////////////////////////////////////////////////////////////////
+
+static std::atomic<std::size_t> allocation_count(0);
+static std::atomic<std::size_t> allocation_bytes(0);
+
+void* operator new(std::size_t size)
+{
+	++allocation_count;
+	allocation_bytes += size;
+
+	if(void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////
+// profiling
+//////////////////////////////////////////////////////////////////////////////
+
+static long currentRSS()
+{
+	long pages = 0, resident = 0;
+	std::ifstream statm("/proc/self/statm");
+	if(!(statm >> pages >> resident))
+		return 0;
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static long peakRSS()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss; // in kilobytes on Linux
+}
+
+struct Sample
+{
+	Sample() : wall_ms(0), allocations(0), allocated_bytes(0), rss_kb(0), peak_rss_kb(0), succeeded(false)
+	{ }
+
+	std::string name;
+	double wall_ms;
+	std::size_t allocations;
+	std::size_t allocated_bytes;
+	long rss_kb;       // after the stage
+	long peak_rss_kb;  // high-water mark of the process so far
+	bool succeeded;
+};
+
+class StageProfiler : public stage::StageConductor::Observer
+{
+public:
+	virtual void beforeExecute(stage::Stage& stage)
+	{
+		UNUSED_ARGUMENT(stage);
+
+		start_count = allocation_count;
+		start_bytes = allocation_bytes;
+		start_time = std::chrono::steady_clock::now();
+	}
+
+	virtual void afterExecute(stage::Stage& stage, bool succeeded)
+	{
+		Sample sample;
+		sample.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+		sample.allocations = allocation_count - start_count;
+		sample.allocated_bytes = allocation_bytes - start_bytes;
+		sample.name = stage.name();
+		sample.rss_kb = currentRSS();
+		sample.peak_rss_kb = peakRSS();
+		sample.succeeded = succeeded;
+		samples.push_back(sample);
+	}
+
+	std::vector<Sample> samples;
+
+private:
+	std::size_t start_count;
+	std::size_t start_bytes;
+	std::chrono::steady_clock::time_point start_time;
+};
+
+struct Run
+{
+	Run() : succeeded(false), wall_ms(0), allocations(0), allocated_bytes(0), peak_rss_kb(0)
+	{ }
+
+	bool succeeded;
+	double wall_ms;
+	std::size_t allocations;
+	std::size_t allocated_bytes;
+	long peak_rss_kb;
+	std::vector<Sample> stages;
+};
+
+static Run compile(const std::vector<std::string>& arguments)
+{
+	std::vector<const char*> argv;
+	argv.push_back("ts-compile");
+	for(std::size_t i = 0; i < arguments.size(); ++i)
+		argv.push_back(arguments[i].c_str());
+
+	StageProfiler profiler;
+	Run run;
+
+	std::size_t start_count = allocation_count;
+	std::size_t start_bytes = allocation_bytes;
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	{
+		// the parser stage creates a fresh context (and tangle) in the arena of this run
+		setParserContext(NULL);
+
+		ThorScriptCompiler compiler;
+		compiler.setObserver(&profiler);
+		run.succeeded = (compiler.main(argv.size(), &argv[0]) == 0);
+
+		setParserContext(NULL);
+	}
+	run.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+	run.allocations = allocation_count - start_count;
+	run.allocated_bytes = allocation_bytes - start_bytes;
+	run.peak_rss_kb = peakRSS();
+	run.stages = profiler.samples;
+
+	return run;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// report
+//////////////////////////////////////////////////////////////////////////////
+
+static std::string quote(const std::string& s)
+{
+	std::ostringstream out;
+	out << '"';
+	for(std::size_t i = 0; i < s.size(); ++i)
+	{
+		unsigned char c = s[i];
+		if(c == '"' || c == '\\')
+			out << '\\' << c;
+		else if(c < 0x20)
+			out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+		else
+			out << c;
+	}
+	out << '"';
+	return out.str();
+}
+
+static bool benchmarkTree(const std::string& ast_file, unsigned rounds, std::vector<benchmark::TreeSample>& samples)
+{
+	tree::ASTNodeGC arena;
+	tree::ASTNodeGC::Scope arena_scope(arena);
+
+	tree::ASTNode* root = stage::ASTSerializationHelper::deserialize(ast_file);
+	if(!root)
+		return false;
+
+	benchmark::benchmarkTree(*root, rounds, samples);
+	return true;
+}
+
+static void report(std::ostream& out, const benchmark::CorpusShape& shape, std::size_t files, std::size_t bytes, bool unfused, const std::vector<Run>& runs, const std::vector<benchmark::TreeSample>& tree_samples)
+{
+	out << std::fixed << std::setprecision(3);
+	out << "{\n";
+	out << "  \"corpus\": {"
+		<< "\"packages\": " << shape.packages
+		<< ", \"classes\": " << shape.classes
+		<< ", \"functions\": " << shape.functions
+		<< ", \"template_depth\": " << shape.template_depth
+		<< ", \"overloads\": " << shape.overloads
+		<< ", \"import_depth\": " << shape.import_depth
+		<< ", \"files\": " << files
+		<< ", \"bytes\": " << bytes << "},\n";
+	out << "  \"mode\": " << quote(unfused ? "unfused" : "default") << ",\n";
+	out << "  \"runs\": [\n";
+	for(std::size_t i = 0; i < runs.size(); ++i)
+	{
+		const Run& run = runs[i];
+		out << "    {\"succeeded\": " << (run.succeeded ? "true" : "false")
+			<< ", \"wall_ms\": " << run.wall_ms
+			<< ", \"allocations\": " << run.allocations
+			<< ", \"allocated_bytes\": " << run.allocated_bytes
+			<< ", \"peak_rss_kb\": " << run.peak_rss_kb
+			<< ", \"stages\": [\n";
+		for(std::size_t j = 0; j < run.stages.size(); ++j)
+		{
+			const Sample& sample = run.stages[j];
+			out << "      {\"name\": " << quote(sample.name)
+				<< ", \"succeeded\": " << (sample.succeeded ? "true" : "false")
+				<< ", \"wall_ms\": " << sample.wall_ms
+				<< ", \"allocations\": " << sample.allocations
+				<< ", \"allocated_bytes\": " << sample.allocated_bytes
+				<< ", \"rss_kb\": " << sample.rss_kb
+				<< ", \"peak_rss_kb\": " << sample.peak_rss_kb << "}"
+				<< (j + 1 < run.stages.size() ? ",\n" : "\n");
+		}
+		out << "    ]}" << (i + 1 < runs.size() ? ",\n" : "\n");
+	}
+	out << "  ],\n";
+	out << "  \"tree\": [\n";
+	for(std::size_t i = 0; i < tree_samples.size(); ++i)
+	{
+		const benchmark::TreeSample& sample = tree_samples[i];
+		out << "    {\"name\": " << quote(sample.name)
+			<< ", \"wall_ms\": " << sample.wall_ms
+			<< ", \"nodes\": " << sample.nodes << "}"
+			<< (i + 1 < tree_samples.size() ? ",\n" : "\n");
+	}
+	out << "  ]\n";
+	out << "}\n";
+}
+
+}
+
+int main(int argc, const char** argv)
+{
+	namespace po = boost::program_options;
+	namespace fs = boost::filesystem;
+
+	benchmark::CorpusShape shape;
+	unsigned repeat = 1;
+	unsigned tree_rounds = 10;
+
+	po::options_description options("Usage");
+	options.add_options()
+		("help,h", "show this help")
+		("packages", po::value<unsigned>(&shape.packages), "number of packages")
+		("classes", po::value<unsigned>(&shape.classes), "number of classes per package (one file each)")
+		("functions", po::value<unsigned>(&shape.functions), "number of functions per class")
+		("template-depth", po::value<unsigned>(&shape.template_depth), "depth of the class template chain in each file")
+		("overloads", po::value<unsigned>(&shape.overloads), "size of the overload set in each class")
+		("import-depth", po::value<unsigned>(&shape.import_depth), "number of preceding packages each package imports")
+		("repeat", po::value<unsigned>(&repeat), "number of compilations of the corpus")
+		("tree-rounds", po::value<unsigned>(&tree_rounds), "number of rounds of each tree-level operation on the emitted AST, 0 to skip them")
+		("unfused", "run every stage on its own instead of fusing them as the default mode does")
+		("work-dir", po::value<std::string>(), "where to generate the corpus (a temporary directory by default)")
+		("keep", "keep the generated corpus")
+		("output,o", po::value<std::string>(), "JSON report file (defaults to ts-bench.json, '-' for stdout)")
+		("compiler-option", po::value<std::vector<std::string>>(), "extra option passed to the compiler, e.g. --compiler-option=--parser-threads=1");
+
+	po::variables_map vm;
+	try
+	{
+		po::store(po::parse_command_line(argc, argv, options), vm);
+		po::notify(vm);
+	}
+	catch(const po::error& e)
+	{
+		std::cerr << "failed to parse command line: " << e.what() << std::endl;
+		std::cerr << options << std::endl;
+		return -1;
+	}
+
+	if(vm.count("help") > 0)
+	{
+		std::cout << options << std::endl;
+		return 0;
+	}
+
+	fs::path work_dir = vm.count("work-dir") ? fs::path(vm["work-dir"].as<std::string>()) : fs::temp_directory_path() / fs::unique_path("ts-bench-%%%%-%%%%");
+	work_dir = fs::absolute(work_dir);
+
+	std::vector<std::string> files;
+	std::size_t bytes = benchmark::generateCorpus(shape, work_dir, files);
+
+	std::vector<std::string> arguments(files);
+	arguments.push_back("--root-dir=" + (work_dir / "src").string());
+	arguments.push_back("--emit-llvm=" + (work_dir / "bench.bc").string());
+	arguments.push_back("--emit-ast=" + (work_dir / "bench.ast").string());
+	if(vm.count("unfused") > 0)
+		arguments.push_back("--mode-unfused");
+	if(vm.count("compiler-option") > 0)
+	{
+		const std::vector<std::string>& extra = vm["compiler-option"].as<std::vector<std::string>>();
+		arguments.insert(arguments.end(), extra.begin(), extra.end());
+	}
+
+	std::vector<Run> runs;
+	bool succeeded = true;
+	for(unsigned i = 0; i < repeat; ++i)
+	{
+		runs.push_back(compile(arguments));
+		succeeded = succeeded && runs.back().succeeded;
+	}
+
+	std::vector<benchmark::TreeSample> tree_samples;
+	if(succeeded && tree_rounds > 0)
+	{
+		succeeded = benchmarkTree((work_dir / "bench.ast").string(), tree_rounds, tree_samples);
+	}
+
+	if(vm.count("keep") == 0)
+		fs::remove_all(work_dir);
+
+	std::string output = vm.count("output") ? vm["output"].as<std::string>() : "ts-bench.json";
+	if(output == "-")
+	{
+		report(std::cout, shape, files.size(), bytes, vm.count("unfused") > 0, runs, tree_samples);
+	}
+	else
+	{
+		std::ofstream out(output.c_str());
+		report(out, shape, files.size(), bytes, vm.count("unfused") > 0, runs, tree_samples);
+	}
+
+	return succeeded ? 0 : 1;
+}
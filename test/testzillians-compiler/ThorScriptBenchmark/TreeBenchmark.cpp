@@ -0,0 +1,210 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/tree/ASTNodeHelper.h"
+#include "language/tree/NodeContextTable.h"
+#include "language/tree/visitor/GenericDoubleVisitor.h"
+#include "language/tree/visitor/GenericFusedVisitor.h"
+#include "language/tree/visitor/StaticVisitor.h"
+#include "language/tree/visitor/NodeInfoVisitor.h"
+#include "language/tree/visitor/ObjectCountVisitor.h"
+#include "TreeBenchmark.h"
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+namespace zillians { namespace language { namespace benchmark {
+
+using namespace tree;
+using namespace tree::visitor;
+
+namespace {
+
+struct StaticObjectCountVisitor : StaticDoubleVisitor<StaticObjectCountVisitor>
+{
+	StaticObjectCountVisitor() : total_count(0L)
+	{ }
+
+	void apply(ASTNode& node)
+	{
+		++total_count;
+		revisit(node);
+	}
+
+	std::size_t total_count;
+};
+
+// a small context like SourceInfoContext, attached through either ContextHub or NodeContextTable
+struct BenchmarkContext
+{
+	explicit BenchmarkContext(uint32 value) : value(value)
+	{ }
+
+	uint32 value;
+};
+
+void measure(const std::string& name, unsigned rounds, std::vector<TreeSample>& samples, const std::function<std::size_t()>& round)
+{
+	TreeSample sample;
+	sample.name = name;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(unsigned r = 0; r < rounds; ++r)
+		sample.nodes = round();
+	sample.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	samples.push_back(sample);
+}
+
+}
+
+void benchmarkTree(ASTNode& root, unsigned rounds, std::vector<TreeSample>& samples)
+{
+	// full traversal, runtime (GenericDoubleVisitor) against switch (StaticDoubleVisitor) dispatch
+	measure("traversal/runtime", rounds, samples, [&]() -> std::size_t {
+		ObjectCountVisitor<> counter;
+		counter.visit(root);
+		return counter.get_count();
+	});
+	measure("traversal/static", rounds, samples, [&]() -> std::size_t {
+		StaticObjectCountVisitor counter;
+		counter.visit(root);
+		return counter.total_count;
+	});
+	std::size_t node_count = samples.back().nodes;
+
+	// three visitors over the tree, one walk each against a single fused walk (GenericFusedVisitor)
+	measure("fusion/separate", rounds, samples, [&]() -> std::size_t {
+		ObjectCountVisitor<> counter1, counter2, counter3;
+		counter1.visit(root);
+		counter2.visit(root);
+		counter3.visit(root);
+		return counter1.get_count() + counter2.get_count() + counter3.get_count();
+	});
+	measure("fusion/fused", rounds, samples, [&]() -> std::size_t {
+		ObjectCountVisitor<> counter1, counter2, counter3;
+		{
+			GenericFusedVisitor fused;
+			fused.addFollower(counter1);
+			fused.addFollower(counter2);
+			fused.addFollower(counter3);
+			fused.visit(root);
+		}
+		return counter1.get_count() + counter2.get_count() + counter3.get_count();
+	});
+
+	// construction of one short-lived visitor per node, as the resolver does with NodeInfoVisitor
+	measure("construction/runtime", rounds, samples, [&]() -> std::size_t {
+		for(std::size_t i = 0; i < node_count; ++i)
+		{
+			ObjectCountVisitor<> counter;
+			UNUSED_ARGUMENT(counter);
+		}
+		return node_count;
+	});
+	measure("construction/static", rounds, samples, [&]() -> std::size_t {
+		for(std::size_t i = 0; i < node_count; ++i)
+		{
+			NodeInfoVisitor info;
+			UNUSED_ARGUMENT(info);
+		}
+		return node_count;
+	});
+
+	// context set and get, ContextHub against NodeContextTable
+	std::vector<ASTNode*> nodes;
+	ASTNodeHelper::foreachApply<ASTNode>(root, [&](ASTNode& node) {
+		nodes.push_back(&node);
+	});
+
+	measure("context-set/hub", rounds, samples, [&]() -> std::size_t {
+		for(std::size_t i = 0; i < nodes.size(); ++i)
+			nodes[i]->set<BenchmarkContext>(new BenchmarkContext(i));
+		return nodes.size();
+	});
+	measure("context-set/table", rounds, samples, [&]() -> std::size_t {
+		for(std::size_t i = 0; i < nodes.size(); ++i)
+			NodeContextTable<BenchmarkContext>::assign(nodes[i], BenchmarkContext(i));
+		return nodes.size();
+	});
+
+	uint64 hub_sum = 0;
+	uint64 table_sum = 0;
+	measure("context-get/hub", rounds, samples, [&]() -> std::size_t {
+		for(std::size_t i = 0; i < nodes.size(); ++i)
+			hub_sum += nodes[i]->get<BenchmarkContext>()->value;
+		return nodes.size();
+	});
+	measure("context-get/table", rounds, samples, [&]() -> std::size_t {
+		for(std::size_t i = 0; i < nodes.size(); ++i)
+			table_sum += NodeContextTable<BenchmarkContext>::get(nodes[i])->value;
+		return nodes.size();
+	});
+
+	if(hub_sum != table_sum)
+		std::cerr << "context-get: ContextHub and NodeContextTable disagree" << std::endl;
+
+	// clone with contexts, copied by the clone hook against collecting both trees and copying by index
+	typedef tree::detail::ContextCloneImpl<boost::mpl::size<tree::detail::ContextToCloneTypeList>::value, tree::detail::ContextToCloneTypeList> CloneImpl;
+
+	measure("clone/hook", rounds, samples, [&]() -> std::size_t {
+		ASTNodeHelper::clone(&root);
+		return nodes.size();
+	});
+	measure("clone/collect", rounds, samples, [&]() -> std::size_t {
+		ASTNode* cloned = root.clone();
+		std::vector<ASTNode*> from_nodes;
+		std::vector<ASTNode*> to_nodes;
+		ASTNodeHelper::foreachApply<ASTNode>(root, [&](ASTNode& node) {
+			from_nodes.push_back(&node);
+		});
+		ASTNodeHelper::foreachApply<ASTNode>(*cloned, [&](ASTNode& node) {
+			to_nodes.push_back(&node);
+		});
+		for(std::size_t i = 0; i < from_nodes.size(); ++i)
+			CloneImpl::clone(from_nodes[i], to_nodes[i]);
+		return from_nodes.size();
+	});
+
+	// walk of a tangle with all sources but the first one imported, all sources against the active
+	// ones only (as per-source stages walk)
+	if(isa<Tangle>(&root))
+	{
+		Tangle& tangle = *cast<Tangle>(&root);
+		tangle.markImported(true);
+		if(!tangle.sources.empty())
+			tangle.sources.begin()->second->markImported(false);
+
+		measure("walk/all-sources", rounds, samples, [&]() -> std::size_t {
+			ObjectCountVisitor<> counter;
+			counter.visit(root);
+			return counter.get_count();
+		});
+		measure("walk/active-sources", rounds, samples, [&]() -> std::size_t {
+			ObjectCountVisitor<> counter;
+			counter.setActiveSourcesOnly(true);
+			counter.visit(root);
+			return counter.get_count();
+		});
+
+		tangle.markImported(false);
+	}
+}
+
+} } }
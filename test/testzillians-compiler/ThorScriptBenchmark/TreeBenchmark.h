@@ -0,0 +1,49 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ZILLIANS_LANGUAGE_BENCHMARK_TREEBENCHMARK_H_
+#define ZILLIANS_LANGUAGE_BENCHMARK_TREEBENCHMARK_H_
+
+#include "language/tree/ASTNode.h"
+#include <string>
+#include <vector>
+
+namespace zillians { namespace language { namespace benchmark {
+
+struct TreeSample
+{
+	TreeSample() : wall_ms(0), nodes(0)
+	{ }
+
+	std::string name;
+	double wall_ms;     // over all rounds
+	std::size_t nodes;  // touched per round
+};
+
+/**
+ * Time tree-level operations (traversal, visitor construction, contexts, ...) on a compiled tree
+ *
+ * Each operation is repeated the given number of rounds; alternative implementations of the
+ * same operation are named "<operation>/<implementation>" so that they can be compared.
+ */
+void benchmarkTree(tree::ASTNode& root, unsigned rounds, std::vector<TreeSample>& samples);
+
+} } }
+
+#endif /* ZILLIANS_LANGUAGE_BENCHMARK_TREEBENCHMARK_H_ */
@@ -0,0 +1,149 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/stage/dep/ThorScriptDepDatabase.h"
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE ThorScriptDepTest_ThorScriptDepDatabaseTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using zillians::language::stage::ThorScriptDepDatabase;
+using zillians::language::stage::ThorScriptImportScanner;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptDepTest_ThorScriptDepDatabaseTestSuite )
+
+static void writeFile(const std::string& filename, const std::string& content)
+{
+    std::ofstream fout(filename.c_str());
+    fout << content;
+}
+
+static std::vector<std::wstring> importsOf(ThorScriptDepDatabase& database, const std::string& filename)
+{
+    std::vector<ThorScriptImportScanner::Result> results;
+    database.scanImports(std::vector<std::string>(1, filename), 1, results);
+    BOOST_CHECK(results[0].succeeded);
+    return results[0].packages;
+}
+
+/**
+ * Test records surviving a save and load, and changes made right after a run being noticed
+ */
+BOOST_AUTO_TEST_CASE( ThorScriptDepTest_ThorScriptDepDatabaseTestCase1 )
+{
+    boost::filesystem::remove_all("depdb");
+    boost::filesystem::create_directories("depdb/src/b");
+    writeFile("depdb/src/a.t", "import b;\n");
+    writeFile("depdb/src/b/b1.t", "import a;\n");
+    writeFile("depdb/src/b/notes.txt", "not a source\n");
+
+    {
+        ThorScriptDepDatabase database("depdb/build/ts.depdb");
+        BOOST_CHECK(!database.load());
+
+        std::set<std::string> files = database.globTsFiles("depdb/src");
+        BOOST_CHECK_EQUAL(files.size(), 2);
+        BOOST_CHECK(files.count("depdb/src/a.t"));
+        BOOST_CHECK(files.count("depdb/src/b/b1.t"));
+
+        std::vector<std::wstring> imports = importsOf(database, "depdb/src/a.t");
+        BOOST_CHECK_EQUAL(imports.size(), 1);
+        BOOST_CHECK(imports[0] == L"b");
+
+        database.edges["depdb/src/a.t"].insert("depdb/src/b/b1.t");
+        BOOST_CHECK(database.save());
+    }
+
+    // same size and most likely the same second, the content hash tells the difference
+    writeFile("depdb/src/a.t", "import c;\n");
+    writeFile("depdb/src/b/b2.t", "\n");
+
+    {
+        ThorScriptDepDatabase database("depdb/build/ts.depdb");
+        BOOST_CHECK(database.load());
+        BOOST_CHECK_EQUAL(database.edges.size(), 1);
+
+        std::set<std::string> files = database.globTsFiles("depdb/src");
+        BOOST_CHECK_EQUAL(files.size(), 3);
+        BOOST_CHECK(files.count("depdb/src/b/b2.t"));
+
+        std::vector<std::wstring> imports = importsOf(database, "depdb/src/a.t");
+        BOOST_CHECK_EQUAL(imports.size(), 1);
+        BOOST_CHECK(imports[0] == L"c");
+        BOOST_CHECK(database.save());
+    }
+
+    boost::filesystem::remove_all("depdb/src/b");
+
+    {
+        ThorScriptDepDatabase database("depdb/build/ts.depdb");
+        BOOST_CHECK(database.load());
+
+        std::set<std::string> files = database.globTsFiles("depdb/src");
+        BOOST_CHECK_EQUAL(files.size(), 1);
+        BOOST_CHECK(files.count("depdb/src/a.t"));
+        BOOST_CHECK(importsOf(database, "depdb/src/a.t")[0] == L"c");
+    }
+
+    boost::filesystem::remove_all("depdb");
+}
+
+/**
+ * Test failures not being remembered and broken databases being ignored
+ */
+BOOST_AUTO_TEST_CASE( ThorScriptDepTest_ThorScriptDepDatabaseTestCase2 )
+{
+    boost::filesystem::remove_all("depdb");
+    boost::filesystem::create_directories("depdb/src");
+    boost::filesystem::create_directories("depdb/build");
+    writeFile("depdb/src/a.t", "import ;\n");
+    writeFile("depdb/build/ts.depdb", "garbage");
+
+    ThorScriptDepDatabase database("depdb/build/ts.depdb");
+    BOOST_CHECK(!database.load());
+
+    std::vector<ThorScriptImportScanner::Result> results;
+    std::vector<std::string> filenames;
+    filenames.push_back("depdb/src/a.t");
+    filenames.push_back("depdb/src/missing.t");
+    database.scanImports(filenames, 2, results);
+    BOOST_CHECK(!results[0].succeeded);
+    BOOST_CHECK(!results[1].succeeded);
+
+    writeFile("depdb/src/a.t", "import a;\n");
+    BOOST_CHECK(importsOf(database, "depdb/src/a.t")[0] == L"a");
+
+    std::string hash = database.hashOf("depdb/src/a.t");
+    BOOST_CHECK(!hash.empty());
+    writeFile("depdb/src/a.t", "import b;\n");
+    BOOST_CHECK(database.hashOf("depdb/src/a.t") != hash);
+    BOOST_CHECK(database.hashOf("depdb/src/missing.t").empty());
+
+    std::vector<std::wstring> packages;
+    BOOST_CHECK(!database.findBundle("depdb/build/missing.ast", packages));
+
+    boost::filesystem::remove_all("depdb");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "language/stage/dep/ThorScriptImportScanner.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE ThorScriptDepTest_ThorScriptImportScannerTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using zillians::language::stage::ThorScriptImportScanner;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptDepTest_ThorScriptImportScannerTestSuite )
+
+static bool scan(const std::string& content, std::vector<std::wstring>& packages)
+{
+    return ThorScriptImportScanner::scanBuffer(content.data(), content.data() + content.size(), packages);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptDepTest_ThorScriptImportScannerTestCase1 )
+{
+    std::vector<std::wstring> packages;
+    BOOST_CHECK(scan("\xEF\xBB\xBF// header\n"
+                     "/* multi-line\n comment */ import a.b.c;\n"
+                     "import x = d . e;\n"
+                     "import . = f;\n"
+                     "import g;\n"
+                     "class A { }\n"
+                     "import h;\n", packages));
+
+    BOOST_CHECK_EQUAL(packages.size(), 4);
+    BOOST_CHECK(packages[0] == L"a.b.c");
+    BOOST_CHECK(packages[1] == L"d.e");
+    BOOST_CHECK(packages[2] == L"f");
+    BOOST_CHECK(packages[3] == L"g");
+}
+
+/**
+ * Test malformed imports
+ */
+BOOST_AUTO_TEST_CASE( ThorScriptDepTest_ThorScriptImportScannerTestCase2 )
+{
+    std::vector<std::wstring> packages;
+    BOOST_CHECK(!scan("import a.b = c;", packages));
+    BOOST_CHECK(!scan("import a", packages));
+    BOOST_CHECK(!scan("import ;", packages));
+    BOOST_CHECK(!scan("/* unterminated", packages));
+
+    packages.clear();
+    BOOST_CHECK(scan("importer;", packages));
+    BOOST_CHECK(packages.empty());
+}
+
+/**
+ * Test scanning files on several threads, with imports spanning many read chunks
+ */
+BOOST_AUTO_TEST_CASE( ThorScriptDepTest_ThorScriptImportScannerTestCase3 )
+{
+    {
+        std::ofstream fout("imports.t");
+        for(int i = 0; i < 1000; ++i)
+            fout << "import p" << i << "; // comment\n";
+        fout << "function f() : void { }\n";
+    }
+
+    std::vector<std::string> filenames(16, "imports.t");
+    filenames.push_back("no-such-file.t");
+
+    std::vector<ThorScriptImportScanner::Result> results;
+    ThorScriptImportScanner::scanFiles(filenames, 4, results);
+
+    BOOST_CHECK_EQUAL(results.size(), filenames.size());
+    for(std::size_t i = 0; i < 16; ++i)
+    {
+        BOOST_CHECK(results[i].succeeded);
+        BOOST_CHECK_EQUAL(results[i].packages.size(), 1000);
+        BOOST_CHECK(results[i].packages.back() == L"p999");
+    }
+    BOOST_CHECK(!results.back().succeeded);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
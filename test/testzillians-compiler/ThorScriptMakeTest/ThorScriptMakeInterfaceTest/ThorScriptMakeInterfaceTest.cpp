@@ -0,0 +1,124 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "utility/Foreach.h"
+#include "language/CompilationSession.h"
+#include "language/ThorScriptCompiler.h"
+#include "language/stage/serialization/detail/ASTSerializationHelper.h"
+#include "../../ThorScriptBenchmark/CorpusGenerator.h"
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#define BOOST_TEST_MODULE ThorScriptMakeTest_ThorScriptMakeInterfaceTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language;
+
+namespace fs = boost::filesystem;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptMakeTest_ThorScriptMakeInterfaceTestSuite )
+
+static int compile(const std::vector<std::string>& arguments)
+{
+	std::vector<const char*> argv;
+	argv.push_back("ts-compile");
+	foreach(i, arguments)
+		argv.push_back(i->c_str());
+
+	CompilationSession session;
+	ThorScriptCompiler compiler;
+	compiler.setSession(&session);
+	return compiler.main(argv.size(), &argv[0]);
+}
+
+static void replaceInFile(const std::string& filename, const std::string& from, const std::string& to)
+{
+	std::string content;
+	{
+		std::ifstream in(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+		content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	BOOST_REQUIRE(content.find(from) != std::string::npos);
+	boost::algorithm::replace_first(content, from, to);
+
+	std::ofstream out(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+	out << content;
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptMakeTest_ThorScriptMakeInterfaceTestCase1 )
+{
+	fs::path root = fs::temp_directory_path() / fs::unique_path("ts-interface-%%%%-%%%%");
+
+	// p2 imports p1 which imports p0, each is compiled as a tangle of its own against the AST of
+	// its direct dependency, as ts-make does
+	benchmark::CorpusShape shape;
+	shape.packages = 3;
+	shape.classes = 1;
+	shape.functions = 2;
+
+	std::vector<std::string> files;
+	benchmark::generateCorpus(shape, root, files);
+	BOOST_REQUIRE_EQUAL(files.size(), 3);
+
+	auto interfaces = [&]() -> std::vector<std::string> {
+		std::vector<std::string> result;
+		for(std::size_t i = 0; i < files.size(); ++i)
+		{
+			std::string tangle = "p" + boost::lexical_cast<std::string>(i);
+			std::vector<std::string> arguments(1, files[i]);
+			arguments.push_back("--root-dir=" + (root / "src").string());
+			if(i > 0)
+				arguments.push_back("--load-ast=" + (root / ("p" + boost::lexical_cast<std::string>(i - 1) + ".ast")).string());
+			arguments.push_back("--emit-llvm=" + (root / (tangle + ".bc")).string());
+			arguments.push_back("--emit-ast=" + (root / (tangle + ".ast")).string());
+			BOOST_REQUIRE_EQUAL(compile(arguments), 0);
+
+			result.push_back(stage::ASTSerializationHelper::readInterfaceFingerprint((root / (tangle + ".ast")).string()));
+			BOOST_REQUIRE(!result.back().empty());
+		}
+		return result;
+	};
+
+	std::vector<std::string> original = interfaces();
+
+	// compiling the same sources again gives the same interfaces
+	BOOST_CHECK(interfaces() == original);
+
+	// a changed function body of p0 isn't seen by p1 and p2
+	replaceInFile(files[0], "\treturn a;\n}\n", "\treturn a + 1;\n}\n");
+	BOOST_CHECK(interfaces() == original);
+
+	// a changed class layout of p0 changes the interface of p0, and through it the ones of p1
+	// and p2, although neither of their trees changed
+	replaceInFile(files[0], "class P0C0\n{\n", "class P0C0\n{\n\tpublic var extra:int32;\n");
+	std::vector<std::string> changed = interfaces();
+	for(std::size_t i = 0; i < files.size(); ++i)
+		BOOST_CHECK(changed[i] != original[i]);
+
+	fs::remove_all(root);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,154 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "utility/Foreach.h"
+#include "language/CompilationSession.h"
+#include "language/ThorScriptCompiler.h"
+#include "language/tree/ASTNodeHelper.h"
+#include "language/stage/serialization/detail/ASTSerializationHelper.h"
+#include "language/stage/transformer/context/ManglingStageContext.h"
+#include "../../ThorScriptBenchmark/CorpusGenerator.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <string>
+
+#define BOOST_TEST_MODULE ThorScriptMakeTest_ThorScriptMakeManglingIdTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language;
+
+namespace fs = boost::filesystem;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptMakeTest_ThorScriptMakeManglingIdTestSuite )
+
+static int compile(const std::vector<std::string>& arguments)
+{
+	std::vector<const char*> argv;
+	argv.push_back("ts-compile");
+	foreach(i, arguments)
+		argv.push_back(i->c_str());
+
+	CompilationSession session;
+	ThorScriptCompiler compiler;
+	compiler.setSession(&session);
+	return compiler.main(argv.size(), &argv[0]);
+}
+
+struct MangledIds
+{
+	MangledIds() : type_ids(0), symbol_ids(0)
+	{ }
+
+	std::size_t type_ids;
+	std::size_t symbol_ids;
+	std::set<uint64> distinct_type_ids;
+	std::set<uint64> distinct_symbol_ids;
+	tree::Tangle::MangledIds recorded;
+};
+
+static MangledIds collectIds(const fs::path& ast_file)
+{
+	CompilationSession session;
+	CompilationSession::Scope scope(session);
+
+	MangledIds ids;
+	tree::ASTNode* tangle = stage::ASTSerializationHelper::deserialize(ast_file.string());
+	BOOST_REQUIRE(tangle != NULL && tree::isa<tree::Tangle>(tangle));
+	ids.recorded = tree::cast<tree::Tangle>(tangle)->mangled_ids;
+
+	tree::ASTNodeHelper::foreachApply<tree::Declaration>(*tangle, [&](tree::Declaration& decl) {
+		if(stage::TypeIdManglingContext* type_id = stage::TypeIdManglingContext::get(&decl))
+		{
+			++ids.type_ids;
+			ids.distinct_type_ids.insert(type_id->managled_id);
+		}
+		if(stage::SymbolIdManglingContext* symbol_id = stage::SymbolIdManglingContext::get(&decl))
+		{
+			++ids.symbol_ids;
+			ids.distinct_symbol_ids.insert(symbol_id->managled_id);
+		}
+	});
+	return ids;
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptMakeTest_ThorScriptMakeManglingIdTestCase1 )
+{
+	fs::path root = fs::temp_directory_path() / fs::unique_path("ts-mangling-id-%%%%-%%%%");
+
+	// package p1 imports p0, each is compiled as a tangle of its own
+	benchmark::CorpusShape shape;
+	shape.packages = 2;
+	shape.classes = 2;
+	shape.functions = 2;
+
+	std::vector<std::string> files;
+	benchmark::generateCorpus(shape, root, files);
+	BOOST_REQUIRE_EQUAL(files.size(), 4);
+
+	std::vector<std::string> library(files.begin(), files.begin() + 2);
+	library.push_back("--root-dir=" + (root / "src").string());
+	library.push_back("--emit-llvm=" + (root / "p0.bc").string());
+	library.push_back("--emit-ast=" + (root / "p0.ast").string());
+	BOOST_REQUIRE_EQUAL(compile(library), 0);
+
+	std::vector<std::string> dependent(files.begin() + 2, files.end());
+	dependent.push_back("--root-dir=" + (root / "src").string());
+	dependent.push_back("--load-ast=" + (root / "p0.ast").string());
+	dependent.push_back("--emit-llvm=" + (root / "p1.bc").string());
+	dependent.push_back("--emit-ast=" + (root / "p1.ast").string());
+	BOOST_REQUIRE_EQUAL(compile(dependent), 0);
+
+	// imported sources aren't serialized again, each AST holds the declarations of its own tangle
+	MangledIds imported = collectIds(root / "p0.ast");
+	MangledIds own = collectIds(root / "p1.ast");
+
+	BOOST_CHECK(imported.type_ids > 0 && own.type_ids > 0);
+	BOOST_CHECK(imported.symbol_ids > 0 && own.symbol_ids > 0);
+	BOOST_CHECK_EQUAL(imported.distinct_type_ids.size(), imported.type_ids);
+	BOOST_CHECK_EQUAL(imported.distinct_symbol_ids.size(), imported.symbol_ids);
+	BOOST_CHECK_EQUAL(own.distinct_type_ids.size(), own.type_ids);
+	BOOST_CHECK_EQUAL(own.distinct_symbol_ids.size(), own.symbol_ids);
+
+	// and the ids handed out to the dependent tangle must not be used by the imported one
+	std::vector<uint64> shared;
+	std::set_intersection(imported.distinct_type_ids.begin(), imported.distinct_type_ids.end(), own.distinct_type_ids.begin(), own.distinct_type_ids.end(), std::back_inserter(shared));
+	std::set_intersection(imported.distinct_symbol_ids.begin(), imported.distinct_symbol_ids.end(), own.distinct_symbol_ids.begin(), own.distinct_symbol_ids.end(), std::back_inserter(shared));
+	BOOST_CHECK(shared.empty());
+
+	// the ranges recorded in the ASTs hold the ids, the dependent one starts past the imported one
+	BOOST_CHECK(!imported.recorded.overlaps(own.recorded));
+	BOOST_CHECK(own.recorded.first_type_id >= imported.recorded.next_type_id);
+	BOOST_CHECK(own.recorded.first_symbol_id >= imported.recorded.next_symbol_id);
+	const MangledIds* tangles[] = { &imported, &own };
+	for(std::size_t i = 0; i < 2; ++i)
+	{
+		const MangledIds& ids = *tangles[i];
+		BOOST_CHECK(*ids.distinct_type_ids.begin() >= ids.recorded.first_type_id && *ids.distinct_type_ids.rbegin() < ids.recorded.next_type_id);
+		BOOST_CHECK(*ids.distinct_symbol_ids.begin() >= ids.recorded.first_symbol_id && *ids.distinct_symbol_ids.rbegin() < ids.recorded.next_symbol_id);
+	}
+
+	fs::remove_all(root);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/stage/make/ThorScriptMakeScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#define BOOST_TEST_MODULE ThorScriptMakeTest_ThorScriptMakeSchedulerTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians::language::stage;
+
+typedef ThorScriptMakeScheduler::Vertex Vertex;
+typedef ThorScriptMakeScheduler::JobState JobState;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptMakeTest_ThorScriptMakeSchedulerTestSuite )
+
+// a depends on b, b depends on c, d stands alone
+struct ChainGraph
+{
+    ChainGraph() : a(boost::add_vertex(g)), b(boost::add_vertex(g)), c(boost::add_vertex(g)), d(boost::add_vertex(g))
+    {
+        boost::add_edge(a, b, g);
+        boost::add_edge(b, c, g);
+    }
+
+    TangleGraphType g;
+    Vertex a, b, c, d;
+};
+
+BOOST_AUTO_TEST_CASE( ThorScriptMakeTest_ThorScriptMakeSchedulerTestCase1 )
+{
+    ChainGraph chain;
+
+    // the chain c-b-a takes 3, so c goes before d alone taking 1.5, and b still does after that
+    {
+        std::vector<double> costs = { 1.0, 1.0, 1.0, 1.5 };
+        ThorScriptMakeScheduler scheduler(chain.g, costs);
+        BOOST_CHECK_EQUAL(scheduler.priority(chain.a), 1.0);
+        BOOST_CHECK_EQUAL(scheduler.priority(chain.b), 2.0);
+        BOOST_CHECK_EQUAL(scheduler.priority(chain.c), 3.0);
+        BOOST_CHECK_EQUAL(scheduler.priority(chain.d), 1.5);
+
+        std::vector<Vertex> order;
+        BOOST_CHECK(scheduler.run(1, [&](Vertex v) { order.push_back(v); return 0; }));
+        std::vector<Vertex> expected = { chain.c, chain.b, chain.d, chain.a };
+        BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+    }
+
+    // but d taking 5 is the critical path
+    {
+        std::vector<double> costs = { 1.0, 1.0, 1.0, 5.0 };
+        ThorScriptMakeScheduler scheduler(chain.g, costs);
+
+        std::vector<Vertex> order;
+        BOOST_CHECK(scheduler.run(1, [&](Vertex v) { order.push_back(v); return 0; }));
+        std::vector<Vertex> expected = { chain.d, chain.c, chain.b, chain.a };
+        BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptMakeTest_ThorScriptMakeSchedulerTestCase2 )
+{
+    ChainGraph chain;
+    std::vector<double> costs = { 1.0, 1.0, 1.0, 2.0 };
+    ThorScriptMakeScheduler scheduler(chain.g, costs);
+
+    // c fails first, so neither its dependents nor the pending d are started
+    std::vector<Vertex> order;
+    BOOST_CHECK(!scheduler.run(1, [&](Vertex v) { order.push_back(v); return v == chain.c ? 1 : 0; }));
+    BOOST_CHECK_EQUAL(order.size(), 1u);
+    BOOST_CHECK(scheduler.state(chain.c) == JobState::FAILED);
+    BOOST_CHECK(scheduler.state(chain.b) == JobState::CANCELLED);
+    BOOST_CHECK(scheduler.state(chain.a) == JobState::CANCELLED);
+    BOOST_CHECK(scheduler.state(chain.d) == JobState::CANCELLED);
+
+    // a throwing job counts as failed as well
+    BOOST_CHECK(!scheduler.run(2, [&](Vertex v) -> int { if(v == chain.b) throw std::runtime_error("b"); return 0; }));
+    BOOST_CHECK(scheduler.state(chain.c) == JobState::SUCCEEDED);
+    BOOST_CHECK(scheduler.state(chain.b) == JobState::FAILED);
+    BOOST_CHECK(scheduler.state(chain.a) == JobState::CANCELLED);
+
+    // and so does one throwing anything else
+    BOOST_CHECK(!scheduler.run(2, [&](Vertex v) -> int { if(v == chain.c) throw 42; return 0; }));
+    BOOST_CHECK(scheduler.state(chain.c) == JobState::FAILED);
+    BOOST_CHECK(scheduler.state(chain.b) == JobState::CANCELLED);
+    BOOST_CHECK(scheduler.state(chain.a) == JobState::CANCELLED);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptMakeTest_ThorScriptMakeSchedulerTestCase3 )
+{
+    // a layer of independent tangles under a single one depending on all of them
+    TangleGraphType g;
+    Vertex top = boost::add_vertex(g);
+    for(int i = 0; i < 16; ++i)
+    {
+        boost::add_edge(top, boost::add_vertex(g), g);
+    }
+    ThorScriptMakeScheduler scheduler(g, std::vector<double>(boost::num_vertices(g), 1.0));
+
+    std::mutex mutex;
+    std::size_t finished = 0;
+    std::atomic<int> running(0);
+    std::atomic<int> peak(0);
+    bool top_was_last = false;
+
+    BOOST_CHECK(scheduler.run(3, [&](Vertex v) {
+        int now = ++running;
+        for(int seen = peak; now > seen && !peak.compare_exchange_weak(seen, now); ) { }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        --running;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if(v == top)
+            top_was_last = (finished == boost::num_vertices(g) - 1);
+        ++finished;
+        return 0;
+    }));
+
+    BOOST_CHECK(top_was_last);
+    BOOST_CHECK_EQUAL(finished, boost::num_vertices(g));
+    BOOST_CHECK(peak <= 3);
+    BOOST_CHECK(peak > 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
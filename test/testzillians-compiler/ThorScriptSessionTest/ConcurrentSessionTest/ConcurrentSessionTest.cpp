@@ -0,0 +1,120 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "utility/Foreach.h"
+#include "language/CompilationSession.h"
+#include "language/ThorScriptCompiler.h"
+#include "../../ThorScriptBenchmark/CorpusGenerator.h"
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <llvm/Support/Threading.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#define BOOST_TEST_MODULE ThorScriptSessionTest_ConcurrentSessionTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language;
+
+namespace fs = boost::filesystem;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptSessionTest_ConcurrentSessionTestSuite )
+
+static int compile(const std::vector<std::string>& arguments)
+{
+	std::vector<const char*> argv;
+	argv.push_back("ts-compile");
+	foreach(i, arguments)
+		argv.push_back(i->c_str());
+
+	CompilationSession session;
+	ThorScriptCompiler compiler;
+	compiler.setSession(&session);
+	return compiler.main(argv.size(), &argv[0]);
+}
+
+static std::string readFile(const fs::path& p)
+{
+	std::ifstream in(p.string().c_str(), std::ios_base::in | std::ios_base::binary);
+	return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptSessionTest_ConcurrentSessionTestCase1 )
+{
+	const unsigned compilations = 4;
+
+	llvm::llvm_start_multithreaded();
+
+	fs::path root = fs::temp_directory_path() / fs::unique_path("ts-session-%%%%-%%%%");
+
+	// projects of different shapes, so a compilation picking up state of another one shows in its outputs
+	std::vector<std::vector<std::string>> inputs(compilations);
+	for(unsigned i = 0; i < compilations; ++i)
+	{
+		benchmark::CorpusShape shape;
+		shape.packages = 2 + i;
+		shape.classes = 2;
+		shape.functions = 2;
+
+		fs::path project = root / ("project" + boost::lexical_cast<std::string>(i));
+		benchmark::generateCorpus(shape, project, inputs[i]);
+		inputs[i].push_back("--root-dir=" + (project / "src").string());
+		inputs[i].push_back("--parser-threads=1");
+	}
+
+	auto arguments = [&](unsigned i, const std::string& run) -> std::vector<std::string> {
+		std::vector<std::string> result(inputs[i]);
+		result.push_back("--emit-llvm=" + (root / (run + boost::lexical_cast<std::string>(i) + ".bc")).string());
+		result.push_back("--emit-ast=" + (root / (run + boost::lexical_cast<std::string>(i) + ".ast")).string());
+		return result;
+	};
+
+	for(unsigned i = 0; i < compilations; ++i)
+		BOOST_REQUIRE_EQUAL(compile(arguments(i, "sequential")), 0);
+
+	std::vector<int> results(compilations, -1);
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < compilations; ++i)
+		threads.push_back(std::thread([&, i]() { results[i] = compile(arguments(i, "concurrent")); }));
+	foreach(i, threads)
+		i->join();
+
+	for(unsigned i = 0; i < compilations; ++i)
+	{
+		BOOST_CHECK_EQUAL(results[i], 0);
+
+		const char* extensions[] = { ".bc", ".ast" };
+		for(std::size_t j = 0; j < 2; ++j)
+		{
+			std::string sequential = readFile(root / ("sequential" + boost::lexical_cast<std::string>(i) + extensions[j]));
+			std::string concurrent = readFile(root / ("concurrent" + boost::lexical_cast<std::string>(i) + extensions[j]));
+			BOOST_CHECK(!sequential.empty());
+			BOOST_CHECK(sequential == concurrent);
+		}
+	}
+
+	fs::remove_all(root);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,196 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNode.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/tree/visitor/GenericDoubleVisitor.h"
+#include "language/tree/visitor/StaticVisitor.h"
+#include "language/tree/visitor/ObjectCountVisitor.h"
+#include "../ASTNodeSamples.h"
+#include <set>
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_ActiveSourceTraversalTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language::tree;
+using namespace zillians::language::tree::visitor;
+
+namespace {
+
+struct RecordVisitor : public GenericDoubleVisitor
+{
+	CREATE_INVOKER(recordInvoker, apply);
+
+	RecordVisitor()
+	{
+		REGISTER_ALL_VISITABLE_ASTNODE(recordInvoker)
+	}
+
+	void apply(ASTNode& node)
+	{
+		visited.insert(&node);
+		revisit(node);
+	}
+
+	std::set<ASTNode*> visited;
+};
+
+struct StaticRecordVisitor : StaticDoubleVisitor<StaticRecordVisitor>
+{
+	void apply(ASTNode& node)
+	{
+		visited.insert(&node);
+		revisit(node);
+	}
+
+	std::set<ASTNode*> visited;
+};
+
+Source* getOwnerSource(ASTNode* node)
+{
+	while(node && !isa<Source>(node))
+		node = node->parent;
+	return cast<Source>(node);
+}
+
+// an imported source is only walked through along its packages, and the objects added after import
+bool isExpectedInImportedSource(ASTNode* node, const std::set<ASTNode*>& added)
+{
+	if(isa<Source>(node) || isa<Package>(node) || (isa<SimpleIdentifier>(node) && isa<Package>(node->parent)))
+		return true;
+
+	for(ASTNode* n = node; n; n = n->parent)
+	{
+		if(added.count(n))
+			return true;
+	}
+	return false;
+}
+
+// a source with a single function of n statements like "a = b + c;"
+Source* createLargeSource(const std::string& name, std::size_t n)
+{
+	Source* source = new Source(name, false);
+	FunctionDecl* function = new FunctionDecl(
+			new SimpleIdentifier(L"f"),
+			NULL,
+			false,
+			false,
+			Declaration::VisibilitySpecifier::PUBLIC,
+			new Block());
+	source->root->addObject(function);
+
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		BinaryExpr* add = new BinaryExpr(BinaryExpr::OpCode::ARITHMETIC_ADD, new PrimaryExpr(new SimpleIdentifier(L"b")), new PrimaryExpr(new SimpleIdentifier(L"c")));
+		BinaryExpr* assign = new BinaryExpr(BinaryExpr::OpCode::ASSIGN, new PrimaryExpr(new SimpleIdentifier(L"a")), add);
+		function->block->appendObject(new ExpressionStmt(assign));
+	}
+	return source;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_ActiveSourceTraversalTestSuite )
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ActiveSourceTraversalTestCase1 )
+{
+	Tangle* tangle = cast<Tangle>(createSample4());
+	Tangle* imported = cast<Tangle>(createSample3());
+	imported->markImported(true);
+	tangle->merge(*imported);
+
+	// something like a template instantiation, added to an imported package after import
+	Package* zillians_package = NULL;
+	foreach(i, tangle->sources)
+	{
+		if(i->second->is_imported)
+			zillians_package = i->second->root->children[0]->children[0];
+	}
+	BOOST_REQUIRE(zillians_package);
+	BOOST_REQUIRE_EQUAL(zillians_package->imported_object_count, 1U);
+
+	ASTNode* instantiation = zillians_package->objects[0]->clone();
+	zillians_package->addObject(instantiation);
+
+	std::set<ASTNode*> added;
+	added.insert(instantiation);
+
+	RecordVisitor full;
+	full.visit(*tangle);
+
+	RecordVisitor active;
+	active.setActiveSourcesOnly(true);
+	active.visit(*tangle);
+
+	StaticRecordVisitor static_active;
+	static_active.setActiveSourcesOnly(true);
+	static_active.visit(*tangle);
+
+	BOOST_CHECK(active.visited == static_active.visited);
+	BOOST_CHECK(active.visited.size() < full.visited.size());
+	BOOST_CHECK(active.visited.count(instantiation) == 1);
+
+	foreach(i, full.visited)
+	{
+		Source* source = getOwnerSource(*i);
+		bool expected = !source || !source->is_imported || isExpectedInImportedSource(*i, added);
+		BOOST_CHECK_EQUAL(active.visited.count(*i) == 1, expected);
+	}
+
+	// marking as not imported brings everything back
+	tangle->markImported(false);
+
+	RecordVisitor all;
+	all.setActiveSourcesOnly(true);
+	all.visit(*tangle);
+	BOOST_CHECK(all.visited == full.visited);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ActiveSourceTraversalTestCase2 )
+{
+	// one small active source on top of a chain of large dependencies, none of which is walked
+	// (timed by ts-bench under "tree")
+	const std::size_t dependency_count = 5;
+	const std::size_t statement_count = 100;
+
+	Tangle* tangle = new Tangle();
+	for(std::size_t i = 0; i < dependency_count; ++i)
+	{
+		Tangle* dependency = new Tangle();
+		dependency->addSource(new SimpleIdentifier(L"dependency"), createLargeSource("dependency", statement_count));
+		dependency->markImported(true);
+		tangle->merge(*dependency);
+	}
+	tangle->addSource(new SimpleIdentifier(L"active"), createLargeSource("active", statement_count));
+
+	ObjectCountVisitor<> full;
+	full.visit(*tangle);
+
+	ObjectCountVisitor<> active;
+	active.setActiveSourcesOnly(true);
+	active.visit(*tangle);
+
+	BOOST_CHECK(active.get_count() * dependency_count < full.get_count());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
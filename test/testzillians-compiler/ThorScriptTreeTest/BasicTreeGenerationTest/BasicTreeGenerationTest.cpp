@@ -28,6 +28,7 @@
 #include <iostream>
 #include <string>
 #include <limits>
+#include <vector>
 
 // boost test don't support wstring
 // see https://svn.boost.org/trac/boost/ticket/1136
@@ -70,6 +71,30 @@ BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_BasicTreeGenerationTestCase1_IsA )
 		VariableDecl* node = new VariableDecl(new SimpleIdentifier(L"test"), new TypeSpecifier(PrimitiveType::FLOAT32_TYPE), false, false, true, Declaration::VisibilitySpecifier::DEFAULT);
 		BOOST_CHECK(isa<VariableDecl>(node));
 		BOOST_CHECK(isa<Declaration>(node));
+		BOOST_CHECK(!isa<FunctionDecl>(node));
+		BOOST_CHECK(!isa<Statement>(node));
+	}
+
+	{
+		// type ranges are numbered in pre-order, so a subtree's range covers all of its descendants
+		BOOST_CHECK(ASTNodeType::Statement < ASTNodeType::IterativeStmt && ASTNodeType::WhileStmt <= Statement::type_range_last);
+		BOOST_CHECK_EQUAL((int)IterativeStmt::type_range_first, (int)ASTNodeType::IterativeStmt);
+		BOOST_CHECK_EQUAL((int)ASTNode::type_range_last, (int)ASTNodeType::CastExpr);
+
+		SimpleIdentifier* node = new SimpleIdentifier(L"test");
+		BOOST_CHECK_EQUAL(node->nodeType(), ASTNodeType::SimpleIdentifier);
+		BOOST_CHECK(cast<Identifier>(node) == node);
+		BOOST_CHECK(cast<NestedIdentifier>(node) == NULL);
+		BOOST_CHECK(cast<Literal>(node) == NULL);
+		BOOST_CHECK_EQUAL(node->clone()->nodeType(), ASTNodeType::SimpleIdentifier);
+	}
+
+	{
+		// the type is set by the constructor of the concrete type, whichever constructor is used
+		BOOST_CHECK_EQUAL((new NumericLiteral(PrimitiveType::INT32_TYPE, 1))->nodeType(), ASTNodeType::NumericLiteral);
+		BOOST_CHECK_EQUAL((new TypeSpecifier(PrimitiveType::INT32_TYPE))->nodeType(), ASTNodeType::TypeSpecifier);
+		BOOST_CHECK_EQUAL((new Tangle())->internal->nodeType(), ASTNodeType::Internal);
+		BOOST_CHECK_EQUAL((new ForeachStmt(new SimpleIdentifier(L"i"), new PrimaryExpr(new SimpleIdentifier(L"v")), new Block()))->nodeType(), ASTNodeType::ForeachStmt);
 	}
 }
 
@@ -164,4 +189,53 @@ BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_TreeEqualityTest )
     }
 }
 
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_BlockInsertionTest )
+{
+	std::vector<ExpressionStmt*> stmts;
+	for(int i = 0; i < 8; ++i)
+		stmts.push_back(new ExpressionStmt(new PrimaryExpr(new NumericLiteral(i))));
+
+	Block* block = new Block();
+	block->appendObject(stmts[0]);
+	block->appendObject(stmts[1]);
+	BOOST_CHECK(block->insertObjectAfter(stmts[0], stmts[2]));
+	BOOST_CHECK(block->insertObjectBefore(stmts[0], stmts[3]));
+	block->prependObject(stmts[4]);
+
+	std::vector<ExpressionStmt*> pair;
+	pair.push_back(stmts[5]);
+	pair.push_back(stmts[6]);
+	BOOST_CHECK(block->insertObjectsAfter(stmts[2], pair));
+
+	// replace stmts[5]
+	BOOST_CHECK(block->insertObjectBefore(stmts[5], stmts[7], true));
+
+	// not in the block
+	BOOST_CHECK(!block->insertObjectAfter(stmts[5], new ExpressionStmt(new PrimaryExpr(new NumericLiteral(0)))));
+
+	ASTNode* expected[] = { stmts[4], stmts[3], stmts[0], stmts[2], stmts[7], stmts[6], stmts[1] };
+	BOOST_REQUIRE_EQUAL(block->objects.size(), sizeof(expected) / sizeof(expected[0]));
+	std::size_t n = 0;
+	foreach(i, block->objects)
+	{
+		BOOST_CHECK(*i == expected[n++]);
+		BOOST_CHECK((*i)->parent == block);
+	}
+
+	// splitting every local of a huge function (see RestructureStageVisitor) stays linear
+	const std::size_t local_count = 50000;
+	Block* large = new Block();
+	std::vector<ExpressionStmt*> locals;
+	for(std::size_t i = 0; i < local_count; ++i)
+	{
+		locals.push_back(new ExpressionStmt(new PrimaryExpr(new NumericLiteral((int32)i))));
+		large->appendObject(locals.back());
+	}
+
+	foreach(i, locals)
+		BOOST_CHECK(large->insertObjectAfter(*i, new ExpressionStmt(new PrimaryExpr(new NumericLiteral(-1)))));
+
+	BOOST_CHECK_EQUAL(large->objects.size(), local_count * 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -123,4 +123,112 @@ BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_GarbageCollectionVisitorTestCase3 )
 	BOOST_CHECK(count_after_gc == ASTNodeGC::instance()->cleanup());
 }
 
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_GarbageCollectionVisitorTestCase4 )
+{
+	ASTNodeGC arena;
+
+	std::size_t count_before_gc = 0;
+	{
+		ASTNodeGC::Scope scope(arena);
+
+		ASTNode* node = createSample1();
+		createSample1(); // unreachable from node
+
+		ObjectCountVisitor<> counter;
+		counter.visit(*node);
+		count_before_gc = counter.get_count();
+
+		BOOST_CHECK(arena.size() == count_before_gc * 2);
+
+		GarbageCollectionVisitor<> marker;
+		marker.visit(*node);
+		BOOST_CHECK(marker.get_sweep_count() == count_before_gc);
+	}
+
+	std::size_t enumerated = 0;
+	arena.foreachObject([&](const ASTNode*) { ++enumerated; });
+
+	BOOST_CHECK(enumerated == count_before_gc);
+	BOOST_CHECK(arena.size() == count_before_gc);
+
+	arena.release();
+	BOOST_CHECK(arena.size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_GarbageCollectionVisitorTestCase5 )
+{
+	ASTNodeGC arena;
+	ASTNodeGC::Scope scope(arena);
+
+	SimpleIdentifier* a = new SimpleIdentifier(L"a");
+	SimpleIdentifier* b = new SimpleIdentifier(L"b");
+	SimpleIdentifier* c = new SimpleIdentifier(L"c");
+
+	BOOST_CHECK(a->node_id == 0 && b->node_id == 1 && c->node_id == 2);
+	BOOST_CHECK(arena.idCount() == 3);
+
+	DenseNodeSet set(&arena, arena.idCount());
+	BOOST_CHECK(set.insert(a));
+	BOOST_CHECK(!set.insert(a));
+	BOOST_CHECK(set.insert(c));
+	BOOST_CHECK(set.count(a) == 1 && set.count(b) == 0 && set.count(c) == 1);
+	BOOST_CHECK(set.size() == 2);
+	BOOST_CHECK(set.erase(a) == 1 && set.size() == 1);
+
+	DenseNodeMap<int> map;
+	map[b] = 42;
+	BOOST_CHECK(map.count(a) == 0);
+	BOOST_CHECK(map.find(b) && *map.find(b) == 42);
+	BOOST_CHECK(map.erase(b) == 1 && map.find(b) == NULL);
+
+	BOOST_CHECK(arena.sweep(set) == 2);
+	BOOST_CHECK(arena.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_GarbageCollectionVisitorTestCase6 )
+{
+	ASTNodeGC arena_a;
+	ASTNodeGC arena_b;
+
+	SimpleIdentifier* a = NULL;
+	SimpleIdentifier* b = NULL;
+	{
+		ASTNodeGC::Scope scope(arena_a);
+		a = new SimpleIdentifier(L"a");
+	}
+	{
+		ASTNodeGC::Scope scope(arena_b);
+		b = new SimpleIdentifier(L"b");
+	}
+	BOOST_CHECK(a->node_id == b->node_id);
+
+	// the arena of the first node becomes the dense one, the other goes to the fallback
+	DenseNodeSet set;
+	BOOST_CHECK(set.insert(a));
+	BOOST_CHECK(set.count(b) == 0);
+	BOOST_CHECK(set.insert(b));
+	BOOST_CHECK(!set.insert(b));
+	BOOST_CHECK(set.size() == 2);
+	BOOST_CHECK(set.erase(b) == 1 && set.count(a) == 1 && set.count(b) == 0);
+
+	// marking a tree which refers into another arena leaves the other arena alone
+	ASTNode* tree = NULL;
+	{
+		ASTNodeGC::Scope scope(arena_b);
+		tree = createSample1();
+	}
+	{
+		ASTNodeGC::Scope scope(arena_a);
+		ASTNode* other = createSample1();
+		BOOST_CHECK(other->isEqual(*tree));
+		BOOST_CHECK(tree->isEqual(*other));
+
+		GarbageCollectionVisitor<> marker;
+		marker.visit(*other);
+		marker.visit(*tree);
+		BOOST_CHECK(marker.get_sweep_count() == 1);
+	}
+	BOOST_CHECK(arena_a.size() != 0 && arena_b.size() != 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNode.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/tree/visitor/GenericDoubleVisitor.h"
+#include "language/tree/visitor/GenericFusedVisitor.h"
+#include "language/tree/visitor/ObjectCountVisitor.h"
+#include "../ASTNodeSamples.h"
+#include <vector>
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_GenericFusedVisitorTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language::tree;
+using namespace zillians::language::tree::visitor;
+
+namespace {
+
+// pre-order, doesn't look into identifiers (like ManglingStageVisitor)
+struct PreOrderRecordVisitor : public GenericDoubleVisitor
+{
+	CREATE_INVOKER(recordInvoker, apply);
+
+	PreOrderRecordVisitor()
+	{
+		REGISTER_ALL_VISITABLE_ASTNODE(recordInvoker)
+	}
+
+	void apply(ASTNode& node)
+	{
+		order.push_back(&node);
+		revisit(node);
+	}
+
+	void apply(Identifier& node)
+	{
+		order.push_back(&node);
+	}
+
+	std::vector<ASTNode*> order;
+};
+
+// post-order, so it can only be the leader
+struct PostOrderRecordVisitor : public GenericDoubleVisitor
+{
+	CREATE_INVOKER(recordInvoker, apply);
+
+	PostOrderRecordVisitor()
+	{
+		REGISTER_ALL_VISITABLE_ASTNODE(recordInvoker)
+	}
+
+	void apply(ASTNode& node)
+	{
+		revisit(node);
+		order.push_back(&node);
+	}
+
+	std::vector<ASTNode*> order;
+};
+
+// a block of n statements like "a = b + c;"
+Block* createLargeBlock(std::size_t n)
+{
+	Block* block = new Block();
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		BinaryExpr* add = new BinaryExpr(BinaryExpr::OpCode::ARITHMETIC_ADD, new PrimaryExpr(new SimpleIdentifier(L"b")), new PrimaryExpr(new SimpleIdentifier(L"c")));
+		BinaryExpr* assign = new BinaryExpr(BinaryExpr::OpCode::ASSIGN, new PrimaryExpr(new SimpleIdentifier(L"a")), add);
+		block->appendObject(new ExpressionStmt(assign));
+	}
+	return block;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_GenericFusedVisitorTestSuite )
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_GenericFusedVisitorTestCase1 )
+{
+	// every component must see exactly what it sees when running alone
+	ASTNode* samples[] = { createSample1(), createSample2(), createSample3(), createSample4(), createSample5() };
+	for(std::size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i)
+	{
+		ObjectCountVisitor<> standalone_counter;
+		PreOrderRecordVisitor standalone_pre;
+		PostOrderRecordVisitor standalone_post;
+		standalone_counter.visit(*samples[i]);
+		standalone_pre.visit(*samples[i]);
+		standalone_post.visit(*samples[i]);
+
+		ObjectCountVisitor<> counter;
+		PreOrderRecordVisitor pre;
+		PostOrderRecordVisitor post;
+		{
+			GenericFusedVisitor fused;
+			fused.addFollower(counter);
+			fused.addFollower(pre);
+			fused.setLeader(post);
+			fused.visit(*samples[i]);
+		}
+
+		BOOST_CHECK_EQUAL(standalone_counter.get_count(), counter.get_count());
+		BOOST_CHECK(standalone_pre.order == pre.order);
+		BOOST_CHECK(standalone_post.order == post.order);
+
+		// without a leader, the followers drive the walk themselves
+		PreOrderRecordVisitor leaderless_pre;
+		{
+			GenericFusedVisitor fused;
+			fused.addFollower(leaderless_pre);
+			fused.visit(*samples[i]);
+		}
+
+		BOOST_CHECK(standalone_pre.order == leaderless_pre.order);
+
+		// once the fused visitor is gone, the components are standalone again
+		pre.order.clear();
+		pre.visit(*samples[i]);
+		BOOST_CHECK(standalone_pre.order == pre.order);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_GenericFusedVisitorTestCase2 )
+{
+	// fused components count as many nodes as separate walks do, also over a large tree (timed by
+	// ts-bench under "tree")
+	Block* block = createLargeBlock(10000);
+
+	ObjectCountVisitor<> separate1, separate2, separate3;
+	separate1.visit(*block);
+	separate2.visit(*block);
+	separate3.visit(*block);
+
+	ObjectCountVisitor<> fused1, fused2, fused3;
+	{
+		GenericFusedVisitor fused;
+		fused.addFollower(fused1);
+		fused.addFollower(fused2);
+		fused.addFollower(fused3);
+		fused.visit(*block);
+	}
+
+	BOOST_CHECK_EQUAL(separate1.get_count(), fused1.get_count());
+	BOOST_CHECK_EQUAL(separate2.get_count(), fused2.get_count());
+	BOOST_CHECK_EQUAL(separate3.get_count(), fused3.get_count());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,214 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/tree/NodeContextTable.h"
+#include "language/stage/parser/context/SourceInfoContext.h"
+#include <vector>
+#include <thread>
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_NodeContextTableTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language::tree;
+using namespace zillians::language::stage;
+
+namespace {
+
+// a context counting its live instances, to tell when the table frees them
+struct CountedContext
+{
+	explicit CountedContext(int value) : value(value)
+	{
+		++live;
+	}
+
+	CountedContext(const CountedContext& other) : value(other.value)
+	{
+		++live;
+	}
+
+	CountedContext& operator=(const CountedContext& other)
+	{
+		value = other.value;
+		return *this;
+	}
+
+	~CountedContext()
+	{
+		--live;
+	}
+
+	int value;
+	static int live;
+};
+
+int CountedContext::live = 0;
+
+}
+
+BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_NodeContextTableTestSuite )
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_NodeContextTableTestCase1 )
+{
+	ASTNodeGC arena;
+	ASTNodeGC::Scope scope(arena);
+
+	SimpleIdentifier* a = new SimpleIdentifier(L"a");
+	SimpleIdentifier* b = new SimpleIdentifier(L"b");
+
+	BOOST_CHECK(SourceInfoContext::get(a) == NULL);
+
+	SourceInfoContext* ctx = new SourceInfoContext(1, 2);
+	SourceInfoContext::set(a, ctx);
+	BOOST_CHECK(SourceInfoContext::get(a) == ctx);
+
+	SourceInfoContext* copied = SourceInfoContext::set(b, *ctx);
+	BOOST_CHECK(copied != ctx);
+	BOOST_CHECK_EQUAL(SourceInfoContext::get(b)->line(), 1);
+	BOOST_CHECK_EQUAL(SourceInfoContext::get(b)->column(), 2);
+
+	// overwriting keeps the slot
+	SourceInfoContext::set(b, SourceInfoContext(3, 4));
+	BOOST_CHECK(SourceInfoContext::get(b) == copied);
+	BOOST_CHECK_EQUAL(copied->line(), 3);
+
+	SourceInfoContext::set(a, NULL);
+	BOOST_CHECK(SourceInfoContext::get(a) == NULL);
+	BOOST_CHECK_EQUAL(NodeContextTable<SourceInfoContext>::instance().size(), 1);
+
+	// tables belong to the arena, a different arena starts empty
+	{
+		ASTNodeGC other;
+		ASTNodeGC::Scope other_scope(other);
+		BOOST_CHECK_EQUAL(NodeContextTable<SourceInfoContext>::instance().size(), 0);
+	}
+	BOOST_CHECK_EQUAL(NodeContextTable<SourceInfoContext>::instance().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_NodeContextTableTestCase2 )
+{
+	typedef NodeContextTable<CountedContext> Table;
+	{
+		ASTNodeGC first;
+		ASTNodeGC second;
+
+		ASTNode* a = NULL;
+		ASTNode* b = NULL;
+		ASTNode* c = NULL;
+		{
+			ASTNodeGC::Scope scope(first);
+			a = new SimpleIdentifier(L"a");
+			b = new SimpleIdentifier(L"b");
+		}
+		{
+			ASTNodeGC::Scope scope(second);
+			c = new SimpleIdentifier(L"c");
+		}
+		BOOST_CHECK_EQUAL(a->node_id, c->node_id);
+
+		// contexts go to the table of the arena of the node, whichever arena is active
+		ASTNodeGC active;
+		ASTNodeGC::Scope scope(active);
+
+		CountedContext* shared = new CountedContext(1);
+		Table::set(a, shared);
+		Table::set(a, shared);
+		Table::set(b, shared);
+		Table::assign(c, CountedContext(2));
+
+		BOOST_CHECK(Table::get(a) == shared);
+		BOOST_CHECK(Table::get(b) == shared);
+		BOOST_CHECK_EQUAL(Table::get(c)->value, 2);
+		BOOST_CHECK_EQUAL(Table::instance().size(), 0);
+		BOOST_CHECK_EQUAL(Table::of(a).size(), 2);
+		BOOST_CHECK_EQUAL(Table::of(c).size(), 1);
+
+		// a context taken over is freed once, when no node refers to it any more
+		Table::reset(a);
+		BOOST_CHECK_EQUAL(CountedContext::live, 2);
+		BOOST_CHECK(Table::get(b) == shared);
+
+		// and so are the contexts of a deleted node
+		delete b;
+		BOOST_CHECK_EQUAL(CountedContext::live, 1);
+		BOOST_CHECK_EQUAL(Table::of(a).size(), 0);
+
+		// replacing a context taken over frees it
+		Table::set(a, new CountedContext(3));
+		Table::set(a, new CountedContext(4));
+		BOOST_CHECK_EQUAL(CountedContext::live, 2);
+		Table::assign(a, CountedContext(5));
+		BOOST_CHECK_EQUAL(CountedContext::live, 2);
+		BOOST_CHECK_EQUAL(Table::get(a)->value, 5);
+	}
+	BOOST_CHECK_EQUAL(CountedContext::live, 0);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_NodeContextTableTestCase3 )
+{
+	ASTNodeGC arena;
+	ASTNodeGC::Scope scope(arena);
+
+	SimpleIdentifier* local = new SimpleIdentifier(L"local");
+	SourceInfoContext::set(local, SourceInfoContext(1, 1));
+
+	// fill another arena on a worker thread, just like the parser stage does for each file
+	ASTNodeGC worker_arena;
+	std::vector<ASTNode*> nodes;
+	SourceInfoContext* adopted_ctx = new SourceInfoContext(7, 7);
+	std::thread worker([&]() {
+		ASTNodeGC::Scope worker_scope(worker_arena);
+		for(std::size_t i = 0; i < 100; ++i)
+		{
+			nodes.push_back(new SimpleIdentifier(L"x"));
+			SourceInfoContext::set(nodes.back(), SourceInfoContext(i, i));
+		}
+		SourceInfoContext::set(nodes[0], adopted_ctx);
+	});
+	worker.join();
+
+	std::size_t id_offset = arena.idCount();
+	arena.adopt(worker_arena, [](const ASTNode* node, uint32 offset) {
+		const_cast<ASTNode*>(node)->node_id += offset;
+	});
+
+	BOOST_CHECK_EQUAL(worker_arena.size(), 0);
+	BOOST_CHECK_EQUAL(arena.size(), 101);
+	BOOST_CHECK_EQUAL(arena.idCount(), id_offset + 100);
+	BOOST_CHECK_EQUAL(NodeContextTable<SourceInfoContext>::instance().size(), 101);
+
+	BOOST_CHECK(SourceInfoContext::get(nodes[0]) == adopted_ctx);
+	for(std::size_t i = 1; i < nodes.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(nodes[i]->node_id, id_offset + i);
+		BOOST_CHECK_EQUAL(SourceInfoContext::get(nodes[i])->line(), i);
+	}
+	BOOST_CHECK_EQUAL(SourceInfoContext::get(local)->line(), 1);
+
+	// adopted nodes are owned by the arena now, along with their contexts
+	delete nodes[1];
+	BOOST_CHECK_EQUAL(arena.size(), 100);
+	BOOST_CHECK_EQUAL(NodeContextTable<SourceInfoContext>::instance().size(), 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
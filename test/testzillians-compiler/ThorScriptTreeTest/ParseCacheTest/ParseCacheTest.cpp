@@ -0,0 +1,129 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNode.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/stage/parser/ParseCache.h"
+#include "../ASTNodeSamples.h"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_ParseCacheTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language::stage;
+using namespace zillians::language::tree;
+
+namespace {
+
+const boost::filesystem::path cache_directory("parse-cache");
+const std::string source_file("parse-cache-test.t");
+
+void writeFile(const std::string& filename, const std::string& content)
+{
+    std::ofstream ofs(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+    ofs.write(content.data(), content.size());
+}
+
+std::string readFile(const std::string& filename)
+{
+    std::ifstream ifs(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_ParseCacheTestSuite )
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ParseCacheTestCase1 )
+{
+    boost::filesystem::remove_all(cache_directory);
+    writeFile(source_file, "function f() : void { }\n");
+
+    SourceBuffer buffer;
+    BOOST_REQUIRE(buffer.open(source_file));
+
+    ParseCache cache(cache_directory);
+    std::deque<std::wstring> package;
+    package.push_back(L"a");
+    std::string key = cache.key(buffer, source_file, package);
+
+    // nothing stored yet
+    Identifier* package_id = NULL;
+    Source* source = NULL;
+    BOOST_CHECK(!cache.load(key, package_id, source));
+
+    // what is stored is what is loaded
+    Tangle* tangle = cast<Tangle>(createSample3());
+    BOOST_REQUIRE(cache.store(key, tangle->sources.begin()->first, tangle->sources.begin()->second));
+    BOOST_REQUIRE(cache.load(key, package_id, source));
+    BOOST_CHECK(tangle->sources.begin()->first->isEqual(*package_id));
+    BOOST_CHECK(tangle->sources.begin()->second->isEqual(*source));
+
+    // the same file under another name or in another package is another entry
+    BOOST_CHECK(cache.key(buffer, "other.t", package) != key);
+    std::deque<std::wstring> other_package(package);
+    other_package.push_back(L"b");
+    BOOST_CHECK(cache.key(buffer, source_file, other_package) != key);
+
+    // and so is an edited file, which misses
+    buffer.close();
+    writeFile(source_file, "function f() : int32 { return 0; }\n");
+    BOOST_REQUIRE(buffer.open(source_file));
+    std::string edited_key = cache.key(buffer, source_file, package);
+    BOOST_CHECK(edited_key != key);
+    BOOST_CHECK(!cache.load(edited_key, package_id, source));
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ParseCacheTestCase2 )
+{
+    boost::filesystem::remove_all(cache_directory);
+    writeFile(source_file, "function f() : void { }\n");
+
+    SourceBuffer buffer;
+    BOOST_REQUIRE(buffer.open(source_file));
+
+    ParseCache cache(cache_directory);
+    std::string key = cache.key(buffer, source_file, std::deque<std::wstring>());
+    std::string entry = (cache_directory / (key + ".ast")).string();
+
+    Tangle* tangle = cast<Tangle>(createSample3());
+    BOOST_REQUIRE(cache.store(key, tangle->sources.begin()->first, tangle->sources.begin()->second));
+    std::string content = readFile(entry);
+
+    // a corrupted entry is a miss, not a failure
+    Identifier* package_id = NULL;
+    Source* source = NULL;
+    writeFile(entry, "not an archive");
+    BOOST_CHECK(!cache.load(key, package_id, source));
+
+    writeFile(entry, content.substr(0, content.size() / 2));
+    BOOST_CHECK(!cache.load(key, package_id, source));
+
+    // and storing again repairs it
+    BOOST_REQUIRE(cache.store(key, tangle->sources.begin()->first, tangle->sources.begin()->second));
+    BOOST_CHECK(cache.load(key, package_id, source));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
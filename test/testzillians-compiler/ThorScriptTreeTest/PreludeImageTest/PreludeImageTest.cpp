@@ -0,0 +1,76 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNode.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/stage/serialization/detail/PreludeImage.h"
+#include "../ASTNodeSamples.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_PreludeImageTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language::stage;
+using namespace zillians::language::tree;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_PreludeImageTestSuite )
+
+template <typename TreeCreateFunction>
+void WriteLoadCompare(TreeCreateFunction f)
+{
+    Tangle* origTangle = cast<Tangle>(f());
+    BOOST_REQUIRE(PreludeImage::write("prelude.image", origTangle));
+
+    Tangle* loadedTangle = PreludeImage::load("prelude.image");
+    BOOST_REQUIRE(loadedTangle != NULL);
+    BOOST_CHECK(origTangle->isEqual(*loadedTangle));
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_PreludeImageTestCase1 )
+{
+    WriteLoadCompare(createSample1);
+    WriteLoadCompare(createSample2);
+    WriteLoadCompare(createSample3);
+    WriteLoadCompare(createSample4);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_PreludeImageTestCase2 )
+{
+    BOOST_CHECK(PreludeImage::load("no-such-prelude.image") == NULL);
+
+    // an image cut short (e.g. by an interrupted build) is refused instead of half loaded
+    BOOST_REQUIRE(PreludeImage::write("prelude.image", cast<Tangle>(createSample3())));
+    std::string content;
+    {
+        std::ifstream ifs("prelude.image", std::ios_base::in | std::ios_base::binary);
+        content.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream ofs("prelude-truncated.image", std::ios_base::out | std::ios_base::binary);
+        ofs.write(content.data(), content.size() / 2);
+    }
+    BOOST_CHECK(PreludeImage::load("prelude-truncated.image") == NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
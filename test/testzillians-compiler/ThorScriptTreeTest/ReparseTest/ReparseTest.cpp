@@ -0,0 +1,349 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNode.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/context/ParserContext.h"
+#include "language/stage/parser/ThorScriptParserStage.h"
+#include "language/stage/parser/context/SourceInfoContext.h"
+#include "language/stage/parser/context/SourceSpanContext.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_ReparseTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language;
+using namespace zillians::language::stage;
+using namespace zillians::language::tree;
+
+namespace po = boost::program_options;
+
+namespace {
+
+const boost::filesystem::path root_directory("reparse-test");
+const std::string source_file("reparse-test/reparse.t");
+
+const std::string original_content =
+    "import . = a;\n"
+    "\n"
+    "function f() : int32 { return 1; }\n"
+    "\n"
+    "// g\n"
+    "function g() : int32 { return 2; }\n"
+    "\n"
+    "function h() : int32 { return 3; }\n";
+
+void writeFile(const std::string& filename, const std::string& content)
+{
+    std::ofstream ofs(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+    ofs.write(content.data(), content.size());
+}
+
+// a full parse of the file into the given context, through the parse cache if one is given
+Source* parse(ThorScriptParserStage& stage, ParserContext& context, const std::string& cache_directory = "")
+{
+    po::variables_map vm;
+    if(!cache_directory.empty())
+        vm.insert(std::make_pair("parse-cache-dir", po::variable_value(cache_directory, false)));
+    vm.insert(std::make_pair("root-dir", po::variable_value(root_directory.string(), false)));
+    vm.insert(std::make_pair("input", po::variable_value(std::vector<std::string>(1, source_file), false)));
+    vm.insert(std::make_pair("parser-threads", po::variable_value(uint32(1), false)));
+
+    ParserContext::Scope scope(context);
+    bool continue_execution = true;
+    if(!stage.parseOptions(vm) || !stage.execute(continue_execution))
+        return NULL;
+
+    BOOST_REQUIRE_EQUAL(context.tangle->sources.size(), 1u);
+    return context.tangle->sources.begin()->second;
+}
+
+// the same content parsed from scratch
+Source* parseAgain()
+{
+    ParserContext context;
+    ThorScriptParserStage stage;
+    return parse(stage, context);
+}
+
+std::wstring nameOf(ASTNode* decl)
+{
+    return cast<FunctionDecl>(decl)->name->toString();
+}
+
+std::size_t offsetOf(const std::string& content, const std::string& text)
+{
+    std::size_t offset = content.find(text);
+    BOOST_REQUIRE(offset != std::string::npos);
+    return offset;
+}
+
+struct ReparseFixture
+{
+    ReparseFixture()
+    {
+        boost::filesystem::remove_all(root_directory);
+        boost::filesystem::create_directories(root_directory);
+        writeFile(source_file, original_content);
+
+        source = parse(stage, context);
+        BOOST_REQUIRE(source);
+        BOOST_REQUIRE_EQUAL(source->root->objects.size(), 3u);
+
+        f = source->root->objects[0];
+        g = source->root->objects[1];
+        h = source->root->objects[2];
+    }
+
+    bool reparse(const std::string& content, const std::vector<ThorScriptParserStage::TextEdit>& edits)
+    {
+        writeFile(source_file, content);
+        return stage.reparse(source, edits, result);
+    }
+
+    ParserContext context;
+    ThorScriptParserStage stage;
+    Source* source;
+    ASTNode* f;
+    ASTNode* g;
+    ASTNode* h;
+    ThorScriptParserStage::ReparseResult result;
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( ThorScriptTreeTest_ReparseTestSuite, ReparseFixture )
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ReparseTestCase1_Edit )
+{
+    uint32 h_line = SourceInfoContext::get(h)->line();
+
+    // "return 2;" becomes "return\n\t20;", which also moves h one line down
+    std::string content = original_content;
+    std::size_t offset = offsetOf(content, "return 2;") + 6;
+    std::vector<ThorScriptParserStage::TextEdit> edits;
+    edits.push_back(ThorScriptParserStage::TextEdit(offset, 2, "\n\t20"));
+    content.replace(offset, 2, "\n\t20");
+
+    BOOST_REQUIRE(reparse(content, edits));
+    BOOST_REQUIRE_EQUAL(result.changed.size(), 1u);
+    BOOST_REQUIRE_EQUAL(result.removed.size(), 1u);
+    BOOST_CHECK(result.removed[0] == g);
+
+    // only g is replaced
+    BOOST_REQUIRE_EQUAL(source->root->objects.size(), 3u);
+    BOOST_CHECK(source->root->objects[0] == f);
+    BOOST_CHECK(source->root->objects[1] == result.changed[0]);
+    BOOST_CHECK(source->root->objects[2] == h);
+    BOOST_CHECK(result.changed[0]->parent == source->root);
+    BOOST_CHECK(nameOf(result.changed[0]) == L"g");
+
+    // the locations of the untouched h are moved along
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(h)->line(), h_line + 1);
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(cast<FunctionDecl>(h)->name)->line(), h_line + 1);
+
+    BOOST_CHECK(source->isEqual(*parseAgain()));
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ReparseTestCase2_Insert )
+{
+    uint32 g_line = SourceInfoContext::get(g)->line();
+
+    // a new declaration typed in between f and g, after the comment
+    std::string inserted = "function k() : int32 { return 4; }\n\n";
+    std::string content = original_content;
+    std::size_t offset = offsetOf(content, "function g");
+    std::vector<ThorScriptParserStage::TextEdit> edits;
+    edits.push_back(ThorScriptParserStage::TextEdit(offset - 1, 0, "\n" + inserted.substr(0, inserted.size() - 1)));
+    content.insert(offset - 1, "\n" + inserted.substr(0, inserted.size() - 1));
+
+    BOOST_REQUIRE(reparse(content, edits));
+    BOOST_REQUIRE_EQUAL(result.changed.size(), 1u);
+    BOOST_CHECK(result.removed.empty());
+
+    BOOST_REQUIRE_EQUAL(source->root->objects.size(), 4u);
+    BOOST_CHECK(source->root->objects[0] == f);
+    BOOST_CHECK(source->root->objects[1] == result.changed[0]);
+    BOOST_CHECK(source->root->objects[2] == g);
+    BOOST_CHECK(source->root->objects[3] == h);
+    BOOST_CHECK(nameOf(result.changed[0]) == L"k");
+
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(g)->line(), g_line + 2);
+
+    BOOST_CHECK(source->isEqual(*parseAgain()));
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ReparseTestCase3_Erase )
+{
+    uint32 h_line = SourceInfoContext::get(h)->line();
+
+    // g is deleted along with its comment and its line break
+    std::string content = original_content;
+    std::size_t offset = offsetOf(content, "// g");
+    std::size_t length = offsetOf(content, "function h") - 1 - offset;
+    std::vector<ThorScriptParserStage::TextEdit> edits;
+    edits.push_back(ThorScriptParserStage::TextEdit(offset, length, ""));
+    content.erase(offset, length);
+
+    BOOST_REQUIRE(reparse(content, edits));
+    BOOST_CHECK(result.changed.empty());
+    BOOST_REQUIRE_EQUAL(result.removed.size(), 1u);
+    BOOST_CHECK(result.removed[0] == g);
+    BOOST_CHECK(g->parent == NULL);
+
+    BOOST_REQUIRE_EQUAL(source->root->objects.size(), 2u);
+    BOOST_CHECK(source->root->objects[0] == f);
+    BOOST_CHECK(source->root->objects[1] == h);
+
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(h)->line(), h_line - 2);
+
+    BOOST_CHECK(source->isEqual(*parseAgain()));
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ReparseTestCase4_Append )
+{
+    // appended to the end of the file
+    std::string content = original_content;
+    std::vector<ThorScriptParserStage::TextEdit> edits;
+    edits.push_back(ThorScriptParserStage::TextEdit(content.size(), 0, "\nfunction k() : int32 { return 4; }\n"));
+    content += "\nfunction k() : int32 { return 4; }\n";
+
+    BOOST_REQUIRE(reparse(content, edits));
+    BOOST_REQUIRE_EQUAL(result.changed.size(), 1u);
+    BOOST_CHECK(result.removed.empty());
+    BOOST_REQUIRE_EQUAL(source->root->objects.size(), 4u);
+    BOOST_CHECK(source->root->objects[3] == result.changed[0]);
+
+    BOOST_CHECK(source->isEqual(*parseAgain()));
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ReparseTestCase5_Fallback )
+{
+    std::size_t node_count = ASTNodeGC::instance()->size();
+    std::size_t file_count = SourceTable::instance().size();
+
+    // an edit in the imports needs a full parse
+    {
+        std::string content = original_content;
+        std::vector<ThorScriptParserStage::TextEdit> edits;
+        edits.push_back(ThorScriptParserStage::TextEdit(offsetOf(content, "a;"), 1, "b"));
+        content.replace(offsetOf(content, "a;"), 1, "b");
+
+        BOOST_CHECK(!reparse(content, edits));
+    }
+
+    // so does a declaration which doesn't parse any more, and nothing is left behind
+    {
+        std::string content = original_content;
+        std::size_t offset = offsetOf(content, "return 2;");
+        std::vector<ThorScriptParserStage::TextEdit> edits;
+        edits.push_back(ThorScriptParserStage::TextEdit(offset, 0, ")"));
+        content.insert(offset, ")");
+
+        BOOST_CHECK(!reparse(content, edits));
+    }
+
+    // as do edits which don't match the file
+    {
+        std::vector<ThorScriptParserStage::TextEdit> edits;
+        edits.push_back(ThorScriptParserStage::TextEdit(offsetOf(original_content, "return 2;"), 0, "x"));
+
+        BOOST_CHECK(!reparse(original_content, edits));
+    }
+
+    BOOST_CHECK(result.changed.empty() && result.removed.empty());
+    BOOST_REQUIRE_EQUAL(source->root->objects.size(), 3u);
+    BOOST_CHECK(source->root->objects[0] == f && source->root->objects[1] == g && source->root->objects[2] == h);
+    BOOST_CHECK_EQUAL(ASTNodeGC::instance()->size(), node_count);
+    BOOST_CHECK_EQUAL(SourceTable::instance().size(), file_count);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ReparseTestCase6_KeepFileNumber )
+{
+    uint32 file = SourceSpanContext::get(h)->file;
+    std::size_t file_count = SourceTable::instance().size();
+
+    // the file is edited again and again, each time with a different content
+    std::string content = original_content;
+    for(int i = 0; i < 10; ++i)
+    {
+        std::size_t offset = offsetOf(content, "return 2") + 7;
+        std::vector<ThorScriptParserStage::TextEdit> edits;
+        edits.push_back(ThorScriptParserStage::TextEdit(offset, 1, "2\n"));
+        content.replace(offset, 1, "2\n");
+
+        BOOST_REQUIRE(reparse(content, edits));
+    }
+
+    // it keeps its number, and the untouched declarations are located in the new content
+    BOOST_CHECK_EQUAL(SourceTable::instance().size(), file_count);
+    BOOST_CHECK_EQUAL(SourceSpanContext::get(h)->file, file);
+    BOOST_CHECK_EQUAL(SourceTable::instance().get(file)->size, content.size());
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(h)->line(), (uint32)std::count(content.begin(), content.begin() + offsetOf(content, "function h"), '\n') + 1);
+
+    BOOST_CHECK(source->isEqual(*parseAgain()));
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_ReparseTestCase7_Cached )
+{
+    std::string cache_directory = (root_directory / "cache").string();
+
+    // the first parse fills the cache, the second one is loaded from it, spans included
+    {
+        ParserContext filling_context;
+        ThorScriptParserStage filling_stage;
+        BOOST_REQUIRE(parse(filling_stage, filling_context, cache_directory));
+    }
+
+    ParserContext cached_context;
+    ThorScriptParserStage cached_stage;
+    Source* cached = parse(cached_stage, cached_context, cache_directory);
+    BOOST_REQUIRE(cached);
+    BOOST_REQUIRE(!boost::filesystem::is_empty(cache_directory));
+    BOOST_REQUIRE_EQUAL(cached->root->objects.size(), 3u);
+    ASTNode* cached_h = cached->root->objects[2];
+    BOOST_REQUIRE(SourceSpanContext::get(cached_h));
+    BOOST_CHECK_EQUAL(SourceSpanContext::get(cached_h)->begin, SourceSpanContext::get(h)->begin);
+    BOOST_CHECK_EQUAL(SourceSpanContext::get(cached_h)->end, SourceSpanContext::get(h)->end);
+    uint32 h_line = SourceInfoContext::get(cached_h)->line();
+
+    // so it can be reparsed like a parsed one
+    std::string content = original_content;
+    std::size_t offset = offsetOf(content, "return 2;") + 6;
+    std::vector<ThorScriptParserStage::TextEdit> edits;
+    edits.push_back(ThorScriptParserStage::TextEdit(offset, 2, "\n\t20"));
+    content.replace(offset, 2, "\n\t20");
+    writeFile(source_file, content);
+
+    ThorScriptParserStage::ReparseResult cached_result;
+    BOOST_REQUIRE(cached_stage.reparse(cached, edits, cached_result));
+    BOOST_REQUIRE_EQUAL(cached_result.changed.size(), 1u);
+    BOOST_CHECK(cached->root->objects[2] == cached_h);
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(cached_h)->line(), h_line + 1);
+
+    BOOST_CHECK(cached->isEqual(*parseAgain()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
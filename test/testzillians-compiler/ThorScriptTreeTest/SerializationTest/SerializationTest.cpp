@@ -21,7 +21,9 @@
 #include "language/tree/ASTNode.h"
 #include "language/tree/ASTNodeFactory.h"
 #include "language/tree/ASTNodeSerialization.h"
+#include "language/tree/ASTNodeHelper.h"
 #include "language/tree/visitor/PrettyPrintVisitor.h"
+#include "language/stage/serialization/detail/ASTSerializationHelper.h"
 #include "../ASTNodeSamples.h"
 #include <iostream>
 #include <string>
@@ -36,6 +38,7 @@
 using namespace zillians;
 using namespace zillians::language::tree;
 using namespace zillians::language::tree::visitor;
+using zillians::language::stage::ASTSerializationHelper;
 
 BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_SerializationTestSuite )
 
@@ -70,4 +73,30 @@ BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SerializationTestCase1 )
     CreateSaveRestoreComare(createSample4);
 }
 
+/**
+ * Test the interface fingerprint ignoring function bodies only
+ */
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SerializationTestCase2 )
+{
+    ASTNode* tangle = createSample3();
+    std::string original = ASTSerializationHelper::interfaceFingerprint(tangle);
+    BOOST_CHECK_EQUAL(original, ASTSerializationHelper::interfaceFingerprint(tangle));
+
+    FunctionDecl* function = NULL;
+    ASTNodeHelper::foreachApply<FunctionDecl>(*tangle, [&](FunctionDecl& decl) {
+        if(!function && decl.block) function = &decl;
+    });
+    BOOST_REQUIRE(function != NULL);
+
+    // a changed body keeps the interface, and the body stays in place
+    Block* block = function->block;
+    block->appendObject(new ExpressionStmt(new PrimaryExpr(new SimpleIdentifier(L"a"))));
+    BOOST_CHECK_EQUAL(original, ASTSerializationHelper::interfaceFingerprint(tangle));
+    BOOST_CHECK(function->block == block);
+
+    // a new parameter changes it
+    function->appendParameter(new SimpleIdentifier(L"p"), new TypeSpecifier(PrimitiveType::INT32_TYPE));
+    BOOST_CHECK(original != ASTSerializationHelper::interfaceFingerprint(tangle));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
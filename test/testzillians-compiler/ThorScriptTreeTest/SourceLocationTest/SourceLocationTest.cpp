@@ -0,0 +1,230 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2011 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/stage/parser/SourceLineTable.h"
+#include "language/stage/parser/context/SourceInfoContext.h"
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_SourceLocationTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language::stage;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_SourceLocationTestSuite )
+
+// count line and column the way spirit's position_iterator does
+void locateByScanning(const std::string& s, uint32 offset, uint32& line, uint32& column)
+{
+	line = column = 1;
+	for(uint32 i = 0; i < offset; ++i)
+	{
+		char c = s[i];
+		if((c & 0xC0) == 0x80)
+			continue;
+
+		if(c == '\n' || (c == '\r' && (i + 1 == s.size() || s[i + 1] != '\n')))
+		{
+			++line;
+			column = 1;
+		}
+		else if(c == '\t')
+			column += 4 - (column - 1) % 4;
+		else
+			++column;
+	}
+}
+
+std::string randomSource(std::size_t pieces)
+{
+	const char* samples[] = { "a", " ", "\t", "\n", "\r\n", "\r", "\xc3\xa9", "\xe4\xb8\xad" };
+	const std::size_t sample_count = sizeof(samples) / sizeof(samples[0]);
+
+	std::srand(5);
+	std::string s;
+	for(std::size_t i = 0; i < pieces; ++i)
+		s += samples[std::rand() % sample_count];
+	return s;
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SourceLocationTestCase1 )
+{
+	std::string s = randomSource(20000);
+	SourceLineTable table("random.t", s.data(), s.data() + s.size());
+
+	for(uint32 offset = 0; offset <= s.size(); ++offset)
+	{
+		if(offset < s.size() && (s[offset] & 0xC0) == 0x80)
+			continue;
+
+		uint32 expected_line = 0, expected_column = 0, line = 0, column = 0;
+		locateByScanning(s, offset, expected_line, expected_column);
+		table.locate(offset, line, column);
+		BOOST_REQUIRE_EQUAL(line, expected_line);
+		BOOST_REQUIRE_EQUAL(column, expected_column);
+	}
+
+	// plain ASCII needs no column marks at all
+	std::string ascii = "class A\n{\n  function f():void\n  {\n  }\n}\n";
+	SourceLineTable ascii_table("ascii.t", ascii.data(), ascii.data() + ascii.size());
+	BOOST_CHECK_EQUAL(ascii_table.line_offsets.size(), 7);
+	BOOST_CHECK(ascii_table.column_marks.empty());
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SourceLocationTestCase2 )
+{
+	std::string s = "import a;\n\tfunction f():void { }\n";
+	shared_ptr<SourceLineTable> table(new SourceLineTable("packed.t", s.data(), s.data() + s.size()));
+	uint32 file = SourceTable::instance().add(table);
+
+	// identical content is registered only once
+	shared_ptr<SourceLineTable> again(new SourceLineTable("packed.t", s.data(), s.data() + s.size()));
+	BOOST_CHECK_EQUAL(SourceTable::instance().add(again), file);
+
+	SourceInfoContext import = SourceInfoContext::at(file, 0);
+	SourceInfoContext function = SourceInfoContext::at(file, 11);
+	BOOST_CHECK(import.isPacked());
+	BOOST_CHECK_EQUAL(function.file(), file);
+	BOOST_CHECK_EQUAL(function.offset(), 11);
+	BOOST_CHECK_EQUAL(function.line(), 2);
+	BOOST_CHECK_EQUAL(function.column(), 5);
+
+	BOOST_CHECK(import.compare(function) < 0);
+	BOOST_CHECK(function.compare(import) > 0);
+	BOOST_CHECK(function.compare(SourceInfoContext(2, 5)) == 0);
+
+	// offsets beyond the packed range are looked up right away
+	SourceInfoContext far = SourceInfoContext::at(file, SourceInfoContext::max_offset + 1);
+	BOOST_CHECK(!far.isPacked());
+	BOOST_CHECK_EQUAL(far.line(), 3);
+
+	uint32 max_line = SourceInfoContext::max_line;
+	uint32 max_column = SourceInfoContext::max_column;
+	SourceInfoContext clamped(max_line + 10, max_column + 10);
+	BOOST_CHECK_EQUAL(clamped.line(), max_line);
+	BOOST_CHECK_EQUAL(clamped.column(), max_column);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SourceLocationTestCase3 )
+{
+	std::string s = randomSource(5000);
+	shared_ptr<SourceLineTable> table(new SourceLineTable("archived.t", s.data(), s.data() + s.size()));
+	uint32 file = SourceTable::instance().add(table);
+
+	std::ostringstream os;
+	{
+		boost::archive::text_oarchive oa(os);
+		SourceInfoContext* first = new SourceInfoContext(SourceInfoContext::at(file, 100));
+		SourceInfoContext* second = new SourceInfoContext(SourceInfoContext::at(file, 3000));
+		SourceInfoContext* literal = new SourceInfoContext(7, 9);
+		oa << first;
+		oa << second;
+		oa << literal;
+	}
+
+	std::istringstream is(os.str());
+	boost::archive::text_iarchive ia(is);
+	SourceInfoContext* first = NULL;
+	SourceInfoContext* second = NULL;
+	SourceInfoContext* literal = NULL;
+	ia >> first;
+	ia >> second;
+	ia >> literal;
+
+	// the loaded line table is the same file, so the number is reused
+	BOOST_CHECK_EQUAL(first->file(), file);
+	BOOST_CHECK_EQUAL(second->file(), file);
+	BOOST_CHECK_EQUAL(first->compare(SourceInfoContext::at(file, 100)), 0);
+	BOOST_CHECK_EQUAL(second->compare(SourceInfoContext::at(file, 3000)), 0);
+	BOOST_CHECK(!literal->isPacked());
+	BOOST_CHECK_EQUAL(literal->line(), 7);
+	BOOST_CHECK_EQUAL(literal->column(), 9);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SourceLocationTestCase4 )
+{
+	std::string s = "import a;\nfunction f():void { }\n";
+	std::ostringstream os;
+	{
+		SourceTable sources;
+		SourceTable::Scope scope(sources);
+		BOOST_CHECK_EQUAL(&SourceTable::instance(), &sources);
+
+		// numbers go past several chunks and past the packed range
+		uint32 count = SourceInfoContext::max_file + 100;
+		for(uint32 i = 0; i < count; ++i)
+		{
+			std::ostringstream name;
+			name << "file" << i << ".t";
+			shared_ptr<SourceLineTable> table(new SourceLineTable(name.str(), s.data(), s.data() + s.size()));
+			BOOST_REQUIRE_EQUAL(sources.add(table), i);
+		}
+		BOOST_CHECK_EQUAL(sources.size(), count);
+		BOOST_CHECK(sources.get(count) == NULL);
+		for(uint32 i = 0; i < count; i += 97)
+		{
+			std::ostringstream name;
+			name << "file" << i << ".t";
+			BOOST_REQUIRE_EQUAL(sources.get(i)->filename, name.str());
+		}
+
+		// a file which can't be packed is located right away
+		SourceInfoContext unnumbered = SourceInfoContext::at(count - 1, 11);
+		BOOST_CHECK(!unnumbered.isPacked());
+		BOOST_CHECK_EQUAL(unnumbered.line(), 2);
+		BOOST_CHECK_EQUAL(unnumbered.column(), 2);
+
+		boost::archive::text_oarchive oa(os);
+		SourceInfoContext* location = new SourceInfoContext(SourceInfoContext::at(5, 11));
+		oa << location;
+	}
+
+	// another compilation numbers its files on its own, and loads locations into its own table
+	SourceTable sources;
+	SourceTable::Scope scope(sources);
+	BOOST_CHECK_EQUAL(sources.size(), 0);
+
+	std::istringstream is(os.str());
+	boost::archive::text_iarchive ia(is);
+	SourceInfoContext* location = NULL;
+	ia >> location;
+	BOOST_CHECK_EQUAL(location->file(), 0);
+	BOOST_CHECK_EQUAL(sources.get(0)->filename, "file5.t");
+	BOOST_CHECK_EQUAL(location->line(), 2);
+	BOOST_CHECK_EQUAL(location->column(), 2);
+
+	// new content of the file takes the place of the previous one, under the same number
+	std::string edited = "import a;\n\nfunction f():void { }\n";
+	shared_ptr<SourceLineTable> table(new SourceLineTable("file5.t", edited.data(), edited.data() + edited.size()));
+	sources.replace(0, table);
+	BOOST_CHECK_EQUAL(sources.size(), 1);
+	BOOST_CHECK_EQUAL(location->line(), 3);
+	BOOST_CHECK_EQUAL(location->column(), 1);
+
+	shared_ptr<SourceLineTable> again(new SourceLineTable("file5.t", edited.data(), edited.data() + edited.size()));
+	BOOST_CHECK_EQUAL(sources.add(again), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,145 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNode.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/tree/visitor/GenericDoubleVisitor.h"
+#include "language/tree/visitor/StaticVisitor.h"
+#include "language/tree/visitor/NodeInfoVisitor.h"
+#include "language/tree/visitor/ObjectCountVisitor.h"
+#include "../ASTNodeSamples.h"
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_StaticVisitorTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language::tree;
+using namespace zillians::language::tree::visitor;
+
+namespace {
+
+struct StaticObjectCountVisitor : StaticDoubleVisitor<StaticObjectCountVisitor>
+{
+	StaticObjectCountVisitor() : total_count(0L)
+	{ }
+
+	void apply(ASTNode& node)
+	{
+		++total_count;
+		revisit(node);
+	}
+
+	std::size_t total_count;
+};
+
+struct StaticIdentifierCountVisitor : StaticDoubleVisitor<StaticIdentifierCountVisitor>
+{
+	StaticIdentifierCountVisitor() : identifier_count(0L)
+	{ }
+
+	void apply(ASTNode& node)
+	{
+		revisit(node);
+	}
+
+	void apply(Identifier& node)
+	{
+		++identifier_count;
+		revisit(node);
+	}
+
+	std::size_t identifier_count;
+};
+
+struct StaticBlockCountVisitor : StaticDoubleVisitor<StaticBlockCountVisitor>
+{
+	StaticBlockCountVisitor() : block_count(0L)
+	{ }
+
+	void apply(ASTNode& node)
+	{
+		revisit(node);
+	}
+
+	void apply(Block& node)
+	{
+		++block_count;
+		revisit(node);
+	}
+
+	std::size_t block_count;
+};
+
+// switch(x) { case c: y; default: d; }
+SwitchStmt* createSwitch()
+{
+	Block* case_block = new Block();
+	case_block->appendObject(new ExpressionStmt(new PrimaryExpr(new SimpleIdentifier(L"y"))));
+
+	Block* default_block = new Block();
+	default_block->appendObject(new ExpressionStmt(new PrimaryExpr(new SimpleIdentifier(L"d"))));
+
+	SwitchStmt* node = new SwitchStmt(new PrimaryExpr(new SimpleIdentifier(L"x")));
+	node->addCase(Selection(new PrimaryExpr(new SimpleIdentifier(L"c")), case_block));
+	node->setDefaultCase(default_block);
+	return node;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_StaticVisitorTestSuite )
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_StaticVisitorTestCase1 )
+{
+	// both backends must walk exactly the same nodes
+	ASTNode* samples[] = { createSample1(), createSample2(), createSample3(), createSample4(), createSample5(), createSwitch() };
+	for(std::size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i)
+	{
+		ObjectCountVisitor<> runtime_counter;
+		runtime_counter.visit(*samples[i]);
+
+		StaticObjectCountVisitor static_counter;
+		static_counter.visit(*samples[i]);
+
+		BOOST_CHECK_EQUAL(runtime_counter.get_count(), static_counter.total_count);
+	}
+
+	// overloads are picked by the dynamic type, falling back to base classes
+	NestedIdentifier* id = new NestedIdentifier();
+	id->appendIdentifier(new SimpleIdentifier(L"a"));
+	id->appendIdentifier(new SimpleIdentifier(L"b"));
+
+	StaticIdentifierCountVisitor identifier_counter;
+	identifier_counter.visit(*new PrimaryExpr(id));
+	BOOST_CHECK_EQUAL(identifier_counter.identifier_count, 3);
+
+	// including the default block of a switch
+	StaticIdentifierCountVisitor switch_counter;
+	switch_counter.visit(*createSwitch());
+	BOOST_CHECK_EQUAL(switch_counter.identifier_count, 4);
+
+	// the objects of the default block are visited, but not the block itself
+	StaticBlockCountVisitor block_counter;
+	block_counter.visit(*createSwitch());
+	BOOST_CHECK_EQUAL(block_counter.block_count, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
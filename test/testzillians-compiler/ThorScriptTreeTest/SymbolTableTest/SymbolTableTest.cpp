@@ -0,0 +1,128 @@
+/**
+ * Zillians MMO
+ * Copyright (C) 2007-2010 Zillians.com, Inc.
+ * For more information see http://www.zillians.com
+ *
+ * Zillians MMO is the library and runtime for massive multiplayer online game
+ * development in utility computing model, which runs as a service for every
+ * developer to build their virtual world running on our GPU-assisted machines.
+ *
+ * This is a close source library intended to be used solely within Zillians.com
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "core/Prerequisite.h"
+#include "language/tree/ASTNodeFactory.h"
+#include "language/tree/SymbolTable.h"
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE ThorScriptTreeTest_SymbolTableTest
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+using namespace zillians;
+using namespace zillians::language::tree;
+
+BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_SymbolTableTestSuite )
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SymbolTableTestCase1 )
+{
+	Symbol a(L"hello");
+	Symbol b(std::wstring(L"hello"));
+	Symbol c(L"world");
+
+	BOOST_CHECK(a == b);
+	BOOST_CHECK(a != c);
+	BOOST_CHECK_EQUAL(a.id(), b.id());
+	BOOST_CHECK_EQUAL(a.hash(), b.hash());
+	BOOST_CHECK(a < c);
+	BOOST_CHECK(a == L"hello");
+	BOOST_CHECK(Symbol().empty());
+	BOOST_CHECK(Symbol() == Symbol(L""));
+
+	// symbols are written as plain strings and interned again when read back
+	std::stringstream ss;
+	{
+		boost::archive::text_oarchive oa(ss);
+		oa << a;
+	}
+
+	Symbol loaded;
+	{
+		boost::archive::text_iarchive ia(ss);
+		ia >> loaded;
+	}
+	BOOST_CHECK(loaded == a);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SymbolTableTestCase2 )
+{
+	SimpleIdentifier* a = new SimpleIdentifier(L"a");
+	SimpleIdentifier* ab = new SimpleIdentifier(L"ab");
+
+	NestedIdentifier* a_b = new NestedIdentifier();
+	a_b->appendIdentifier(new SimpleIdentifier(L"a"));
+	a_b->appendIdentifier(new SimpleIdentifier(L"b"));
+
+	NestedIdentifier* a_b2 = new NestedIdentifier();
+	a_b2->appendIdentifier(new SimpleIdentifier(L"a"));
+	a_b2->appendIdentifier(new SimpleIdentifier(L"b"));
+
+	// same order as comparing toString()
+	BOOST_CHECK(Identifier::compareName(*a, *a_b) < 0);
+	BOOST_CHECK(Identifier::compareName(*a_b, *ab) < 0);
+	BOOST_CHECK(Identifier::compareName(*ab, *a) > 0);
+	BOOST_CHECK(a_b->hasSameName(*a_b2));
+	BOOST_CHECK(!a_b->hasSameName(*a));
+
+	// identical names share one interned symbol
+	BOOST_CHECK(cast<SimpleIdentifier>(a_b->identifier_list[0])->name == a->name);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_SymbolTableTestCase3 )
+{
+	// threads interning overlapping names get the very same entries, each name is added once
+	const int thread_count = 8;
+	const int name_count = 2000;
+	std::size_t size_before = SymbolTable::instance().size();
+
+	std::vector<std::vector<const SymbolTable::Entry*>> interned(thread_count);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < thread_count; ++t)
+	{
+		threads.push_back(std::thread([&, t]() {
+			for(int i = 0; i < name_count; ++i)
+			{
+				std::wostringstream name;
+				name << L"concurrent_" << ((i * (t + 1)) % name_count);
+				interned[t].push_back(SymbolTable::instance().intern(name.str()));
+			}
+		}));
+	}
+	for(int t = 0; t < thread_count; ++t)
+		threads[t].join();
+
+	BOOST_CHECK_EQUAL(SymbolTable::instance().size(), size_before + name_count);
+	for(int t = 0; t < thread_count; ++t)
+	{
+		for(int i = 0; i < name_count; ++i)
+		{
+			std::wostringstream name;
+			name << L"concurrent_" << ((i * (t + 1)) % name_count);
+			BOOST_REQUIRE(interned[t][i] == SymbolTable::instance().intern(name.str()));
+			BOOST_REQUIRE(*interned[t][i]->name == name.str());
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -30,6 +30,7 @@
 #include <iostream>
 #include <string>
 #include <limits>
+#include <vector>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
@@ -42,6 +43,50 @@ using namespace zillians::language::tree;
 using namespace zillians::language::tree::visitor;
 using namespace zillians::language::stage;
 
+namespace {
+
+// a class template like body: n member functions of m statements like "a = b + c;"
+ClassDecl* createLargeClass(std::size_t n, std::size_t m)
+{
+	ClassDecl* class_decl = new ClassDecl(new SimpleIdentifier(L"some_class"));
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		FunctionDecl* function = new FunctionDecl(
+				new SimpleIdentifier(L"f"),
+				new TypeSpecifier(PrimitiveType::VOID_TYPE),
+				true,
+				false,
+				Declaration::VisibilitySpecifier::PUBLIC,
+				new Block());
+		class_decl->addFunction(function);
+
+		for(std::size_t j = 0; j < m; ++j)
+		{
+			BinaryExpr* add = new BinaryExpr(BinaryExpr::OpCode::ARITHMETIC_ADD, new PrimaryExpr(new SimpleIdentifier(L"b")), new PrimaryExpr(new SimpleIdentifier(L"c")));
+			BinaryExpr* assign = new BinaryExpr(BinaryExpr::OpCode::ASSIGN, new PrimaryExpr(new SimpleIdentifier(L"a")), add);
+			function->block->appendObject(new ExpressionStmt(assign));
+		}
+	}
+
+	uint32 line = 0;
+	ASTNodeHelper::foreachApply<ASTNode>(*class_decl, [&line](ASTNode& node) {
+		SourceInfoContext::set(&node, SourceInfoContext(++line, 1));
+	});
+
+	return class_decl;
+}
+
+std::vector<ASTNode*> collectNodes(ASTNode* root)
+{
+	std::vector<ASTNode*> nodes;
+	ASTNodeHelper::foreachApply<ASTNode>(*root, [&nodes](ASTNode& node) {
+		nodes.push_back(&node);
+	});
+	return nodes;
+}
+
+}
+
 BOOST_AUTO_TEST_SUITE( ThorScriptTreeTest_TreeCloneTestSuite )
 
 BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_TreeCloneTestCase1 )
@@ -49,24 +94,24 @@ BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_TreeCloneTestCase1 )
 	SimpleIdentifier* original_id = new SimpleIdentifier(L"hello");
 
 	SourceInfoContext* original_src_ctx = new SourceInfoContext(123, 456);
-	original_id->set<SourceInfoContext>(original_src_ctx);
+	SourceInfoContext::set(original_id, original_src_ctx);
 
 	NameManglingContext* original_name_ctx = new NameManglingContext("hello");
-	original_id->set<NameManglingContext>(original_name_ctx);
+	NameManglingContext::set(original_id, original_name_ctx);
 
 	SimpleIdentifier* cloned_id = cast<SimpleIdentifier>(ASTNodeHelper::clone(original_id));
 
 	BOOST_CHECK(cloned_id != NULL);
 
-	SourceInfoContext* cloned_src_ctx = cloned_id->get<SourceInfoContext>();
-	NameManglingContext* cloned_name_ctx = cloned_id->get<NameManglingContext>();
+	SourceInfoContext* cloned_src_ctx = SourceInfoContext::get(cloned_id);
+	NameManglingContext* cloned_name_ctx = NameManglingContext::get(cloned_id);
 
 	BOOST_CHECK(cloned_src_ctx != NULL);
 
 	if(cloned_src_ctx)
 	{
-		BOOST_CHECK(cloned_src_ctx->line == original_src_ctx->line);
-		BOOST_CHECK(cloned_src_ctx->column == original_src_ctx->column);
+		BOOST_CHECK(cloned_src_ctx->line() == original_src_ctx->line());
+		BOOST_CHECK(cloned_src_ctx->column() == original_src_ctx->column());
 	}
 
 	BOOST_CHECK(cloned_name_ctx != NULL);
@@ -83,17 +128,17 @@ BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_TreeCloneTestCaseRecursive )
     // simple id 1
 	SimpleIdentifier* original_sid1 = new SimpleIdentifier(L"a");
 	SourceInfoContext* original_src_ctx_s1 = new SourceInfoContext(123, 456);
-	original_sid1->set<SourceInfoContext>(original_src_ctx_s1);
+	SourceInfoContext::set(original_sid1, original_src_ctx_s1);
 
     // simple id 2
 	SimpleIdentifier* original_sid2 = new SimpleIdentifier(L"b");
 	SourceInfoContext* original_src_ctx_s2 = new SourceInfoContext(123, 458);
-	original_sid2->set<SourceInfoContext>(original_src_ctx_s2);
+	SourceInfoContext::set(original_sid2, original_src_ctx_s2);
 
     // nested id
     NestedIdentifier* original_nid = new NestedIdentifier();
 	SourceInfoContext* original_src_ctx_n  = new SourceInfoContext(123, 454);
-	original_nid->set<SourceInfoContext>(original_src_ctx_n);
+	SourceInfoContext::set(original_nid, original_src_ctx_n);
     original_nid->appendIdentifier(original_sid1);
     original_nid->appendIdentifier(original_sid2);
 	NameManglingContext* original_name_ctx_n = new NameManglingContext("_ZN1a1bE");
@@ -104,17 +149,56 @@ BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_TreeCloneTestCaseRecursive )
 	BOOST_CHECK(cloned_nid != NULL);
 
     // check nested id context
-	SourceInfoContext* cloned_src_ctx_n = cloned_nid->get<SourceInfoContext>();
-	NameManglingContext* cloned_name_ctx = cloned_nid->get<NameManglingContext>();
-    BOOST_CHECK_EQUAL(cloned_src_ctx_n->line        , original_src_ctx_n->line);
-    BOOST_CHECK_EQUAL(cloned_src_ctx_n->column      , original_src_ctx_n->column);
+	SourceInfoContext* cloned_src_ctx_n = SourceInfoContext::get(cloned_nid);
+	NameManglingContext* cloned_name_ctx = NameManglingContext::get(cloned_nid);
+    BOOST_CHECK_EQUAL(cloned_src_ctx_n->line()        , original_src_ctx_n->line());
+    BOOST_CHECK_EQUAL(cloned_src_ctx_n->column()      , original_src_ctx_n->column());
     BOOST_CHECK_EQUAL(cloned_name_ctx->managled_name, original_name_ctx_n->managled_name);
 
     // check simple id context
-    BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nid->identifier_list[0])->line  , SourceInfoContext::get(original_sid1)->line);
-    BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nid->identifier_list[0])->column, SourceInfoContext::get(original_sid1)->column);
-    BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nid->identifier_list[1])->line  , SourceInfoContext::get(original_sid2)->line);
-    BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nid->identifier_list[1])->column, SourceInfoContext::get(original_sid2)->column);
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nid->identifier_list[0])->line()  , SourceInfoContext::get(original_sid1)->line());
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nid->identifier_list[0])->column(), SourceInfoContext::get(original_sid1)->column());
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nid->identifier_list[1])->line()  , SourceInfoContext::get(original_sid2)->line());
+    BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nid->identifier_list[1])->column(), SourceInfoContext::get(original_sid2)->column());
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_TreeCloneTestCaseLarge )
+{
+	const std::size_t function_count = 200;
+	const std::size_t statement_count = 50;
+
+	ClassDecl* original = createLargeClass(function_count, statement_count);
+	std::vector<ASTNode*> original_nodes = collectNodes(original);
+
+	// every node of the clone must carry the source info of its original node
+	ASTNode* cloned = ASTNodeHelper::clone(original);
+	std::vector<ASTNode*> cloned_nodes = collectNodes(cloned);
+	BOOST_REQUIRE_EQUAL(cloned_nodes.size(), original_nodes.size());
+	for(std::size_t i = 0; i < cloned_nodes.size(); ++i)
+	{
+		BOOST_REQUIRE(SourceInfoContext::get(cloned_nodes[i]) != NULL);
+		BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned_nodes[i])->line(), SourceInfoContext::get(original_nodes[i])->line());
+	}
+
+	// only the root gets its contexts copied without RecursiveClone
+	ASTNode* shallow = ASTNodeHelper::clone<zillians::language::tree::detail::ContextToCloneTypeList, false>(original);
+	BOOST_CHECK(SourceInfoContext::get(shallow) != NULL);
+	BOOST_CHECK(SourceInfoContext::get(cast<ClassDecl>(shallow)->name) == NULL);
+}
+
+BOOST_AUTO_TEST_CASE( ThorScriptTreeTest_TreeCloneTestCaseOtherArena )
+{
+	ClassDecl* original = createLargeClass(2, 2);
+
+	// the contexts live in the arena of the original, even if the active one has none at all
+	ASTNodeGC arena;
+	ASTNodeGC::Scope scope(arena);
+
+	ASTNode* cloned = ASTNodeHelper::clone(original);
+	BOOST_CHECK(ASTNodeGC::ownerOf(cloned) == &arena);
+	BOOST_REQUIRE(SourceInfoContext::get(cloned) != NULL);
+	BOOST_CHECK_EQUAL(SourceInfoContext::get(cloned)->line(), SourceInfoContext::get(original)->line());
+	BOOST_CHECK(SourceInfoContext::get(cast<ClassDecl>(cloned)->name) != NULL);
 }
 
 BOOST_AUTO_TEST_SUITE_END()